@@ -29,6 +29,14 @@ namespace ndata {
     template<typename T, long ndims>
     struct nvector;
 
+    //tag for the constructors leaving the data uninitialized
+    struct UNINITIALIZED_T { };
+    constexpr UNINITIALIZED_T UNINITIALIZED = UNINITIALIZED_T();
+
+    //lazy elementwise expression on ndatacontainers
+    template <typename FuncT, typename LeavesT>
+    struct nexpr;
+
 }
 
 #include "ndata/forward_declarations.hpp"
@@ -37,6 +45,8 @@ namespace ndata {
 #include "ndata/ndatacontainer.hpp"
 #include "ndata/nvector.hpp"
 #include "ndata/loops.hpp"
+#include "ndata/loop_plan.hpp"
+#include "ndata/nexpr.hpp"
 
 
 #endif /* end of include guard: NDATA_HPP_VFUXJBDN */ 
@@ -0,0 +1,298 @@
+/*! \file Contains concat_view, several ndatacontainers seen as a single array concatenated along an axis,
+ *  without copying them */
+#ifndef CONCAT_VIEW_HPP_H5NW3RBE
+#define CONCAT_VIEW_HPP_H5NW3RBE
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/flat_walk.hpp"
+
+namespace ndata {
+
+/**
+ * @brief View of parts, ndataviews with the same shape except along axis, as the array of their
+ *  concatenation along axis (see concatenate), without copying them. The parts must outlive the view.
+ *
+ * Element access looks up the part holding the index along axis. Loops go part by part instead, see
+ * nforeach_concat: within a part the operands are plain strided views and nforeach runs its usual loops.
+ *
+ * auto year = make_concat_view(days, 0); //days: std::vector<ndataview<float, 3>>, (24, ny, nx) each
+ * nforeach_concat(parallel_policy(), std::tie(year, celsius), [] (float k, float & c) {c = k-273.15f;});
+ */
+template <typename T, long ndims>
+struct concat_view {
+    static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+    concat_view(std::vector<ndataview<T, ndims>> parts, size_t axis):
+        parts_(std::move(parts)),
+        axis_(axis),
+        offsets_(1, 0l)
+    {
+        assert(axis < size_t(ndims));
+        if (parts_.empty()) {
+            throw std::domain_error("concat_view: no parts");
+        }
+
+        shape_ = parts_[0].get_shape();
+        for (auto & part: parts_) {
+            auto shape = part.get_shape();
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                if (i != axis and shape[i] != shape_[i]) {
+                    throw std::domain_error("concat_view: the shapes must match except along the axis");
+                }
+            }
+            offsets_.push_back(offsets_.back()+shape[axis]);
+        }
+        shape_[axis] = offsets_.back();
+    }
+
+    vecarray<long, ndims>
+    get_shape() {
+        return shape_;
+    }
+
+    size_t
+    size() {
+        size_t ret = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            ret *= size_t(shape_[i]);
+        }
+        return ret;
+    }
+
+    size_t
+    axis() const {
+        return axis_;
+    }
+
+    size_t
+    nparts() const {
+        return parts_.size();
+    }
+
+    ndataview<T, ndims>
+    part(size_t ipart) {
+        return parts_[ipart];
+    }
+
+    /**
+     * @brief Index along axis of the first element of each part, followed by the size along axis.
+     */
+    std::vector<long> const &
+    offsets() const {
+        return offsets_;
+    }
+
+    /**
+     * @brief Index of the part holding index i along axis.
+     */
+    size_t
+    part_index(long i) const {
+        assert(i >= 0 and i < offsets_.back());
+        return size_t(std::upper_bound(offsets_.begin(), offsets_.end(), i)-offsets_.begin())-1;
+    }
+
+    T &
+    at(vecarray<long, ndims> ndindex) {
+        size_t ipart = part_index(ndindex[axis_]);
+        ndindex[axis_] -= offsets_[ipart];
+        return parts_[ipart].data_[parts_[ipart].index(ndindex)];
+    }
+
+    template <typename ... Long>
+    T &
+    operator()(Long ... indices) {
+        static_assert(sizeof...(Long) == size_t(ndims), "one index per dimension");
+        return at(vecarray<long, ndims>({long(indices)...}));
+    }
+
+    /**
+     * @brief The elements [begin, end) along axis, which must be inside a single part, as an ndataview.
+     */
+    ndataview<T, ndims>
+    segment(long begin, long end) {
+        size_t ipart = part_index(begin);
+        assert(end <= offsets_[ipart+1]);
+        ndataview<T, ndims> & p = parts_[ipart];
+        auto shape = p.get_shape();
+        auto strides = p.get_strides();
+        shape[axis_] = end-begin;
+        return ndataview<T, ndims>(
+                    indexer<ndims>(p.get_start_index()+size_t((begin-offsets_[ipart])*strides[axis_]), shape, strides),
+                    p.data_
+                    );
+    }
+
+    /**
+     * @brief The elements [begin, end) along axis, itself a concat_view of the parts it overlaps.
+     */
+    concat_view
+    window(long begin, long end) {
+        assert(begin >= 0 and begin < end and end <= offsets_.back());
+        std::vector<ndataview<T, ndims>> parts;
+        for (size_t ipart = part_index(begin); ipart < parts_.size() and offsets_[ipart] < end; ++ipart) {
+            parts.push_back(segment(std::max(begin, offsets_[ipart]), std::min(end, offsets_[ipart+1])));
+        }
+        return concat_view(parts, axis_);
+    }
+
+    /**
+     * @brief Copies the elements of the view to out, of the same shape, see concatenate.
+     */
+    template <typename PolicyT, typename ContainerT>
+    void
+    copy_to(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & out) {
+        concatenate(policy, parts_, axis_, out);
+    }
+
+    template <typename ContainerT>
+    void
+    copy_to(ndatacontainer<ContainerT, T, ndims> & out) {
+        copy_to(serial_policy(), out);
+    }
+
+private:
+
+    std::vector<ndataview<T, ndims>> parts_;
+
+    size_t axis_;
+
+    //offsets_[i]: index along axis of the first element of part i, offsets_.back(): size along axis
+    std::vector<long> offsets_;
+
+    vecarray<long, ndims> shape_;
+};
+
+/**
+ * @brief View of the containers of a tuple, like std::tie(a, b, c), concatenated along axis.
+ */
+template <typename ... Ndatacontainer>
+auto
+make_concat_view(std::tuple<Ndatacontainer&...> parts, size_t axis) {
+    auto views = helpers::piece_views(parts);
+    return concat_view<typename decltype(views)::value_type::type_T, decltype(views[0].get_shape())::STATIC_SIZE_OR_DYNAMIC>(views, axis);
+}
+
+template <typename T, long ndims>
+concat_view<T, ndims>
+make_concat_view(std::vector<ndataview<T, ndims>> parts, size_t axis) {
+    return concat_view<T, ndims>(parts, axis);
+}
+
+namespace helpers {
+
+    /**
+     * The operands of nforeach_concat: a concat_view is kept as is and cut in segments, a container is
+     * broadcasted to the shape of the concat_views and cut along their axis like them.
+     */
+    template <typename T, long ndims, long ndims_cv>
+    concat_view<T, ndims> *
+    concat_operand(concat_view<T, ndims> & cv, vecarray<long, ndims_cv> shape, size_t axis) {
+        static_assert(ndims == ndims_cv, "the concat_views must have the same number of dimensions");
+        auto cv_shape = cv.get_shape();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            if (cv_shape[i] != shape[i]) {
+                throw std::domain_error("nforeach_concat: the concat_views must have the same shape");
+            }
+        }
+        if (cv.axis() != axis) {
+            throw std::domain_error("nforeach_concat: the concat_views must be concatenated along the same axis");
+        }
+        return &cv;
+    }
+
+    template <typename ContainerT, typename T, long ndims, long ndims_cv>
+    ndataview<T, ndims_cv>
+    concat_operand(ndatacontainer<ContainerT, T, ndims> & u, vecarray<long, ndims_cv> shape, size_t) {
+        return std::get<0>(broadcast_to_shape(indexer<ndims_cv>(shape), std::tie(u)));
+    }
+
+    template <typename T, long ndims>
+    void
+    add_boundaries(concat_view<T, ndims> * cv, std::vector<long> & boundaries) {
+        boundaries.insert(boundaries.end(), cv->offsets().begin(), cv->offsets().end());
+    }
+
+    template <typename T, long ndims>
+    void
+    add_boundaries(ndataview<T, ndims>, std::vector<long> &) {
+    }
+
+    template <typename T, long ndims>
+    ndataview<T, ndims>
+    segment_operand(concat_view<T, ndims> * cv, size_t, long begin, long end) {
+        return cv->segment(begin, end);
+    }
+
+    template <typename T, long ndims>
+    ndataview<T, ndims>
+    segment_operand(ndataview<T, ndims> v, size_t axis, long begin, long end) {
+        auto shape = v.get_shape();
+        auto strides = v.get_strides();
+        shape[axis] = end-begin;
+        return ndataview<T, ndims>(indexer<ndims>(v.get_start_index()+size_t(begin*strides[axis]), shape, strides), v.data_);
+    }
+
+    template <typename T, long ndims, typename ... Operands>
+    concat_view<T, ndims> &
+    first_concat_view(concat_view<T, ndims> & cv, Operands & ...) {
+        return cv;
+    }
+
+    template <typename ContainerT, typename T, long ndims, typename ... Operands>
+    auto &
+    first_concat_view(ndatacontainer<ContainerT, T, ndims> &, Operands & ... operands) {
+        static_assert(sizeof...(Operands) > 0, "nforeach_concat needs at least one concat_view");
+        return first_concat_view(operands...);
+    }
+
+    template <typename PolicyT, typename FuncT, typename ... Operands, size_t ... Is>
+    void
+    nforeach_concat(PolicyT const & policy, std::tuple<Operands&...> operands, FuncT & func, std::index_sequence<Is...>) {
+        auto & first = first_concat_view(std::get<Is>(operands)...);
+        const auto shape = first.get_shape();
+        const size_t axis = first.axis();
+
+        auto ops = std::make_tuple(concat_operand(std::get<Is>(operands), shape, axis)...);
+
+        std::vector<long> boundaries;
+        (void) std::initializer_list<int> {(add_boundaries(std::get<Is>(ops), boundaries), 0)...};
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+        for (size_t ib = 0; ib+1 < boundaries.size(); ++ib) {
+            const long begin = boundaries[ib];
+            const long end = boundaries[ib+1];
+            nforeach(policy, std::make_tuple(segment_operand(std::get<Is>(ops), axis, begin, end)...), func);
+        }
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief nforeach on operands among which concat_views, all with the same shape, and containers
+ *  broadcasted to their shape. The loops run segment by segment along the axis, the segments being cut at
+ *  the boundaries of the parts of all the concat_views: within a segment every operand is an ndataview and
+ *  nforeach(policy, ...) runs its usual loops on them.
+ */
+template <typename PolicyT, typename FuncT, typename ... Operands>
+typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+nforeach_concat(PolicyT const & policy, std::tuple<Operands&...> operands, FuncT func) {
+    helpers::nforeach_concat(policy, operands, func, std::index_sequence_for<Operands...>());
+}
+
+template <typename FuncT, typename ... Operands>
+void
+nforeach_concat(std::tuple<Operands&...> operands, FuncT func) {
+    nforeach_concat(serial_policy(), operands, func);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: CONCAT_VIEW_HPP_H5NW3RBE */
@@ -0,0 +1,200 @@
+/*! \file Contains flat_walk, a traversal of broadcasted views in the C order of their flat indices, for
+ *  the loops that must know the position of each element (masks, gathers and scatters) */
+#ifndef FLAT_WALK_HPP_R6KD2ZXM
+#define FLAT_WALK_HPP_R6KD2ZXM
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "ndata.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    /**
+     * @brief Shape and per-operand start indices and strides of views walked in the C order of their
+     *  flat indices, see for_each_c_segment.
+     */
+    template <size_t nops, long ndims, typename ... Ts>
+    struct flat_walk {
+        std::tuple<Ts*...> data;
+        std::array<long, size_t(ndims)> shape;
+        std::array<long, nops> starts;
+        std::array<std::array<long, nops>, size_t(ndims)> strides;
+    };
+
+    template <typename ... Ts, long ndims, size_t ... Is>
+    flat_walk<sizeof...(Ts), ndims, Ts...>
+    make_flat_walk(std::tuple<ndataview<Ts, ndims>...> views, std::index_sequence<Is...>) {
+        flat_walk<sizeof...(Ts), ndims, Ts...> w;
+        w.data = std::tuple<Ts*...>(std::get<Is>(views).data_...);
+        w.starts = {{long(std::get<Is>(views).get_start_index())...}};
+        auto shape = std::get<0>(views).get_shape();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            w.shape[i] = shape[i];
+            w.strides[i] = {{std::get<Is>(views).get_strides()[i]...}};
+        }
+        return w;
+    }
+
+    /**
+     * @brief Walk of views of the same shape.
+     */
+    template <typename ... Ts, long ndims>
+    flat_walk<sizeof...(Ts), ndims, Ts...>
+    make_flat_walk(std::tuple<ndataview<Ts, ndims>...> views) {
+        static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+        return make_flat_walk(views, std::index_sequence_for<Ts...>());
+    }
+
+    /**
+     * @brief Calls seg(flat, n, offsets) for the rows of the flat indices [begin, end) in C order: the
+     *  elements flat to flat+n-1 are along the last axis, at offsets[k]+j*strides[ndims-1][k] from the
+     *  data of operand k. The ndindex is only unravelled once, at begin.
+     */
+    template <size_t nops, long ndims, typename ... Ts, typename SegFuncT>
+    void
+    for_each_c_segment(flat_walk<nops, ndims, Ts...> const & w, long begin, long end, SegFuncT && seg) {
+        if (begin >= end) {
+            return;
+        }
+
+        std::array<long, size_t(ndims)> ndindex;
+        long rem = begin;
+        for (size_t i = size_t(ndims); i-- > 0; ) {
+            ndindex[i] = rem%w.shape[i];
+            rem /= w.shape[i];
+        }
+        std::array<long, nops> offsets = w.starts;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            for (size_t k = 0; k < nops; ++k) {
+                offsets[k] += ndindex[i]*w.strides[i][k];
+            }
+        }
+
+        const size_t last = size_t(ndims)-1;
+        long flat = begin;
+        while (true) {
+            const long n = std::min(w.shape[last]-ndindex[last], end-flat);
+            seg(flat, n, offsets);
+            flat += n;
+            if (flat >= end) {
+                return;
+            }
+
+            //next row
+            for (size_t k = 0; k < nops; ++k) {
+                offsets[k] -= ndindex[last]*w.strides[last][k];
+            }
+            ndindex[last] = 0;
+            for (size_t i = last; i-- > 0; ) {
+                ++ndindex[i];
+                for (size_t k = 0; k < nops; ++k) {
+                    offsets[k] += w.strides[i][k];
+                }
+                if (ndindex[i] < w.shape[i]) {
+                    break;
+                }
+                for (size_t k = 0; k < nops; ++k) {
+                    offsets[k] -= ndindex[i]*w.strides[i][k];
+                }
+                ndindex[i] = 0;
+            }
+        }
+    }
+
+    //func on the elements j of a segment starting at offsets
+    template <typename FuncT, typename ... Ts, size_t nops, size_t ... Is>
+    void
+    call_at(FuncT & func, std::tuple<Ts*...> const & data, std::array<long, nops> const & offsets, long j,
+            std::array<long, nops> const & inner_strides, std::index_sequence<Is...>)
+    {
+        func(std::get<Is>(data)[offsets[Is]+j*inner_strides[Is]]...);
+    }
+
+    /**
+     * @brief Split of a range of n units (elements, or words of a mask) in blocks for the threads. The
+     *  blocks are the same from one pass to the next, for the algorithms running several passes.
+     */
+    struct flat_blocks {
+        long n;
+        long nblocks;
+        long nthreads;
+
+        long
+        begin(long iblock) const {
+            return n*iblock/nblocks;
+        }
+    };
+
+    inline
+    flat_blocks
+    make_flat_blocks(serial_policy const &, long n, long) {
+        return flat_blocks{n, 1, 1};
+    }
+
+    /**
+     * @param nelements the number of elements in the n units, compared to the min_work and chunk_size of
+     *  the policy
+     */
+    inline
+    flat_blocks
+    make_flat_blocks(parallel_policy const & policy, long n, long nelements) {
+        const long nthreads = parallel_num_threads(policy);
+        if (nelements < policy.min_work or nthreads <= 1) {
+            return flat_blocks{n, 1, 1};
+        }
+        long nb = (policy.chunk_size > 0)? nelements/policy.chunk_size : nthreads*REDUCE_BLOCKS_PER_THREAD;
+        return flat_blocks{n, std::max(1l, std::min(n, nb)), nthreads};
+    }
+
+    //calls func(begin, end, iblock) for each block
+    template <typename FuncT>
+    void
+    run_flat_blocks(serial_policy const &, flat_blocks const & blocks, FuncT func) {
+        for (long ib = 0; ib < blocks.nblocks; ++ib) {
+            func(blocks.begin(ib), blocks.begin(ib+1), ib);
+        }
+    }
+
+    template <typename FuncT>
+    void
+    run_flat_blocks(parallel_policy const & policy, flat_blocks const & blocks, FuncT func) {
+        parallel_blocks(policy, blocks.nthreads, blocks.nblocks, [&] (long iblock_begin, long iblock_end) {
+            for (long ib = iblock_begin; ib < iblock_end; ++ib) {
+                func(blocks.begin(ib), blocks.begin(ib+1), ib);
+            }
+        });
+    }
+
+    /**
+     * @brief Views of the containers broadcasted to the shape of target, throws if they don't broadcast
+     *  to exactly that shape.
+     */
+    template <long ndims, typename ... Ndatacontainer>
+    auto
+    broadcast_to_shape(indexer<ndims> target, std::tuple<Ndatacontainer&...> ndata_tup_refs) {
+        return tuple_utilities::tuple_transform(
+                    [&] (auto & u) {
+                        auto v = broadcast_left(u.as_view(), std::make_tuple(target));
+                        static_assert(decltype(v.get_shape())::STATIC_SIZE_OR_DYNAMIC == ndims, "the operands can't have more dimensions than the target");
+                        auto shape = v.get_shape();
+                        for (size_t i = 0; i < size_t(ndims); ++i) {
+                            if (shape[i] != target.get_shape()[i]) {
+                                throw std::domain_error("The operands don't broadcast to the target shape");
+                            }
+                        }
+                        return v;
+                    },
+                    ndata_tup_refs
+                    );
+    }
+
+} //end namespace helpers
+
+} //end namespace ndata
+
+#endif /* end of include guard: FLAT_WALK_HPP_R6KD2ZXM */
@@ -0,0 +1,470 @@
+/*! \file Contains the gathers and scatters of elements at positions given by index arrays (numpy's fancy
+ *  indexing): take, take_along_axis, put and scatter_add */
+#ifndef GATHER_HPP_J3VB8QYN
+#define GATHER_HPP_J3VB8QYN
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/flat_walk.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    //number of source offsets computed, and prefetched, before the elements are read
+    constexpr long GATHER_BATCH = 64;
+
+    inline
+    void
+    prefetch_read(void const * p) {
+#if defined(__GNUC__)
+        __builtin_prefetch(p);
+#else
+        (void) p;
+#endif
+    }
+
+    /**
+     * @brief Offset in the indexed array of element j of a segment of a gather or scatter walk, whose
+     *  operands are (out or values, base, indices...): base has zero strides along the indexed axes and
+     *  the indices are multiplied by the strides of these axes.
+     */
+    template <size_t nops, long ndims, typename T0, typename T1, typename ... Tidx, size_t ... Is>
+    long
+    indexed_offset(
+            flat_walk<nops, ndims, T0, T1, Tidx...> const & w,
+            std::array<long, nops> const & offsets,
+            long j,
+            std::array<long, sizeof...(Tidx)> const & indexed_shape,
+            std::array<long, sizeof...(Tidx)> const & indexed_strides,
+            std::index_sequence<Is...>)
+    {
+        auto const & inner_strides = w.strides[size_t(ndims)-1];
+        const long idx[] = {long(std::get<2+Is>(w.data)[offsets[2+Is]+j*inner_strides[2+Is]])...};
+        long ret = offsets[1]+j*inner_strides[1];
+        for (size_t k = 0; k < sizeof...(Tidx); ++k) {
+            assert(idx[k] >= 0 and idx[k] < indexed_shape[k]);
+            ret += idx[k]*indexed_strides[k];
+        }
+        (void) indexed_shape;
+        return ret;
+    }
+
+    /**
+     * @brief out = src[base+indices...] over the points of out, see indexed_offset. The offsets of a
+     *  batch of points are computed first and their elements prefetched, so that the random reads of the
+     *  batch overlap instead of waiting for each other.
+     */
+    template <typename PolicyT, typename T, long ndims, typename ... Tidx>
+    void
+    gather(
+            PolicyT const & policy,
+            ndataview<T, ndims> out,
+            ndataview<T, ndims> base,
+            std::tuple<ndataview<Tidx, ndims>...> indices,
+            std::array<long, sizeof...(Tidx)> indexed_shape,
+            std::array<long, sizeof...(Tidx)> indexed_strides)
+    {
+        constexpr size_t nops = 2+sizeof...(Tidx);
+        const auto w = make_flat_walk(std::tuple_cat(std::make_tuple(out, base), indices));
+        const long size = long(out.size());
+
+        run_flat_blocks(policy, make_flat_blocks(policy, size, size), [&] (long begin, long end, long) {
+            for_each_c_segment(w, begin, end, [&] (long, long n, std::array<long, nops> const & offsets) {
+                T * o = std::get<0>(w.data)+offsets[0];
+                T const * src = std::get<1>(w.data);
+                const long out_stride = w.strides[size_t(ndims)-1][0];
+
+                long batch[GATHER_BATCH];
+                for (long j0 = 0; j0 < n; j0 += GATHER_BATCH) {
+                    const long nb = std::min(GATHER_BATCH, n-j0);
+                    for (long j = 0; j < nb; ++j) {
+                        batch[j] = indexed_offset(w, offsets, j0+j, indexed_shape, indexed_strides, std::index_sequence_for<Tidx...>());
+                        prefetch_read(src+batch[j]);
+                    }
+                    for (long j = 0; j < nb; ++j) {
+                        o[(j0+j)*out_stride] = src[batch[j]];
+                    }
+                }
+            });
+        });
+    }
+
+    template <typename T, long ndims, typename Tv, typename ... Tidx, typename OpT>
+    void
+    scatter_serial(
+            flat_walk<2+sizeof...(Tidx), ndims, Tv, T, Tidx...> const & w,
+            long size,
+            std::array<long, sizeof...(Tidx)> const & indexed_shape,
+            std::array<long, sizeof...(Tidx)> const & indexed_strides,
+            OpT & op)
+    {
+        constexpr size_t nops = 2+sizeof...(Tidx);
+        for_each_c_segment(w, 0, size, [&] (long, long n, std::array<long, nops> const & offsets) {
+            Tv const * vals = std::get<0>(w.data)+offsets[0];
+            T * dst = std::get<1>(w.data);
+            const long vals_stride = w.strides[size_t(ndims)-1][0];
+            for (long j = 0; j < n; ++j) {
+                op(dst[indexed_offset(w, offsets, j, indexed_shape, indexed_strides, std::index_sequence_for<Tidx...>())], vals[j*vals_stride]);
+            }
+        });
+    }
+
+    /**
+     * @brief op(dst[base+indices...], val) over the points of values, see indexed_offset. The points
+     *  are applied in C order, the last one wins with an assignment.
+     */
+    template <typename T, long ndims, typename Tv, typename ... Tidx, typename OpT>
+    void
+    scatter(
+            serial_policy const &,
+            ndataview<Tv, ndims> values,
+            ndataview<T, ndims> base,
+            std::tuple<ndataview<Tidx, ndims>...> indices,
+            std::array<long, sizeof...(Tidx)> indexed_shape,
+            std::array<long, sizeof...(Tidx)> indexed_strides,
+            long, //lowest offset of the indexed array
+            long, //highest
+            OpT & op)
+    {
+        const auto w = make_flat_walk(std::tuple_cat(std::make_tuple(values, base), indices));
+        scatter_serial(w, long(values.size()), indexed_shape, indexed_strides, op);
+    }
+
+    /**
+     * In parallel, two points with the same destination must not be applied by different threads. The
+     * range of offsets of the indexed array is cut in as many partitions as blocks of points: a first pass
+     * counts the points of each block falling in each partition, their prefix sum (partition major) gives
+     * where a second pass sorts the offsets and values by partition, then each partition is applied by a
+     * single thread. The sort is stable, the points of an element are applied in C order like serially.
+     */
+    template <typename T, long ndims, typename Tv, typename ... Tidx, typename OpT>
+    void
+    scatter(
+            parallel_policy const & policy,
+            ndataview<Tv, ndims> values,
+            ndataview<T, ndims> base,
+            std::tuple<ndataview<Tidx, ndims>...> indices,
+            std::array<long, sizeof...(Tidx)> indexed_shape,
+            std::array<long, sizeof...(Tidx)> indexed_strides,
+            long lowest,
+            long highest,
+            OpT & op)
+    {
+        constexpr size_t nops = 2+sizeof...(Tidx);
+        const auto w = make_flat_walk(std::tuple_cat(std::make_tuple(values, base), indices));
+        const long size = long(values.size());
+        const auto blocks = make_flat_blocks(policy, size, size);
+        if (blocks.nblocks <= 1) {
+            scatter_serial(w, size, indexed_shape, indexed_strides, op);
+            return;
+        }
+
+        const long nparts = blocks.nblocks;
+        const long span = highest-lowest+1;
+        auto partition = [=] (long offset) {
+            return (offset-lowest)*nparts/span;
+        };
+        const long vals_stride = w.strides[size_t(ndims)-1][0];
+
+        //counts[ib*nparts+ip]: points of block ib in partition ip
+        std::vector<long> counts (size_t(blocks.nblocks*nparts), 0l);
+        run_flat_blocks(policy, blocks, [&] (long begin, long end, long iblock) {
+            long * block_counts = &counts[size_t(iblock*nparts)];
+            for_each_c_segment(w, begin, end, [&] (long, long n, std::array<long, nops> const & offsets) {
+                for (long j = 0; j < n; ++j) {
+                    ++block_counts[partition(indexed_offset(w, offsets, j, indexed_shape, indexed_strides, std::index_sequence_for<Tidx...>()))];
+                }
+            });
+        });
+
+        std::vector<long> part_begin (size_t(nparts+1), 0l);
+        long acc = 0;
+        for (long ip = 0; ip < nparts; ++ip) {
+            part_begin[size_t(ip)] = acc;
+            for (long ib = 0; ib < blocks.nblocks; ++ib) {
+                long & c = counts[size_t(ib*nparts+ip)];
+                const long n = c;
+                c = acc;
+                acc += n;
+            }
+        }
+        part_begin[size_t(nparts)] = acc;
+
+        const size_t npoints = size_t(size);
+        std::vector<long> sorted_offsets (npoints);
+        std::vector<Tv> sorted_values (npoints);
+        run_flat_blocks(policy, blocks, [&] (long begin, long end, long iblock) {
+            long * block_pos = &counts[size_t(iblock*nparts)];
+            for_each_c_segment(w, begin, end, [&] (long, long n, std::array<long, nops> const & offsets) {
+                Tv const * vals = std::get<0>(w.data)+offsets[0];
+                for (long j = 0; j < n; ++j) {
+                    const long offset = indexed_offset(w, offsets, j, indexed_shape, indexed_strides, std::index_sequence_for<Tidx...>());
+                    const long pos = block_pos[partition(offset)]++;
+                    sorted_offsets[size_t(pos)] = offset;
+                    sorted_values[size_t(pos)] = vals[j*vals_stride];
+                }
+            });
+        });
+
+        T * dst = std::get<1>(w.data);
+        parallel_blocks(policy, blocks.nthreads, nparts, [&] (long ipart_begin, long ipart_end) {
+            for (long i = part_begin[size_t(ipart_begin)]; i < part_begin[size_t(ipart_end)]; ++i) {
+                op(dst[sorted_offsets[size_t(i)]], sorted_values[size_t(i)]);
+            }
+        });
+    }
+
+    //view of the data of u with the given shape and zero strides, the base of a gather or scatter
+    template <typename T, long ndims_u, long ndims>
+    ndataview<T, ndims>
+    base_view(ndataview<T, ndims_u> u, vecarray<long, ndims> shape) {
+        return ndataview<T, ndims>(
+                    indexer<ndims>(u.get_start_index(), shape, vecarray<long, ndims>(STATICALLY_SIZED, 0l)),
+                    u.data_
+                    );
+    }
+
+    template <typename PolicyT, typename T, long ndims, typename ... Tidx, long ndims_idx>
+    nvector<T, ndims_idx>
+    take_points(PolicyT const & policy, ndataview<T, ndims> src, std::tuple<ndataview<Tidx, ndims_idx>...> indices) {
+        static_assert(sizeof...(Tidx) == size_t(ndims), "one index array per dimension of the source");
+        static_assert(ndims != DYNAMICALLY_SIZED and ndims_idx != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+        auto shape = std::get<0>(indices).get_shape();
+        nvector<T, ndims_idx> ret (indexer<ndims_idx>(shape), UNINITIALIZED);
+
+        std::array<long, size_t(ndims)> src_shape, src_strides;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            src_shape[i] = src.get_shape()[i];
+            src_strides[i] = src.get_strides()[i];
+        }
+        gather(policy, ret.as_view(), base_view(src, shape), indices, src_shape, src_strides);
+        return ret;
+    }
+
+    //lowest and highest offsets of the elements of u
+    template <typename T, long ndims>
+    std::pair<long, long>
+    offset_span(ndataview<T, ndims> u) {
+        long lowest = long(u.get_start_index());
+        long highest = lowest;
+        auto shape = u.get_shape();
+        auto strides = u.get_strides();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            const long extent = (shape[i]-1)*strides[i];
+            lowest += std::min(0l, extent);
+            highest += std::max(0l, extent);
+        }
+        return std::make_pair(lowest, highest);
+    }
+
+    template <typename PolicyT, typename ContainerT, typename T, long ndims, typename Ndatacontainer_values, typename OpT, typename ... IndexContainers>
+    void
+    scatter_points(
+            PolicyT const & policy,
+            ndatacontainer<ContainerT, T, ndims> & dst,
+            std::tuple<IndexContainers&...> indices,
+            Ndatacontainer_values & values,
+            OpT op)
+    {
+        static_assert(sizeof...(IndexContainers) == size_t(ndims), "one index array per dimension of the destination");
+        static_assert(ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+        auto idx_views = broadcast_views(indices);
+        auto shape = std::get<0>(idx_views).get_shape();
+        constexpr long ndims_idx = decltype(shape)::STATIC_SIZE_OR_DYNAMIC;
+        auto values_view = std::get<0>(broadcast_to_shape(indexer<ndims_idx>(shape), std::tie(values)));
+
+        auto dst_view = dst.as_view();
+        std::array<long, size_t(ndims)> dst_shape, dst_strides;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            dst_shape[i] = dst_view.get_shape()[i];
+            dst_strides[i] = dst_view.get_strides()[i];
+        }
+        auto span = offset_span(dst_view);
+        scatter(policy, values_view, base_view(dst_view, shape), idx_views, dst_shape, dst_strides, span.first, span.second, op);
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief New nvector with the elements of src at the points given by the index arrays, one per dimension
+ *  of src and broadcasted together: element p of the result is src(indices_0[p], indices_1[p]...), like
+ *  numpy's src[indices_0, indices_1...]. The result has the shape of the broadcasted index arrays.
+ *
+ * auto values = take(parallel_policy(), field, std::tie(ix, iy)); //values[p] = field(ix[p], iy[p])
+ *
+ * The indices must be within the shape of src (checked by an assertion in debug builds).
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename ... IndexContainers>
+auto
+take(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & src, std::tuple<IndexContainers&...> indices) {
+    static_assert(is_execution_policy<PolicyT>::value, "");
+    return helpers::take_points(policy, src.as_view(), helpers::broadcast_views(indices));
+}
+
+template <typename ContainerT, typename T, long ndims, typename ... IndexContainers>
+auto
+take(ndatacontainer<ContainerT, T, ndims> & src, std::tuple<IndexContainers&...> indices) {
+    return take(serial_policy(), src, indices);
+}
+
+/**
+ * @brief New nvector with the elements of src at the indices along axis, like numpy.take: the axis is
+ *  replaced by the dimensions of indices, ret(i..., j..., k...) = src(i..., indices(j...), k...).
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename ContainerT_idx, typename Tidx, long ndims_idx>
+typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, ndims+ndims_idx-1>>::type
+take(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & src, ndatacontainer<ContainerT_idx, Tidx, ndims_idx> & indices, size_t axis) {
+    static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED and ndims_idx > 0 and ndims_idx != DYNAMICALLY_SIZED,
+                  "only for a number of dimensions known at compile time");
+    constexpr long ndims_out = ndims+ndims_idx-1;
+    assert(axis < size_t(ndims));
+
+    auto src_view = src.as_view();
+    auto idx_view = indices.as_view();
+    auto src_shape = src_view.get_shape();
+    auto src_strides = src_view.get_strides();
+    auto idx_shape = idx_view.get_shape();
+    auto idx_strides = idx_view.get_strides();
+
+    //the source dimensions around the index dimensions
+    vecarray<long, ndims_out> shape (STATICALLY_SIZED);
+    vecarray<long, ndims_out> base_strides (STATICALLY_SIZED, 0l);
+    vecarray<long, ndims_out> out_idx_strides (STATICALLY_SIZED, 0l);
+    for (size_t i = 0; i < size_t(ndims_out); ++i) {
+        if (i < axis) {
+            shape[i] = src_shape[i];
+            base_strides[i] = src_strides[i];
+        } else if (i < axis+size_t(ndims_idx)) {
+            shape[i] = idx_shape[i-axis];
+            out_idx_strides[i] = idx_strides[i-axis];
+        } else {
+            shape[i] = src_shape[i-size_t(ndims_idx)+1];
+            base_strides[i] = src_strides[i-size_t(ndims_idx)+1];
+        }
+    }
+
+    nvector<T, ndims_out> ret (indexer<ndims_out>(shape), UNINITIALIZED);
+    helpers::gather(
+                policy,
+                ret.as_view(),
+                ndataview<T, ndims_out>(indexer<ndims_out>(src_view.get_start_index(), shape, base_strides), src_view.data_),
+                std::make_tuple(ndataview<Tidx, ndims_out>(indexer<ndims_out>(idx_view.get_start_index(), shape, out_idx_strides), idx_view.data_)),
+                std::array<long, 1>{{src_shape[axis]}},
+                std::array<long, 1>{{src_strides[axis]}}
+                );
+    return ret;
+}
+
+template <typename ContainerT, typename T, long ndims, typename ContainerT_idx, typename Tidx, long ndims_idx>
+nvector<T, ndims+ndims_idx-1>
+take(ndatacontainer<ContainerT, T, ndims> & src, ndatacontainer<ContainerT_idx, Tidx, ndims_idx> & indices, size_t axis) {
+    return take(serial_policy(), src, indices, axis);
+}
+
+/**
+ * @brief New nvector with the elements of src at the indices along axis, picked independently for each
+ *  line, like numpy.take_along_axis: ret(i, j, k) = src(i, indices(i, j, k), k) for axis 1. indices has
+ *  the dimensions of src and is broadcasted with it along the other axes.
+ *
+ * With the indices of an argsort or argmin, this picks the sorted values or the minima of each line.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename ContainerT_idx, typename Tidx>
+typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, ndims>>::type
+take_along_axis(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & src, ndatacontainer<ContainerT_idx, Tidx, ndims> & indices, size_t axis) {
+    static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+    assert(axis < size_t(ndims));
+
+    auto src_view = src.as_view();
+    auto idx_view = indices.as_view();
+    auto src_shape = src_view.get_shape();
+    auto src_strides = src_view.get_strides();
+    auto idx_shape = idx_view.get_shape();
+    auto idx_strides = idx_view.get_strides();
+
+    vecarray<long, ndims> shape (STATICALLY_SIZED);
+    vecarray<long, ndims> base_strides (STATICALLY_SIZED, 0l);
+    vecarray<long, ndims> out_idx_strides (STATICALLY_SIZED, 0l);
+    for (size_t i = 0; i < size_t(ndims); ++i) {
+        if (i == axis) {
+            shape[i] = idx_shape[i];
+        } else if (src_shape[i] == idx_shape[i] or idx_shape[i] == 1) {
+            shape[i] = src_shape[i];
+        } else if (src_shape[i] == 1) {
+            shape[i] = idx_shape[i];
+        } else {
+            throw std::domain_error("take_along_axis: the indices don't broadcast with the source");
+        }
+        if (i != axis and src_shape[i] == shape[i]) {
+            base_strides[i] = src_strides[i];
+        }
+        if (idx_shape[i] == shape[i]) {
+            out_idx_strides[i] = idx_strides[i];
+        }
+    }
+
+    nvector<T, ndims> ret (indexer<ndims>(shape), UNINITIALIZED);
+    helpers::gather(
+                policy,
+                ret.as_view(),
+                ndataview<T, ndims>(indexer<ndims>(src_view.get_start_index(), shape, base_strides), src_view.data_),
+                std::make_tuple(ndataview<Tidx, ndims>(indexer<ndims>(idx_view.get_start_index(), shape, out_idx_strides), idx_view.data_)),
+                std::array<long, 1>{{src_shape[axis]}},
+                std::array<long, 1>{{src_strides[axis]}}
+                );
+    return ret;
+}
+
+template <typename ContainerT, typename T, long ndims, typename ContainerT_idx, typename Tidx>
+nvector<T, ndims>
+take_along_axis(ndatacontainer<ContainerT, T, ndims> & src, ndatacontainer<ContainerT_idx, Tidx, ndims> & indices, size_t axis) {
+    return take_along_axis(serial_policy(), src, indices, axis);
+}
+
+/**
+ * @brief dst(indices_0[p], indices_1[p]...) = values[p] for the points of the broadcasted index arrays,
+ *  one per dimension of dst, values being broadcasted to their shape. The inverse of take: like numpy's
+ *  dst[indices_0, indices_1...] = values. Where several points have the same indices the last one, in
+ *  C order, is kept, also in parallel.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename Ndatacontainer_values, typename ... IndexContainers>
+typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+put(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & dst, std::tuple<IndexContainers&...> indices, Ndatacontainer_values & values) {
+    helpers::scatter_points(policy, dst, indices, values, [] (T & d, auto const & v) {d = v;});
+}
+
+template <typename ContainerT, typename T, long ndims, typename Ndatacontainer_values, typename ... IndexContainers>
+void
+put(ndatacontainer<ContainerT, T, ndims> & dst, std::tuple<IndexContainers&...> indices, Ndatacontainer_values & values) {
+    put(serial_policy(), dst, indices, values);
+}
+
+/**
+ * @brief dst(indices_0[p], indices_1[p]...) += values[p] for the points of the broadcasted index arrays,
+ *  see put. Unlike numpy's dst[indices...] += values, all the points with the same indices are added
+ *  (numpy.add.at). The additions to an element are done in the C order of the points, also in parallel,
+ *  so that floating point results don't depend on the number of threads.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename Ndatacontainer_values, typename ... IndexContainers>
+typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+scatter_add(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & dst, std::tuple<IndexContainers&...> indices, Ndatacontainer_values & values) {
+    helpers::scatter_points(policy, dst, indices, values, [] (T & d, auto const & v) {d += v;});
+}
+
+template <typename ContainerT, typename T, long ndims, typename Ndatacontainer_values, typename ... IndexContainers>
+void
+scatter_add(ndatacontainer<ContainerT, T, ndims> & dst, std::tuple<IndexContainers&...> indices, Ndatacontainer_values & values) {
+    scatter_add(serial_policy(), dst, indices, values);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: GATHER_HPP_J3VB8QYN */
@@ -10,124 +10,16 @@
 #include <array>
 #include <math.h>
 #include <cassert>
+#include <stdexcept>
 #include "ndata.hpp"
 #include "ndata/algorithm/numtype_adapter_fundamental.hpp"
+#include "ndata/algorithm/overflow_behaviour.hpp"
+#include "ndata/algorithm/reduce.hpp"
 #include "ndata/algorithm/sequences.hpp"
 
 namespace ndata {
 namespace interp {
 
-//-----------------------------------------------------------------------------
-//	HELPERS
-//-----------------------------------------------------------------------------
-
-template<class NumT>
-NumT clamp(NumT x, NumT min, NumT max)
-{
-    if(x>max) {
-        x = max;
-    }
-
-    if (x<min) {
-        x = min;
-    }
-
-    return x;
-}
-
-
-//-----------------------------------------------------------------------------
-//	CONSTANTS
-//-----------------------------------------------------------------------------
-
-namespace overflow_behaviour {
-
-    struct zero {
-        static
-        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float) {
-
-            i_start = clamp(i_start, 0l, long(size));
-            i_stop = std::min(i_stop, long(size));
-
-            //also make sure we got floating points error/rounding right
-            assert(i_start >= 0 and i_stop <= long(size)+1); //this is not true for other overflow behaviours
-            return;
-        }
-
-        static
-        void handle_overflow(long &, size_t) {
-            //do nothing
-            return;
-        }
-
-    };
-
-    struct stretch {
-        static
-        void handle_istart_istop(long &, long &, size_t, float) {
-            //nothing
-            return;
-        }
-
-        static
-        void handle_overflow(long & i_uold, size_t size) {
-            i_uold = clamp(long(i_uold), 0l, long(size)-1l);
-        }
-    };
-
-    struct cyclic {
-        static
-        void handle_istart_istop(long &, long &, size_t, float) {
-            //nothing
-            return;
-        }
-
-        static
-        void handle_overflow(long & i_uold, size_t size) {
-                i_uold = i_uold%long(size);
-                if(i_uold < 0) {
-                    i_uold += size;
-                }
-        }
-    };
-
-    struct throw_ {
-        static
-        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float index_frac) {
-            if (index_frac < 0 or index_frac > long(size-1)) {
-                throw(std::out_of_range(""));
-            }
-            //TODO informative message about kernel width and throwing behaviour
-            assert(not (i_start < 0 or i_stop > long(size)));
-            return;
-        }
-
-        static
-        void handle_overflow(long &, size_t) {
-            //do nothing
-            return;
-        }
-
-    };
-
-    struct assert_ {
-        static
-        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float index_frac) {
-            assert(not (index_frac < 0 or index_frac > long(size-1)));
-
-            //also make sure we also got floating points error/rounding right
-            assert(not (i_start < 0 or i_stop > long(size)));
-            return;
-        }
-
-        static
-        void handle_overflow(long &, size_t) {
-            //do nothing
-            return;
-        }
-    };
-}
-
 namespace helpers {
 
     template <long ndims>
@@ -191,10 +83,11 @@ namespace helpers {
      */
     template <long ndims_fold, long ndims_to_keep, typename T>
     struct copy_values_from_uold_to_unew {
-        template <typename ... OverflowBehaviours>
+        template <typename PolicyT, typename ... OverflowBehaviours>
         static
         void
         do_it(
+            PolicyT const & policy,
             std::tuple<OverflowBehaviours...> overflow_behaviours,
             vecarray<size_t, ndims_fold> axis_to_fold,
             vecarray<size_t, ndims_to_keep> axis_to_keep,
@@ -254,6 +147,7 @@ namespace helpers {
 
                 //recursive call
                 copy_values_from_uold_to_unew<ndims_fold-1, ndims_to_keep, T>::do_it(
+                            policy,
                             tup_overfl_behav_ht.second,
                             axis_to_fold.drop_front(),
                             axis_to_keep,
@@ -269,10 +163,11 @@ namespace helpers {
 
     template <long ndims_to_keep, typename T>
     struct copy_values_from_uold_to_unew<0, ndims_to_keep, T> {
-        template <typename ... OverflowBehaviours>
+        template <typename PolicyT>
         static
         void
         do_it(
+            PolicyT const & policy,
             std::tuple<>,// overflow_behaviours,
             vecarray<size_t, 0>,// axis_to_fold,
             vecarray<size_t, ndims_to_keep>,// axis_to_keep,
@@ -282,7 +177,7 @@ namespace helpers {
             ndataview<T, ndims_to_keep> u_new_slice
         )
         {
-            u_new_slice.assign(u_slice);
+            u_new_slice.assign(policy, u_slice);
             return;
         }
     };
@@ -379,15 +274,53 @@ public:
 
 
 
+namespace helpers {
+
+    /**
+     * Sums u weighted by conv_coeffs along the axis where u_new has a size of 1.
+     */
+    template <typename PolicyT, typename T, long ndims, typename ContainerT_cc, long ndims_cc>
+    void
+    fold_axis(
+            PolicyT const & policy,
+            nvector<T, ndims> & u_new,
+            ndataview<T, ndims> u,
+            ndatacontainer<ContainerT_cc, float, ndims_cc> & conv_coeffs
+            )
+    {
+        auto operands = std::tie(u_new, u, conv_coeffs);
+        auto views = ndata::helpers::broadcast_views(operands);
+
+        auto acc_func = [] (T & acc, T vu, float vcc) {
+            acc += vu * vcc;
+        };
+        auto combine = [] (T a, T b) -> T {
+            return a+b;
+        };
+        const T zero = ndata::helpers::numtype_adapter<T>::ZERO;
+
+        ndata::helpers::fold_axes(
+                    policy,
+                    std::get<0>(views),
+                    std::make_tuple(std::get<1>(views), std::get<2>(views)),
+                    zero,
+                    acc_func,
+                    combine
+                    );
+    }
+}
+
 template<class KernT, long ndims, long ndims_fold, class ContainerT, class T>
 struct interpolate_inner {
 
+    template <typename PolicyT>
     static
     nvector<T, ndims-ndims_fold>
     do_it(
             ndataview<T, ndims> u,
             vecarray<float, ndims_fold> index_frac,
-            vecarray<size_t, ndims_fold> axis
+            vecarray<size_t, ndims_fold> axis,
+            PolicyT const & policy
             )
     {
         static_assert(ndims != DYNAMICALLY_SIZED, "Dynamic case not implemented");
@@ -447,12 +380,7 @@ struct interpolate_inner {
         nvector<float, new_shape.STATIC_SIZE_OR_DYNAMIC>
                 u_new (new_shape, 0.f);
 
-        //perform reduction through broadcasting with nforeach
-        nforeach(
-            std::tie(u_new, u, conv_coeffs),
-            [=] (auto & vu_new, auto vu, auto vcc) {
-                vu_new += vu * vcc;
-            });
+        helpers::fold_axis(policy, u_new, u, conv_coeffs);
 
         auto new_axis_predrop = axis.drop_back();
         auto new_axis = new_axis_predrop;
@@ -472,7 +400,8 @@ struct interpolate_inner {
                 make_vecarray(axis.back())
                 ),
                 index_frac.drop_back(),
-                axis.drop_back()
+                new_axis,
+                policy
             );
     }
 };
@@ -480,12 +409,14 @@ struct interpolate_inner {
 template <class KernT, long ndims, typename ContainerT, typename T>
 struct interpolate_inner<KernT, ndims, 0, ContainerT, T> {
 
+    template <typename PolicyT>
     static 
     nvector<T, ndims>
     do_it(
             ndataview<T, ndims> u,
             vecarray<float, 0>,//index_frac,
-            vecarray<size_t, 0>// axis
+            vecarray<size_t, 0>,// axis
+            PolicyT const &
             )
     {
         return make_nvector(u);
@@ -496,8 +427,11 @@ struct interpolate_inner<KernT, ndims, 0, ContainerT, T> {
 /**
  * Interpolate one value among a regularly sampled grid of data. The position must be passed as a
  * fraction of an index on each dimension.
+ *
+ * When only some of the axes are interpolated, the result is an array whose computation runs with
+ * the execution policy passed last (serial by default).
  */
-template<class KernT, long ndims, long ndims_fold, typename ContainerT, typename T, typename ... OverflowBehaviours>
+template<class KernT, long ndims, long ndims_fold, typename ContainerT, typename T, typename ... OverflowBehaviours, typename PolicyT = serial_policy>
 nvector<T, ndims-ndims_fold>
 interpolate (
         ndatacontainer<ContainerT, T, ndims> u,
@@ -507,8 +441,9 @@ interpolate (
         vecarray<float, ndims_fold> index_frac,
         vecarray<size_t, ndims_fold> axis,
         //[from 1 to ndims]
-        std::tuple<OverflowBehaviours...> overflow_behaviours
+        std::tuple<OverflowBehaviours...> overflow_behaviours,
         //std::tuple<OverflowBehaviour...> overflow_behaviours
+        PolicyT const & policy = PolicyT()
         )
 {
     vecarray<long, ndims_fold> shape (axis.dynsize());
@@ -587,6 +522,7 @@ interpolate (
 
     //filling all the values of the new (reduced) array u_new from the values of the old u
     helpers::copy_values_from_uold_to_unew<ndims_fold, ndims-ndims_fold, T>::do_it(
+            policy,
             overflow_behaviours,
             axis,
             axis_to_keep,
@@ -601,12 +537,13 @@ interpolate (
         index_frac[i] = index_frac[i] - i_starts[i];
     }
 
-    assert(index_frac.size() == unew_shape.size() );
+    assert(index_frac.size() <= unew_shape.size() );
 
     return interpolate_inner<KernT, ndims, ndims_fold, T*, T>::do_it(
             unew.as_view(),
             index_frac,
-            axis
+            axis,
+            policy
     );
 }
 
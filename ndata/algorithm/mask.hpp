@@ -0,0 +1,380 @@
+/*! \file Contains nmask, a packed boolean array, and the masked operations built on it: where,
+ *  nforeach_masked and compress */
+#ifndef MASK_HPP_Q4HN7TWE
+#define MASK_HPP_Q4HN7TWE
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/flat_walk.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    inline
+    long
+    popcount(uint64_t w) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(w);
+#else
+        return long(std::bitset<64>(w).count());
+#endif
+    }
+
+    //index of the lowest bit set of w, which must not be 0
+    inline
+    long
+    lowest_bit(uint64_t w) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(w);
+#else
+        long ret = 0;
+        while (not (w & 1u)) {
+            w >>= 1;
+            ++ret;
+        }
+        return ret;
+#endif
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief A boolean array of the shape of its indexer, packed 64 elements per word in C order: element
+ *  of flat index i (i = index(...), the indexer being contiguous) is bit i%64 of word i/64. The bits past
+ *  the last element are kept at 0.
+ *
+ * Unlike nvector<bool, ndims>, which sits on std::vector<bool> and can't be viewed, the words can be
+ * scanned 64 elements at a time: nforeach_masked and compress skip the words with no element set.
+ */
+template <long ndims>
+struct nmask: indexer<ndims> {
+    static_assert(ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+    static constexpr long WORD_BITS = 64;
+
+    std::vector<uint64_t> words_;
+
+    /**
+     * @brief Mask of the given shape with all elements set to value.
+     */
+    explicit
+    nmask(vecarray<long, ndims> shape, bool value = false):
+        indexer<ndims>(shape),
+        words_(size_t((this->size()+WORD_BITS-1)/WORD_BITS), value? ~uint64_t(0) : uint64_t(0))
+    {
+        clear_tail();
+    }
+
+    nmask() { };
+
+    long
+    nwords() const {
+        return long(words_.size());
+    }
+
+    bool
+    bit(size_t flat_index) const {
+        return (words_[flat_index/WORD_BITS] >> (flat_index%WORD_BITS)) & 1u;
+    }
+
+    void
+    set_bit(size_t flat_index, bool value = true) {
+        const uint64_t b = uint64_t(1) << (flat_index%WORD_BITS);
+        if (value) {
+            words_[flat_index/WORD_BITS] |= b;
+        } else {
+            words_[flat_index/WORD_BITS] &= ~b;
+        }
+    }
+
+    /**
+     * @brief The element at the given indices.
+     */
+    template <typename ... IndexT>
+    bool
+    operator()(IndexT ... indices) {
+        return bit(this->index(indices...));
+    }
+
+    void
+    set(vecarray<long, ndims> ndindex, bool value = true) {
+        set_bit(this->index(ndindex), value);
+    }
+
+    /**
+     * @brief Number of elements set.
+     */
+    long
+    count() const {
+        long ret = 0;
+        for (uint64_t w: words_) {
+            ret += helpers::popcount(w);
+        }
+        return ret;
+    }
+
+    nmask
+    operator~() const {
+        nmask ret = *this;
+        for (uint64_t & w: ret.words_) {
+            w = ~w;
+        }
+        ret.clear_tail();
+        return ret;
+    }
+
+    nmask & operator&=(nmask const & other) {return combine(other, [] (uint64_t & a, uint64_t b) {a &= b;});}
+    nmask & operator|=(nmask const & other) {return combine(other, [] (uint64_t & a, uint64_t b) {a |= b;});}
+    nmask & operator^=(nmask const & other) {return combine(other, [] (uint64_t & a, uint64_t b) {a ^= b;});}
+
+private:
+
+    template <typename OpT>
+    nmask &
+    combine(nmask const & other, OpT op) {
+        indexer<ndims> other_indexer = other;
+        auto shape = this->get_shape();
+        auto other_shape = other_indexer.get_shape();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            if (shape[i] != other_shape[i]) {
+                throw std::domain_error("nmask: the masks must have the same shape");
+            }
+        }
+        for (size_t i = 0; i < words_.size(); ++i) {
+            op(words_[i], other.words_[i]);
+        }
+        return *this;
+    }
+
+    void
+    clear_tail() {
+        const long nbits = long(this->size())%WORD_BITS;
+        if (nbits != 0) {
+            words_.back() &= (uint64_t(1) << nbits)-1;
+        }
+    }
+};
+
+template <long ndims> nmask<ndims> operator&(nmask<ndims> a, nmask<ndims> const & b) {return a &= b;}
+template <long ndims> nmask<ndims> operator|(nmask<ndims> a, nmask<ndims> const & b) {return a |= b;}
+template <long ndims> nmask<ndims> operator^(nmask<ndims> a, nmask<ndims> const & b) {return a ^= b;}
+
+namespace helpers {
+
+    /**
+     * @brief Calls func(vals...) on the operands of the walk at the flat indices set in the words
+     *  [word_begin, word_end) of the mask. Runs of words with no bit set are skipped without reading the
+     *  operands, the set bits of the other words are visited with a count of trailing zeros.
+     */
+    template <long ndims, size_t nops, typename ... Ts, typename FuncT>
+    void
+    for_each_set(
+            nmask<ndims> const & mask,
+            flat_walk<nops, ndims, Ts...> const & w,
+            long word_begin,
+            long word_end,
+            FuncT & func)
+    {
+        constexpr long WB = nmask<ndims>::WORD_BITS;
+        long size = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            size *= w.shape[i];
+        }
+        uint64_t const * words = mask.words_.data();
+        auto const & inner_strides = w.strides[size_t(ndims)-1];
+
+        long iw = word_begin;
+        while (iw < word_end) {
+            while (iw < word_end and words[iw] == 0) {
+                ++iw;
+            }
+            const long run_begin = iw;
+            while (iw < word_end and words[iw] != 0) {
+                ++iw;
+            }
+            if (run_begin == iw) {
+                break;
+            }
+
+            for_each_c_segment(w, run_begin*WB, std::min(iw*WB, size), [&] (long flat, long n, std::array<long, nops> const & offsets) {
+                long pos = flat;
+                while (pos < flat+n) {
+                    const long word_stop = std::min((pos/WB+1)*WB, flat+n);
+                    uint64_t bits = words[pos/WB] >> (pos%WB);
+                    if (word_stop-pos < WB) {
+                        bits &= (uint64_t(1) << (word_stop-pos))-1;
+                    }
+                    while (bits) {
+                        call_at(func, w.data, offsets, pos-flat+lowest_bit(bits), inner_strides, std::index_sequence_for<Ts...>());
+                        bits &= bits-1;
+                    }
+                    pos = word_stop;
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Views of the containers broadcasted to the shape of the mask.
+     */
+    template <long ndims, typename ... Ndatacontainer>
+    auto
+    mask_operands(nmask<ndims> & mask, std::tuple<Ndatacontainer&...> ndata_tup_refs) {
+        return broadcast_to_shape(indexer<ndims>(mask.get_shape()), ndata_tup_refs);
+    }
+
+    template <typename PolicyT, typename ... Ts, long ndims, typename PredT>
+    nmask<ndims>
+    make_nmask_base(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> views, PredT & pred) {
+        static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+        constexpr long WB = nmask<ndims>::WORD_BITS;
+
+        nmask<ndims> ret (std::get<0>(views).get_shape());
+        const long size = long(ret.size());
+        const auto w = make_flat_walk(views);
+        auto const & inner_strides = w.strides[size_t(ndims)-1];
+        uint64_t * words = ret.words_.data();
+
+        //each block sets whole words, which start at 0
+        run_flat_blocks(policy, make_flat_blocks(policy, ret.nwords(), size), [&] (long word_begin, long word_end, long) {
+            for_each_c_segment(w, word_begin*WB, std::min(word_end*WB, size), [&] (long flat, long n, std::array<long, sizeof...(Ts)> const & offsets) {
+                for (long j = 0; j < n; ++j) {
+                    bool b = false;
+                    auto set_b = [&] (auto & ... vals) {b = pred(vals...);};
+                    call_at(set_b, w.data, offsets, j, inner_strides, std::index_sequence_for<Ts...>());
+                    words[(flat+j)/WB] |= uint64_t(b) << ((flat+j)%WB);
+                }
+            });
+        });
+        return ret;
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief Mask of the elements of the broadcasted containers for which pred(vals...) is true:
+ *
+ * auto positive = make_nmask(parallel_policy(), std::tie(u), [] (double x) {return x > 0;});
+ */
+template <typename PolicyT, typename PredT, typename ... Ndatacontainer>
+auto
+make_nmask(PolicyT const & policy, std::tuple<Ndatacontainer&...> ndata_tup_refs, PredT pred) {
+    static_assert(is_execution_policy<PolicyT>::value, "");
+    return helpers::make_nmask_base(policy, helpers::broadcast_views(ndata_tup_refs), pred);
+}
+
+template <typename PredT, typename ... Ndatacontainer>
+auto
+make_nmask(std::tuple<Ndatacontainer&...> ndata_tup_refs, PredT pred) {
+    return make_nmask(serial_policy(), ndata_tup_refs, pred);
+}
+
+/**
+ * @brief Calls func(vals...) on the elements of the containers, broadcasted to the shape of the mask,
+ *  where the mask is set. The words of the mask with no element set are skipped without reading the
+ *  containers, which makes sparse masks cheap.
+ */
+template <typename PolicyT, long ndims, typename FuncT, typename ... Ndatacontainer>
+typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+nforeach_masked(PolicyT const & policy, nmask<ndims> & mask, std::tuple<Ndatacontainer&...> ndata_tup_refs, FuncT func) {
+    const auto w = helpers::make_flat_walk(helpers::mask_operands(mask, ndata_tup_refs));
+    helpers::run_flat_blocks(policy, helpers::make_flat_blocks(policy, mask.nwords(), long(mask.size())), [&] (long word_begin, long word_end, long) {
+        helpers::for_each_set(mask, w, word_begin, word_end, func);
+    });
+}
+
+template <long ndims, typename FuncT, typename ... Ndatacontainer>
+void
+nforeach_masked(nmask<ndims> & mask, std::tuple<Ndatacontainer&...> ndata_tup_refs, FuncT func) {
+    nforeach_masked(serial_policy(), mask, ndata_tup_refs, func);
+}
+
+/**
+ * @brief New nvector of the shape of the mask, with the elements of a where the mask is set and those of b
+ *  elsewhere. a and b are broadcasted to the shape of the mask, a 0D container acts as a scalar.
+ */
+template <typename PolicyT, long ndims, typename ContainerT_a, typename T, long ndims_a, typename ContainerT_b, long ndims_b>
+typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, ndims>>::type
+where(PolicyT const & policy, nmask<ndims> & mask, ndatacontainer<ContainerT_a, T, ndims_a> & a, ndatacontainer<ContainerT_b, T, ndims_b> & b) {
+    constexpr long WB = nmask<ndims>::WORD_BITS;
+
+    nvector<T, ndims> ret (indexer<ndims>(mask.get_shape()), UNINITIALIZED);
+    const long size = long(ret.size());
+    const auto w = helpers::make_flat_walk(std::tuple_cat(std::make_tuple(ret.as_view()), helpers::mask_operands(mask, std::tie(a, b))));
+    auto const & inner_strides = w.strides[size_t(ndims)-1];
+    uint64_t const * words = mask.words_.data();
+
+    helpers::run_flat_blocks(policy, helpers::make_flat_blocks(policy, mask.nwords(), size), [&] (long word_begin, long word_end, long) {
+        helpers::for_each_c_segment(w, word_begin*WB, std::min(word_end*WB, size), [&] (long flat, long n, std::array<long, 3> const & offsets) {
+            T * out = std::get<0>(w.data)+offsets[0];
+            T const * pa = std::get<1>(w.data)+offsets[1];
+            T const * pb = std::get<2>(w.data)+offsets[2];
+            for (long j = 0; j < n; ++j) {
+                const bool m = (words[(flat+j)/WB] >> ((flat+j)%WB)) & 1u;
+                out[j*inner_strides[0]] = m? pa[j*inner_strides[1]] : pb[j*inner_strides[2]];
+            }
+        });
+    });
+    return ret;
+}
+
+template <long ndims, typename ContainerT_a, typename T, long ndims_a, typename ContainerT_b, long ndims_b>
+nvector<T, ndims>
+where(nmask<ndims> & mask, ndatacontainer<ContainerT_a, T, ndims_a> & a, ndatacontainer<ContainerT_b, T, ndims_b> & b) {
+    return where(serial_policy(), mask, a, b);
+}
+
+/**
+ * @brief New 1D nvector with the elements of u, broadcasted to the shape of the mask, where the mask is set,
+ *  in C order.
+ *
+ * With a parallel policy the words of the mask are split in blocks: a first pass counts the elements
+ * set in each block, their prefix sum gives where each block writes, and a second pass gathers them.
+ */
+template <typename PolicyT, long ndims, typename ContainerT, typename T, long ndims_u>
+typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, 1>>::type
+compress(PolicyT const & policy, nmask<ndims> & mask, ndatacontainer<ContainerT, T, ndims_u> & u) {
+    const auto w = helpers::make_flat_walk(helpers::mask_operands(mask, std::tie(u)));
+    const auto blocks = helpers::make_flat_blocks(policy, mask.nwords(), long(mask.size()));
+
+    std::vector<long> offsets (size_t(blocks.nblocks+1), 0l);
+    helpers::run_flat_blocks(policy, blocks, [&] (long word_begin, long word_end, long iblock) {
+        long n = 0;
+        for (long iw = word_begin; iw < word_end; ++iw) {
+            n += helpers::popcount(mask.words_[size_t(iw)]);
+        }
+        offsets[size_t(iblock+1)] = n;
+    });
+    for (size_t ib = 0; ib < size_t(blocks.nblocks); ++ib) {
+        offsets[ib+1] += offsets[ib];
+    }
+
+    nvector<T, 1> ret (indexer<1>(offsets.back()), UNINITIALIZED);
+    T * dst = ret.data_.data();
+    helpers::run_flat_blocks(policy, blocks, [&] (long word_begin, long word_end, long iblock) {
+        T * out = dst+offsets[size_t(iblock)];
+        auto gather = [&out] (T const & val) {
+            *out++ = val;
+        };
+        helpers::for_each_set(mask, w, word_begin, word_end, gather);
+    });
+    return ret;
+}
+
+template <long ndims, typename ContainerT, typename T, long ndims_u>
+nvector<T, 1>
+compress(nmask<ndims> & mask, ndatacontainer<ContainerT, T, ndims_u> & u) {
+    return compress(serial_policy(), mask, u);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: MASK_HPP_Q4HN7TWE */
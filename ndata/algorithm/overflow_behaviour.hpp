@@ -0,0 +1,127 @@
+/*! \file Contains the overflow behaviours, the ways of reading an array beyond its borders used by
+ *  interpolate and padded_view */
+#ifndef OVERFLOW_BEHAVIOUR_HPP_T5KXW2QE
+#define OVERFLOW_BEHAVIOUR_HPP_T5KXW2QE
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace ndata {
+namespace interp {
+
+//-----------------------------------------------------------------------------
+//	HELPERS
+//-----------------------------------------------------------------------------
+
+template<class NumT>
+NumT clamp(NumT x, NumT min, NumT max)
+{
+    if(x>max) {
+        x = max;
+    }
+
+    if (x<min) {
+        x = min;
+    }
+
+    return x;
+}
+
+
+//-----------------------------------------------------------------------------
+//	CONSTANTS
+//-----------------------------------------------------------------------------
+
+namespace overflow_behaviour {
+
+    struct zero {
+        static
+        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float) {
+
+            i_start = clamp(i_start, 0l, long(size));
+            i_stop = std::min(i_stop, long(size));
+
+            //also make sure we got floating points error/rounding right
+            assert(i_start >= 0 and i_stop <= long(size)+1); //this is not true for other overflow behaviours
+            return;
+        }
+
+        static
+        void handle_overflow(long &, size_t) {
+            //do nothing
+            return;
+        }
+
+    };
+
+    struct stretch {
+        static
+        void handle_istart_istop(long &, long &, size_t, float) {
+            //nothing
+            return;
+        }
+
+        static
+        void handle_overflow(long & i_uold, size_t size) {
+            i_uold = clamp(long(i_uold), 0l, long(size)-1l);
+        }
+    };
+
+    struct cyclic {
+        static
+        void handle_istart_istop(long &, long &, size_t, float) {
+            //nothing
+            return;
+        }
+
+        static
+        void handle_overflow(long & i_uold, size_t size) {
+                i_uold = i_uold%long(size);
+                if(i_uold < 0) {
+                    i_uold += size;
+                }
+        }
+    };
+
+    struct throw_ {
+        static
+        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float index_frac) {
+            if (index_frac < 0 or index_frac > long(size-1)) {
+                throw(std::out_of_range(""));
+            }
+            //TODO informative message about kernel width and throwing behaviour
+            assert(not (i_start < 0 or i_stop > long(size)));
+            return;
+        }
+
+        static
+        void handle_overflow(long &, size_t) {
+            //do nothing
+            return;
+        }
+
+    };
+
+    struct assert_ {
+        static
+        void handle_istart_istop(long & i_start, long & i_stop, size_t size, float index_frac) {
+            assert(not (index_frac < 0 or index_frac > long(size-1)));
+
+            //also make sure we also got floating points error/rounding right
+            assert(not (i_start < 0 or i_stop > long(size)));
+            return;
+        }
+
+        static
+        void handle_overflow(long &, size_t) {
+            //do nothing
+            return;
+        }
+    };
+}
+
+} //end namespace interp
+} //end namespace ndata
+
+#endif /* end of include guard: OVERFLOW_BEHAVIOUR_HPP_T5KXW2QE */
@@ -0,0 +1,381 @@
+/*! \file Contains padded_view, a read-only view of an ndatacontainer extended beyond its borders by the
+ *  overflow behaviours of interp, without allocating the padded array */
+#ifndef PADDED_VIEW_HPP_M2RZC7VA
+#define PADDED_VIEW_HPP_M2RZC7VA
+
+#include <array>
+#include <cassert>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/numtype_adapter_fundamental.hpp"
+#include "ndata/algorithm/overflow_behaviour.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    /**
+     * @brief Index of the source element read at each position of the padding of an axis of size size:
+     *  first the pad_before positions before the axis, then the pad_after positions after it. -1 where
+     *  the overflow behaviour leaves the index outside of the axis (overflow_behaviour::zero), a zero is
+     *  read there.
+     */
+    template <typename OverflowBehaviour>
+    std::vector<long>
+    make_pad_map(long size, long pad_before, long pad_after) {
+        std::vector<long> ret;
+        auto add = [&] (long i) {
+            if (size > 0) {
+                OverflowBehaviour::handle_overflow(i, size_t(size));
+            }
+            ret.push_back((i >= 0 and i < size)? i : -1);
+        };
+        for (long i = -pad_before; i < 0; ++i) {
+            add(i);
+        }
+        for (long i = size; i < size+pad_after; ++i) {
+            add(i);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Positions [begin, begin+length) along an axis of a padded_view, reading the source elements
+     *  src_start, src_start+src_step... along it (src_step = 0 for a repeated border element, 1 inside
+     *  the array or for cyclic padding), or zeros if src_start is -1.
+     */
+    struct pad_segment {
+        long begin;
+        long length;
+        long src_start;
+        long src_step;
+    };
+
+    /**
+     * @brief View on the region [begin, begin+shape) of v.
+     */
+    template <typename T, long ndims>
+    ndataview<T, ndims>
+    region_view(ndataview<T, ndims> v, vecarray<long, ndims> begin, vecarray<long, ndims> shape) {
+        auto strides = v.get_strides();
+        size_t start = v.get_start_index();
+        for (size_t i = 0; i < strides.size(); ++i) {
+            start += begin[i]*strides[i];
+        }
+        return ndataview<T, ndims>(indexer<ndims>(start, shape, strides), v.data_);
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief Read-only view of an array padded along each axis with the elements given by an overflow behaviour
+ *  of interp (zero, stretch, cyclic), behaving like the larger padded array without allocating it.
+ *
+ * Along an axis, the positions of the view are cut in segments (see helpers::pad_segment) read from a
+ * single strided range of the source: the inside of the array, a border element repeated with a zero stride
+ * (stretch), a range from the other side of the array (cyclic), or zeros. A region of the view is thus a
+ * product of blocks that are each an ndataview of the source, see for_each_block: the interior goes
+ * through the strided loops like any view, only the thin border blocks are remapped.
+ *
+ * Element access through operator() remaps each index and is meant for occasional reads, use
+ * for_each_block or copy_to in loops. window restricts the view to a region, e.g. the input of a
+ * stencil offset: padded.window(begin, shape) costs no allocation of data.
+ */
+template <typename T, long ndims>
+struct padded_view {
+    static_assert(ndims > 0, "only for a number of dimensions known at compile time");
+
+    /**
+     * @param source the array to pad, it must outlive the view
+     * @param pad_before number of padded elements before the first element, along each axis
+     * @param pad_after number of padded elements after the last element, along each axis
+     * @param pad_maps see helpers::make_pad_map, usually built by make_padded_view
+     */
+    padded_view(
+            ndataview<T, ndims> source,
+            vecarray<long, ndims> pad_before,
+            vecarray<long, ndims> pad_after,
+            std::array<std::vector<long>, size_t(ndims)> pad_maps
+            ):
+        source_(source),
+        source_shape_(source.get_shape()),
+        pad_before_(pad_before),
+        pad_maps_(std::make_shared<std::array<std::vector<long>, size_t(ndims)>>(std::move(pad_maps))),
+        origin_(STATICALLY_SIZED, 0l),
+        shape_(source.get_shape())
+    {
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            assert(pad_before[i] >= 0 and pad_after[i] >= 0);
+            assert(long((*pad_maps_)[i].size()) == pad_before[i]+pad_after[i]);
+            shape_[i] += pad_before[i]+pad_after[i];
+        }
+    }
+
+    /**
+     * @brief Shape of the padded array (or of the window).
+     */
+    vecarray<long, ndims>
+    get_shape() {
+        return shape_;
+    }
+
+    /**
+     * @brief Index along axis of the source element read at position i of the view, -1 for a zero.
+     */
+    long
+    source_index(size_t axis, long i) {
+        assert(axis < size_t(ndims) and i >= 0 and i < shape_[axis]);
+        long isrc = origin_[axis]+i-pad_before_[axis];
+        if (isrc < 0) {
+            return (*pad_maps_)[axis][size_t(isrc+pad_before_[axis])];
+        } else if (isrc >= source_shape_[axis]) {
+            return (*pad_maps_)[axis][size_t(pad_before_[axis]+isrc-source_shape_[axis])];
+        }
+        return isrc;
+    }
+
+    /**
+     * @brief Value at ndindex, with the indices of the padded array (or window).
+     */
+    T
+    at(vecarray<long, ndims> ndindex) {
+        auto strides = source_.get_strides();
+        size_t index = source_.get_start_index();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            long isrc = source_index(i, ndindex[i]);
+            if (isrc < 0) {
+                return helpers::numtype_adapter<T>::ZERO;
+            }
+            index += isrc*strides[i];
+        }
+        return source_.data_[index];
+    }
+
+    template <typename ... Long>
+    T
+    operator()(Long ... indices) {
+        static_assert(sizeof...(Long) == size_t(ndims), "one index per dimension");
+        return at(vecarray<long, ndims>({long(indices)...}));
+    }
+
+    /**
+     * @brief The source array.
+     */
+    ndataview<T, ndims>
+    source() {
+        return source_;
+    }
+
+    /**
+     * @brief The region [begin, begin+shape) of this view, itself a padded_view.
+     */
+    padded_view
+    window(vecarray<long, ndims> begin, vecarray<long, ndims> shape) {
+        padded_view ret (*this);
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            assert(begin[i] >= 0 and shape[i] >= 0 and begin[i]+shape[i] <= shape_[i]);
+            ret.origin_[i] += begin[i];
+        }
+        ret.shape_ = shape;
+        return ret;
+    }
+
+    /**
+     * @brief The segments of the positions along axis, in increasing order. Positions inside the
+     *  source form a single segment.
+     */
+    std::vector<helpers::pad_segment>
+    segments(size_t axis) {
+        std::vector<helpers::pad_segment> ret;
+        const long n = shape_[axis];
+        const long inside_begin = std::min(n, std::max(0l, pad_before_[axis]-origin_[axis]));
+        const long inside_end = std::max(inside_begin, std::min(n, pad_before_[axis]+source_shape_[axis]-origin_[axis]));
+
+        //padding: runs of positions reading evenly spaced source elements, or zeros
+        auto add_padding = [&] (long begin, long end) {
+            for (long i = begin; i < end; ) {
+                helpers::pad_segment seg {i, 1, source_index(axis, i), 0};
+                if (i+1 < end and seg.src_start >= 0 and source_index(axis, i+1) >= 0) {
+                    seg.src_step = source_index(axis, i+1)-seg.src_start;
+                }
+                while (i+seg.length < end) {
+                    long next = source_index(axis, i+seg.length);
+                    bool continues = (seg.src_start < 0)?
+                                next < 0 :
+                                next >= 0 and next == seg.src_start+seg.length*seg.src_step;
+                    if (not continues) {
+                        break;
+                    }
+                    ++seg.length;
+                }
+                ret.push_back(seg);
+                i += seg.length;
+            }
+        };
+
+        add_padding(0, inside_begin);
+        if (inside_end > inside_begin) {
+            ret.push_back(helpers::pad_segment {inside_begin, inside_end-inside_begin, source_index(axis, inside_begin), 1});
+        }
+        add_padding(inside_end, n);
+        return ret;
+    }
+
+    /**
+     * @brief Calls f(begin, block) for the blocks making the view, block being an ndataview of the
+     *  elements of the region [begin, begin+block.get_shape()) of the view. Blocks of padded zeros are
+     *  views with zero strides on a single zero, they must not be written to or kept after f returns.
+     */
+    template <typename FuncT>
+    void
+    for_each_block(FuncT f) {
+        std::array<std::vector<helpers::pad_segment>, size_t(ndims)> segs;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            segs[i] = segments(i);
+            if (segs[i].empty()) {
+                return; //empty view
+            }
+        }
+
+        T zero = helpers::numtype_adapter<T>::ZERO;
+        auto strides = source_.get_strides();
+        vecarray<size_t, ndims> iseg (STATICALLY_SIZED, 0ul);
+
+        while (true) {
+            vecarray<long, ndims> begin (STATICALLY_SIZED);
+            vecarray<long, ndims> shape (STATICALLY_SIZED);
+            vecarray<long, ndims> block_strides (STATICALLY_SIZED);
+            size_t start = source_.get_start_index();
+            bool zeros = false;
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                helpers::pad_segment const & seg = segs[i][iseg[i]];
+                begin[i] = seg.begin;
+                shape[i] = seg.length;
+                block_strides[i] = strides[i]*seg.src_step;
+                zeros = zeros or seg.src_start < 0;
+                start += seg.src_start*strides[i];
+            }
+
+            if (zeros) {
+                f(begin, ndataview<T, ndims>(indexer<ndims>(0, shape, vecarray<long, ndims>(STATICALLY_SIZED, 0l)), &zero));
+            } else {
+                f(begin, ndataview<T, ndims>(indexer<ndims>(start, shape, block_strides), source_.data_));
+            }
+
+            //next block, last axis first
+            size_t i = size_t(ndims);
+            while (i > 0) {
+                --i;
+                if (++iseg[i] < segs[i].size()) {
+                    break;
+                }
+                iseg[i] = 0;
+                if (i == 0) {
+                    return;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the elements of the view to out, of the same shape. The interior is copied with a
+     *  single strided loop, the borders block by block.
+     */
+    template <typename PolicyT, typename ContainerT>
+    void
+    copy_to(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & out) {
+        auto out_view = out.as_view();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            assert(out_view.get_shape()[i] == shape_[i]);
+        }
+        for_each_block([&] (vecarray<long, ndims> begin, ndataview<T, ndims> block) {
+            helpers::region_view(out_view, begin, block.get_shape()).assign(policy, block);
+        });
+    }
+
+    template <typename ContainerT>
+    void
+    copy_to(ndatacontainer<ContainerT, T, ndims> & out) {
+        copy_to(serial_policy(), out);
+    }
+
+private:
+
+    ndataview<T, ndims> source_;
+
+    vecarray<long, ndims> source_shape_;
+
+    vecarray<long, ndims> pad_before_;
+
+    //shared by the windows
+    std::shared_ptr<std::array<std::vector<long>, size_t(ndims)>> pad_maps_;
+
+    //position of the window in the whole padded array
+    vecarray<long, ndims> origin_;
+
+    vecarray<long, ndims> shape_;
+};
+
+namespace helpers {
+
+    template <typename ... OverflowBehaviours, long ndims, size_t ... Is>
+    std::array<std::vector<long>, size_t(ndims)>
+    make_pad_maps(
+            std::tuple<OverflowBehaviours...>,
+            vecarray<long, ndims> shape,
+            vecarray<long, ndims> pad_before,
+            vecarray<long, ndims> pad_after,
+            std::index_sequence<Is...>
+            )
+    {
+        return {{make_pad_map<OverflowBehaviours>(shape[Is], pad_before[Is], pad_after[Is])...}};
+    }
+
+}
+
+/**
+ * @brief Pads u along each axis with pad_before elements before it and pad_after elements after it,
+ *  given by the overflow behaviour of the axis (a tuple like
+ *  std::make_tuple(interp::overflow_behaviour::cyclic(), interp::overflow_behaviour::zero())).
+ *  Nothing is allocated but the index maps of the padding, u must outlive the view.
+ *
+ * Behaviours leaving the index out of the array (zero, throw_ and assert_) pad with zeros.
+ */
+template <typename ContainerT, typename T, long ndims, typename ... OverflowBehaviours>
+padded_view<T, ndims>
+make_padded_view(
+        ndatacontainer<ContainerT, T, ndims> & u,
+        vecarray<long, ndims> pad_before,
+        vecarray<long, ndims> pad_after,
+        std::tuple<OverflowBehaviours...> overflow_behaviours
+        )
+{
+    static_assert(sizeof...(OverflowBehaviours) == size_t(ndims), "one overflow behaviour per axis");
+    return padded_view<T, ndims>(
+                u.as_view(),
+                pad_before,
+                pad_after,
+                helpers::make_pad_maps(overflow_behaviours, u.get_shape(), pad_before, pad_after, std::index_sequence_for<OverflowBehaviours...>())
+                );
+}
+
+/**
+ * @brief Same padding pad_widths[i] before and after each axis i.
+ */
+template <typename ContainerT, typename T, long ndims, typename ... OverflowBehaviours>
+padded_view<T, ndims>
+make_padded_view(
+        ndatacontainer<ContainerT, T, ndims> & u,
+        vecarray<long, ndims> pad_widths,
+        std::tuple<OverflowBehaviours...> overflow_behaviours
+        )
+{
+    return make_padded_view(u, pad_widths, pad_widths, overflow_behaviours);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: PADDED_VIEW_HPP_M2RZC7VA */
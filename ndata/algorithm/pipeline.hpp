@@ -0,0 +1,686 @@
+/*! \file Contains npipeline, a recorded sequence of elementwise loops and reductions over a common grid,
+ *  run tile by tile */
+#ifndef PIPELINE_HPP_R6KZ2MWD
+#define PIPELINE_HPP_R6KZ2MWD
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/reduce.hpp"
+
+namespace ndata {
+
+/**
+ * @brief Default number of elements of the grid in a tile of npipeline, small enough for the tiles of a
+ *  few tens of operands to stay in the L2 cache.
+ */
+constexpr long PIPELINE_TILE_SIZE = 8192;
+
+/**
+ * @brief Handle on an intermediate array of an npipeline (see npipeline::temporary), with the shape of its
+ *  grid. It is only valid with the pipeline that created it.
+ */
+template <typename T>
+struct npipeline_temp {
+    long id;
+};
+
+namespace helpers {
+
+    //storage of a temporary for the tiles run by one thread
+    struct pipeline_temp_storage {
+        unsigned char * data;
+        bool per_tile; //false: the temporary spans the whole grid
+    };
+
+    /**
+     * @brief Elements [begin, end) along axis of the grid, at the position outer of the flattened axes
+     *  before axis, with all the elements along the axes after it.
+     */
+    struct pipeline_tile {
+        long index;
+        size_t axis;
+        long outer;
+        long begin;
+        long end;
+        std::vector<pipeline_temp_storage> const * temps;
+    };
+
+    /**
+     * @brief The elements of tile in v, which has the shape of the grid. The axes before the axis of the
+     *  tile are kept with a size of 1.
+     */
+    template <typename T, long ndims>
+    ndataview<T, ndims>
+    pipeline_tile_subview(ndataview<T, ndims> v, pipeline_tile const & tile) {
+        auto shape = v.get_shape();
+        auto strides = v.get_strides();
+        long start = long(v.get_start_index());
+
+        long outer = tile.outer;
+        for (size_t i = tile.axis; i-- > 0; ) {
+            start += (outer%shape[i])*strides[i];
+            outer /= shape[i];
+            shape[i] = 1;
+        }
+        start += tile.begin*strides[tile.axis];
+        shape[tile.axis] = tile.end-tile.begin;
+
+        return ndataview<T, ndims>(indexer<ndims>(size_t(start), shape, strides), v.data_);
+    }
+
+    /**
+     * @brief Memory read or written by a step, used to find the steps that can't be fused.
+     */
+    template <long ndims>
+    struct pipeline_access {
+        long temp_id; //-1 for a container
+        bool write;
+        void const * data;
+        size_t start;
+        vecarray<long, ndims> strides;
+        //bytes spanned by the view, [lo, hi)
+        std::uintptr_t lo;
+        std::uintptr_t hi;
+    };
+
+    /**
+     * @brief true if running a and b tile by tile could read an element before or after it is written by
+     *  the other step, when a container is accessed through views with different layouts (shifted
+     *  slices, broadcasting...). Temporaries are always read the way they are written.
+     */
+    template <long ndims>
+    bool
+    pipeline_conflict(pipeline_access<ndims> a, pipeline_access<ndims> b) {
+        if (a.temp_id >= 0 or b.temp_id >= 0 or not (a.write or b.write)) {
+            return false;
+        }
+        if (a.hi <= b.lo or b.hi <= a.lo) {
+            return false;
+        }
+        bool same_view = a.data == b.data and a.start == b.start;
+        for (size_t i = 0; same_view and i < size_t(ndims); ++i) {
+            same_view = a.strides[i] == b.strides[i];
+        }
+        return not same_view;
+    }
+
+    /**
+     * @brief An operand of a step: a container broadcasted to the grid, or a temporary.
+     */
+    template <typename T, long ndims>
+    struct pipeline_operand {
+        //broadcasted to the grid, data_ isn't used for the temporaries
+        ndataview<T, ndims> view;
+        long temp_id;
+
+        ndataview<T, ndims>
+        tile_view(pipeline_tile const & tile) const {
+            ndataview<T, ndims> v = view;
+            if (temp_id >= 0) {
+                pipeline_temp_storage storage = (*tile.temps)[temp_id];
+                T * data = reinterpret_cast<T*>(storage.data);
+                v = ndataview<T, ndims>(indexer<ndims>(v.get_shape()), data);
+                if (storage.per_tile) {
+                    //the tile alone, C contiguous
+                    return ndataview<T, ndims>(indexer<ndims>(pipeline_tile_subview(v, tile).get_shape()), data);
+                }
+            }
+            return pipeline_tile_subview(v, tile);
+        }
+
+        pipeline_access<ndims>
+        access(bool write) const {
+            ndataview<T, ndims> v = view;
+            auto shape = v.get_shape();
+            auto strides = v.get_strides();
+
+            long lo = 0, hi = 1;
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                if (shape[i] == 0) {
+                    hi = lo;
+                    break;
+                }
+                long extent = strides[i]*(shape[i]-1);
+                (extent < 0 ? lo : hi) += extent;
+            }
+
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(v.data_ + v.get_start_index());
+            return pipeline_access<ndims> {
+                temp_id,
+                write,
+                v.data_,
+                v.get_start_index(),
+                strides,
+                base + lo*long(sizeof(T)),
+                base + hi*long(sizeof(T))
+            };
+        }
+    };
+
+    template <long ndims, typename ContainerT, typename T, long ndims_u>
+    pipeline_operand<T, ndims>
+    make_pipeline_operand(indexer<ndims> grid, ndatacontainer<ContainerT, T, ndims_u> & u) {
+        static_assert(ndims_u <= ndims, "an operand has more dimensions than the grid");
+
+        ndataview<T, ndims> bc = broadcast_left(u.as_view(), std::make_tuple(grid));
+        check_output_shape(grid.get_shape(), bc.get_shape());
+        return {bc, -1};
+    }
+
+    template <long ndims, typename T>
+    pipeline_operand<T, ndims>
+    make_pipeline_operand(indexer<ndims> grid, npipeline_temp<T> const & temp) {
+        return {ndataview<T, ndims>(grid, nullptr), temp.id};
+    }
+
+    /**
+     * @brief A recorded step. The pipeline calls begin_run, then run_tile on each tile of the stage
+     *  (concurrently in parallel) and end_run once the stage is over.
+     */
+    template <long ndims>
+    struct pipeline_step {
+        std::vector<pipeline_access<ndims>> accesses;
+
+        virtual ~pipeline_step() { }
+
+        virtual void begin_run(long /*ntiles*/) { }
+
+        virtual void run_tile(pipeline_tile const & tile) = 0;
+
+        virtual void end_run() { }
+    };
+
+    template <typename OperandTupT, size_t ... Is>
+    auto
+    pipeline_tile_views(OperandTupT const & operands, pipeline_tile const & tile, std::index_sequence<Is...>) {
+        return std::make_tuple(std::get<Is>(operands).tile_view(tile)...);
+    }
+
+    template <long ndims, typename OperandTupT, size_t ... Is>
+    std::vector<pipeline_access<ndims>>
+    pipeline_accesses(OperandTupT const & operands, size_t nwrites, std::index_sequence<Is...>) {
+        return {std::get<Is>(operands).access(Is < nwrites)...};
+    }
+
+    /**
+     * @brief Elementwise loop calling body on the tile views of the operands, the first nout of which
+     *  are written.
+     */
+    template <long ndims, typename BodyT, typename OperandTupT>
+    struct pipeline_foreach_step: pipeline_step<ndims> {
+        OperandTupT operands;
+        BodyT body;
+
+        static constexpr size_t NOPERANDS = std::tuple_size<OperandTupT>::value;
+
+        pipeline_foreach_step(OperandTupT operands_, BodyT body_, size_t nout):
+            operands(operands_),
+            body(body_)
+        {
+            this->accesses = pipeline_accesses<ndims>(operands, nout, std::make_index_sequence<NOPERANDS>());
+        }
+
+        void
+        run_tile(pipeline_tile const & tile) override {
+            nforeach_base(
+                        serial_policy(),
+                        pipeline_tile_views(operands, tile, std::make_index_sequence<NOPERANDS>()),
+                        body
+                        );
+        }
+    };
+
+    /**
+     * @brief Reduction of the operands into result. Each tile folds into its own accumulator, and the
+     *  accumulators are combined in tile order when the stage ends, like the blocks of nreduce.
+     */
+    template <long ndims, typename Tacc, typename AccFuncT, typename CombineT, typename OperandTupT>
+    struct pipeline_reduce_step: pipeline_step<ndims> {
+        OperandTupT operands;
+        Tacc & result;
+        Tacc identity;
+        AccFuncT acc_func;
+        CombineT combine;
+        std::vector<reduce_slot<Tacc>> partials;
+
+        static constexpr size_t NOPERANDS = std::tuple_size<OperandTupT>::value;
+
+        pipeline_reduce_step(
+                OperandTupT operands_,
+                Tacc & result_,
+                Tacc identity_,
+                AccFuncT acc_func_,
+                CombineT combine_
+                ):
+            operands(operands_),
+            result(result_),
+            identity(identity_),
+            acc_func(acc_func_),
+            combine(combine_)
+        {
+            this->accesses = pipeline_accesses<ndims>(operands, 0, std::make_index_sequence<NOPERANDS>());
+        }
+
+        void
+        begin_run(long ntiles) override {
+            partials.assign(ntiles, reduce_slot<Tacc> {identity});
+        }
+
+        void
+        run_tile(pipeline_tile const & tile) override {
+            Tacc & acc = partials[tile.index].val;
+            AccFuncT & f = acc_func;
+            nforeach_base(
+                        serial_policy(),
+                        pipeline_tile_views(operands, tile, std::make_index_sequence<NOPERANDS>()),
+                        [&acc, &f] (auto & ... vals) {
+                            f(acc, vals...);
+                        });
+        }
+
+        void
+        end_run() override {
+            result = partials.empty()? identity : tree_combine(partials, combine);
+            partials.clear();
+        }
+    };
+
+    //uses of a temporary, in steps or in stages
+    struct pipeline_interval {
+        long temp_id;
+        long first;
+        long last;
+        size_t bytes;
+    };
+
+    inline
+    size_t
+    round_to_cache_line(size_t bytes) {
+        return (bytes+CACHE_LINE_SIZE-1)/CACHE_LINE_SIZE*CACHE_LINE_SIZE;
+    }
+
+    /**
+     * @brief Gives the same memory to temporaries which are never used at the same time (greedy
+     *  allocation in order of first use), sets their offsets and returns the total size in bytes.
+     */
+    inline
+    size_t
+    assign_pipeline_slots(std::vector<pipeline_interval> intervals, std::vector<size_t> & offsets) {
+        std::sort(intervals.begin(), intervals.end(), [] (pipeline_interval const & a, pipeline_interval const & b) {
+            return a.first < b.first;
+        });
+
+        struct slot {
+            long last;
+            size_t bytes;
+            std::vector<long> temp_ids;
+        };
+        std::vector<slot> slots;
+
+        for (pipeline_interval const & interval : intervals) {
+            auto it = std::find_if(slots.begin(), slots.end(), [&] (slot const & s) {
+                return s.last < interval.first;
+            });
+            if (it == slots.end()) {
+                slots.push_back(slot {interval.last, interval.bytes, {interval.temp_id}});
+            } else {
+                it->last = interval.last;
+                it->bytes = std::max(it->bytes, interval.bytes);
+                it->temp_ids.push_back(interval.temp_id);
+            }
+        }
+
+        size_t offset = 0;
+        for (slot const & s : slots) {
+            for (long id : s.temp_ids) {
+                offsets[id] = offset;
+            }
+            offset += round_to_cache_line(s.bytes);
+        }
+        return offset;
+    }
+
+    /**
+     * @brief Bytes aligned on a cache line.
+     */
+    struct pipeline_buffer {
+        std::vector<unsigned char> bytes;
+
+        explicit
+        pipeline_buffer(size_t size):
+            bytes(size+CACHE_LINE_SIZE)
+        { }
+
+        unsigned char *
+        data() {
+            std::uintptr_t misalignment = reinterpret_cast<std::uintptr_t>(bytes.data())%CACHE_LINE_SIZE;
+            return bytes.data() + (CACHE_LINE_SIZE-misalignment)%CACHE_LINE_SIZE;
+        }
+    };
+
+} //end namespace helpers
+
+
+/**
+ * @brief A sequence of elementwise loops and reductions over arrays of a common shape (the grid), recorded
+ *  and then run as a whole.
+ *
+ * Instead of one pass over memory per loop, the grid is cut into tiles and all the steps of a stage run on
+ * a tile before moving to the next one, so that the operands of a tile are still in cache from one step to
+ * the next. A tile is a range along the outermost axis whose inner slab (the axes after it) fits in the tile
+ * size, at one position of the flattened axes before it: the tiles of a (2, 4096, 4096) grid are a few rows
+ * of one of the two slabs, and there are enough of them for all the threads. Intermediate arrays are temporaries, which only need
+ * the memory of the tiles being processed, shared by temporaries which are not alive at the same time.
+ * In parallel the threads run whole tiles.
+ *
+ * npipeline<2> p (make_indexer(ny, nx));
+ * auto grad2 = p.temporary<float>();
+ * p.transform(grad2, std::tie(gx, gy), [] (float x, float y) {return x*x + y*y;});
+ * p.transform(u, std::tie(u, grad2), [dt] (float v, float g) {return v - dt*g;});
+ * p.reduce(std::tie(grad2), energy, 0., [] (double & acc, float g) {acc += g;}, [] (double a, double b) {return a+b;});
+ * p.run(parallel_policy());
+ *
+ * A step reading an element written by an earlier step of the same stage at another position (a shifted
+ * slice of a container written before, for instance) can't run tile by tile: such a step starts a new
+ * stage, which only begins once the previous one has been run on the whole grid. Temporaries used by
+ * several stages then take the memory of the whole grid. The results of the reductions are written at
+ * the end of their stage: call sync() before recording steps that use them.
+ *
+ * The containers are referenced, not copied, and must outlive the pipeline. The temporaries must be of a
+ * trivial type, they are uninitialized until written.
+ */
+template <long ndims>
+struct npipeline {
+    static_assert(ndims != DYNAMICALLY_SIZED and ndims > 0, "not implemented");
+
+    indexer<ndims> grid_;
+
+    long tile_size_;
+
+    std::vector<std::unique_ptr<helpers::pipeline_step<ndims>>> steps_;
+
+    //index of the first step of each stage
+    std::vector<size_t> stage_begins_;
+
+    //element size of the temporaries and the steps where they are first and last used
+    std::vector<helpers::pipeline_interval> temps_;
+
+    /**
+     * @brief grid: shape of the loops. tile_size: number of elements of a tile, rounded down to whole
+     *  slabs of the axes after the axis along which the tiles are cut (at least one slab).
+     */
+    explicit
+    npipeline(indexer<ndims> grid, long tile_size = PIPELINE_TILE_SIZE):
+        grid_(grid.get_shape()),
+        tile_size_(tile_size),
+        stage_begins_ {0}
+    { }
+
+    /**
+     * @brief A new intermediate array of the shape of the grid.
+     */
+    template <typename T>
+    npipeline_temp<T>
+    temporary() {
+        static_assert(std::is_trivial<T>::value, "pipeline temporaries must be of a trivial type");
+        long id = long(temps_.size());
+        temps_.push_back(helpers::pipeline_interval {id, -1, -1, sizeof(T)});
+        return npipeline_temp<T> {id};
+    }
+
+    /**
+     * @brief Records out = func(ins...) elementwise. out is a container with the shape of the grid or a
+     *  temporary, the inputs are containers broadcastable to the grid or temporaries.
+     */
+    template <
+        typename OutT,
+        typename ... InTs,
+        typename FuncT,
+        typename = typename std::enable_if<not helpers::is_tuple<OutT>::value>::type
+    >
+    npipeline &
+    transform(OutT & out, std::tuple<InTs...> ins, FuncT func) {
+        return add_foreach(
+                    std::tie(out),
+                    ins,
+                    [func] (auto & out_val, auto & ... vals) {
+                        out_val = func(vals...);
+                    });
+    }
+
+    /**
+     * @brief Records a loop with several outputs: func(ins...) returns a tuple of their values.
+     */
+    template <typename ... OutTs, typename ... InTs, typename FuncT>
+    npipeline &
+    transform(std::tuple<OutTs&...> outs, std::tuple<InTs...> ins, FuncT func) {
+        return add_foreach(outs, ins, helpers::multi_output_func<sizeof...(OutTs), FuncT> {func});
+    }
+
+    /**
+     * @brief Records the reduction of the elements of ins into result, see nreduce for acc_func,
+     *  combine and identity. result is written when the stage of the step ends.
+     */
+    template <typename ... InTs, typename Tacc, typename AccFuncT, typename CombineT>
+    npipeline &
+    reduce(std::tuple<InTs...> ins, Tacc & result, Tacc identity, AccFuncT acc_func, CombineT combine) {
+        auto operands = make_operands(ins);
+        add_step(std::unique_ptr<helpers::pipeline_step<ndims>>(
+                     new helpers::pipeline_reduce_step<ndims, Tacc, AccFuncT, CombineT, typename std::decay<decltype(operands)>::type>(
+                         operands, result, identity, acc_func, combine)
+                     ));
+        return *this;
+    }
+
+    /**
+     * @brief The following steps start a new stage, they see the results of all the steps recorded so far.
+     */
+    npipeline &
+    sync() {
+        if (stage_begins_.back() != steps_.size()) {
+            stage_begins_.push_back(steps_.size());
+        }
+        return *this;
+    }
+
+    size_t
+    num_stages() const {
+        return (stage_begins_.back() == steps_.size())? stage_begins_.size()-1 : stage_begins_.size();
+    }
+
+    /**
+     * @brief Runs the recorded steps, which are kept: the pipeline can be run again.
+     */
+    template <typename PolicyT = serial_policy>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    run(PolicyT const & policy = PolicyT()) {
+        auto shape = grid_.get_shape();
+
+        //axis along which the tiles are cut: the outermost one whose slab fits in a tile, an empty
+        //axis ends the slab so that it never has a size of 0
+        size_t axis = ndims-1;
+        long slab_size = 1;
+        while (axis > 0 and shape[axis] > 0 and slab_size*shape[axis] <= tile_size_) {
+            slab_size *= shape[axis];
+            --axis;
+        }
+        long n_outer = 1;
+        for (size_t i = 0; i < axis; ++i) {
+            n_outer *= shape[i];
+        }
+        const long slabs_per_tile = std::max(1l, tile_size_/slab_size);
+        const long tiles_per_outer = (shape[axis]+slabs_per_tile-1)/slabs_per_tile;
+        const long ntiles = (grid_.size() == 0)? 0 : n_outer*tiles_per_outer;
+
+        //temporaries used by a single stage only live in the tiles, the others span the grid
+        std::vector<helpers::pipeline_interval> tile_intervals, grid_intervals;
+        std::vector<bool> per_tile (temps_.size(), true);
+        for (helpers::pipeline_interval const & temp : temps_) {
+            if (temp.first < 0) {
+                continue;
+            }
+            long first_stage = stage_of(temp.first), last_stage = stage_of(temp.last);
+            if (first_stage == last_stage) {
+                tile_intervals.push_back({temp.temp_id, temp.first, temp.last, temp.bytes*size_t(slabs_per_tile*slab_size)});
+            } else {
+                per_tile[temp.temp_id] = false;
+                grid_intervals.push_back({temp.temp_id, first_stage, last_stage, temp.bytes*grid_.size()});
+            }
+        }
+
+        std::vector<size_t> offsets (temps_.size(), 0);
+        const size_t tile_bytes = helpers::assign_pipeline_slots(tile_intervals, offsets);
+        helpers::pipeline_buffer grid_buffer (helpers::assign_pipeline_slots(grid_intervals, offsets));
+
+        for (size_t istage = 0; istage < num_stages(); ++istage) {
+            size_t begin = stage_begins_[istage];
+            size_t end = (istage+1 < stage_begins_.size())? stage_begins_[istage+1] : steps_.size();
+
+            for (size_t istep = begin; istep < end; ++istep) {
+                steps_[istep]->begin_run(ntiles);
+            }
+
+            //runs the tiles [itile_begin, itile_end) with their own memory for the temporaries
+            auto run_tiles = [&] (long itile_begin, long itile_end) {
+                helpers::pipeline_buffer tile_buffer (tile_bytes);
+                std::vector<helpers::pipeline_temp_storage> temps (temps_.size());
+                for (size_t i = 0; i < temps_.size(); ++i) {
+                    temps[i].per_tile = per_tile[i];
+                    temps[i].data = (per_tile[i]? tile_buffer.data() : grid_buffer.data()) + offsets[i];
+                }
+
+                for (long itile = itile_begin; itile < itile_end; ++itile) {
+                    const long ichunk = itile%tiles_per_outer;
+                    helpers::pipeline_tile tile {
+                        itile,
+                        axis,
+                        itile/tiles_per_outer,
+                        ichunk*slabs_per_tile,
+                        std::min(shape[axis], (ichunk+1)*slabs_per_tile),
+                        &temps
+                    };
+                    for (size_t istep = begin; istep < end; ++istep) {
+                        steps_[istep]->run_tile(tile);
+                    }
+                }
+            };
+            run_stage(policy, ntiles, long(grid_.size()), run_tiles);
+
+            for (size_t istep = begin; istep < end; ++istep) {
+                steps_[istep]->end_run();
+            }
+        }
+    }
+
+    template <typename TupT>
+    auto
+    make_operands(TupT & tup) {
+        indexer<ndims> grid = grid_;
+        return tuple_utilities::tuple_transform(
+                    [grid] (auto & u) {
+                        return helpers::make_pipeline_operand(grid, u);
+                    },
+                    tup);
+    }
+
+    template <typename ... OutTs, typename ... InTs, typename BodyT>
+    npipeline &
+    add_foreach(std::tuple<OutTs&...> outs, std::tuple<InTs...> ins, BodyT body) {
+        auto out_operands = make_operands(outs);
+        check_outputs(out_operands, outs, std::index_sequence_for<OutTs...>());
+
+        auto operands = std::tuple_cat(out_operands, make_operands(ins));
+        add_step(std::unique_ptr<helpers::pipeline_step<ndims>>(
+                     new helpers::pipeline_foreach_step<ndims, BodyT, typename std::decay<decltype(operands)>::type>(
+                         operands, body, sizeof...(OutTs))
+                     ));
+        return *this;
+    }
+
+    //the outputs must not be broadcasted by the grid
+    template <typename OperandTupT, typename OutTupT, size_t ... Is>
+    void
+    check_outputs(OperandTupT const & operands, OutTupT & outs, std::index_sequence<Is...>) {
+        (void) std::initializer_list<int> {(check_output(std::get<Is>(operands), std::get<Is>(outs)), 0)...};
+    }
+
+    template <typename T, typename ContainerT, long ndims_u>
+    void
+    check_output(helpers::pipeline_operand<T, ndims> const & operand, ndatacontainer<ContainerT, T, ndims_u> & out) {
+        ndataview<T, ndims> v = operand.view;
+        helpers::check_output_shape(out.get_shape(), v.get_shape());
+    }
+
+    template <typename T>
+    void
+    check_output(helpers::pipeline_operand<T, ndims> const &, npipeline_temp<T> const &) { }
+
+    /**
+     * @brief Appends step to the current stage, or to a new one if it can't be fused with the steps
+     *  of the current stage.
+     */
+    void
+    add_step(std::unique_ptr<helpers::pipeline_step<ndims>> step) {
+        bool conflict = false;
+        for (size_t istep = stage_begins_.back(); istep < steps_.size(); ++istep) {
+            for (auto const & a : steps_[istep]->accesses) {
+                for (auto const & b : step->accesses) {
+                    conflict = conflict or helpers::pipeline_conflict(a, b);
+                }
+            }
+        }
+        if (conflict) {
+            stage_begins_.push_back(steps_.size());
+        }
+
+        long istep = long(steps_.size());
+        for (auto const & access : step->accesses) {
+            if (access.temp_id >= 0) {
+                helpers::pipeline_interval & temp = temps_[access.temp_id];
+                temp.first = (temp.first < 0)? istep : temp.first;
+                temp.last = istep;
+            }
+        }
+        steps_.push_back(std::move(step));
+    }
+
+    long
+    stage_of(long istep) const {
+        return long(std::upper_bound(stage_begins_.begin(), stage_begins_.end(), size_t(istep)) - stage_begins_.begin()) - 1;
+    }
+
+    template <typename FuncT>
+    void
+    run_stage(serial_policy const &, long ntiles, long, FuncT & run_tiles) {
+        run_tiles(0l, ntiles);
+    }
+
+    /**
+     * In parallel the tiles are split in a few blocks per thread, each block allocating the memory of
+     * its temporaries once.
+     */
+    template <typename FuncT>
+    void
+    run_stage(parallel_policy const & policy, long ntiles, long total, FuncT & run_tiles) {
+        const long nthreads = helpers::parallel_num_threads(policy);
+        if (total < policy.min_work or nthreads <= 1 or ntiles <= 1) {
+            run_tiles(0l, ntiles);
+            return;
+        }
+
+        const long nblocks = std::min(ntiles, nthreads*helpers::REDUCE_BLOCKS_PER_THREAD);
+        helpers::parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+            run_tiles(ntiles*iblock_begin/nblocks, ntiles*iblock_end/nblocks);
+        });
+    }
+};
+
+} //end namespace ndata
+
+#endif /* end of include guard: PIPELINE_HPP_R6KZ2MWD */
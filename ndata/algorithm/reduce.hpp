@@ -0,0 +1,672 @@
+/*! \file Contains reductions of ndatacontainers along a set of axes */
+#ifndef REDUCE_HPP_T5WQ8NLD
+#define REDUCE_HPP_T5WQ8NLD
+
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/numtype_adapter_fundamental.hpp"
+#include "ndata/algorithm/sequences.hpp"
+
+namespace ndata {
+
+/**
+ * @brief Tag requesting that the reduced axes are kept in the result with a size of 1, like numpy's keepdims.
+ */
+struct KEEPDIMS_T { };
+constexpr KEEPDIMS_T KEEPDIMS = KEEPDIMS_T();
+
+namespace helpers {
+
+    /**
+     * @brief View of the elements [begin, end) of v along axis.
+     */
+    template <typename T, long ndims>
+    ndataview<T, ndims>
+    axis_subview(ndataview<T, ndims> v, size_t axis, long begin, long end) {
+        auto shape = v.get_shape();
+        auto strides = v.get_strides();
+        shape[axis] = end-begin;
+        return ndataview<T, ndims>(
+                    indexer<ndims>(v.get_start_index()+begin*strides[axis], shape, strides),
+                    v.data_
+                    );
+    }
+
+    template <typename ... Ts, long ndims>
+    std::tuple<ndataview<Ts, ndims>...>
+    axis_subviews(std::tuple<ndataview<Ts, ndims>...> views, size_t axis, long begin, long end) {
+        return tuple_utilities::tuple_transform(
+                    [=] (auto v) {return axis_subview(v, axis, begin, end);},
+                    views
+                    );
+    }
+
+    /**
+     * @brief Folds the elements of the operands into the accumulators of out with acc_func(acc, vals...).
+     *  out has the shape of the operands and zero strides along the reduced axes, its accumulators must
+     *  be initialized with identity.
+     *
+     * The loop planner takes care of the traversal order: when a contiguous axis is reduced it ends up
+     * innermost and each accumulator stays in a register for the whole row, otherwise the rows of out are
+     * updated as a whole for each position along the reduced axes.
+     */
+    template <typename Tacc, long ndims, typename ... Ts, typename AccFuncT, typename CombineT>
+    void
+    fold_axes(
+            serial_policy const & policy,
+            ndataview<Tacc, ndims> out,
+            std::tuple<ndataview<Ts, ndims>...> ops,
+            Tacc const &, //identity
+            AccFuncT & acc_func,
+            CombineT & //combine
+            )
+    {
+        nforeach_accumulate(
+            policy,
+            std::tuple_cat(std::make_tuple(out), ops),
+            [&acc_func] (Tacc & acc, auto & ... vals) {
+                acc_func(acc, vals...);
+            });
+    }
+
+    /**
+     * In parallel, threads must not share accumulators. If a kept axis has at least one element per
+     * thread, it is split between the threads (the one with the largest stride in out, so that the parts
+     * are contiguous). Otherwise the longest reduced axis is split, each block folds into its own copy of
+     * the accumulators, and the copies are combined in block order.
+     */
+    template <typename Tacc, long ndims, typename ... Ts, typename AccFuncT, typename CombineT>
+    void
+    fold_axes(
+            parallel_policy const & policy,
+            ndataview<Tacc, ndims> out,
+            std::tuple<ndataview<Ts, ndims>...> ops,
+            Tacc const & identity,
+            AccFuncT & acc_func,
+            CombineT & combine
+            )
+    {
+        static_assert(ndims != DYNAMICALLY_SIZED, "not implemented");
+
+        auto shape = out.get_shape();
+        auto out_strides = out.get_strides();
+
+        long total = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            total *= shape[i];
+        }
+
+        const long nthreads = parallel_num_threads(policy);
+        if (total == 0 or total < policy.min_work or nthreads <= 1) {
+            fold_axes(serial_policy(), out, ops, identity, acc_func, combine);
+            return;
+        }
+
+        auto nblocks_along = [&] (long extent) {
+            long n = (policy.chunk_size > 0)? total/policy.chunk_size : nthreads*REDUCE_BLOCKS_PER_THREAD;
+            return std::max(1l, std::min(extent, n));
+        };
+
+        long kept_axis = -1;
+        long reduced_axis = -1;
+        for (long i = 0; i < long(ndims); ++i) {
+            if (shape[i] <= 1) {
+                continue;
+            }
+            if (out_strides[i] != 0) {
+                if (shape[i] >= nthreads
+                        and (kept_axis < 0 or std::labs(out_strides[i]) > std::labs(out_strides[kept_axis]))) {
+                    kept_axis = i;
+                }
+            } else if (reduced_axis < 0 or shape[i] > shape[reduced_axis]) {
+                reduced_axis = i;
+            }
+        }
+
+        if (kept_axis >= 0) {
+            const long extent = shape[kept_axis];
+            const long nblocks = nblocks_along(extent);
+
+            parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+                long begin = extent*iblock_begin/nblocks;
+                long end = extent*iblock_end/nblocks;
+                fold_axes(
+                            serial_policy(),
+                            axis_subview(out, kept_axis, begin, end),
+                            axis_subviews(ops, kept_axis, begin, end),
+                            identity,
+                            acc_func,
+                            combine
+                            );
+            });
+            return;
+        }
+
+        if (reduced_axis < 0) {
+            fold_axes(serial_policy(), out, ops, identity, acc_func, combine);
+            return;
+        }
+
+        const long extent = shape[reduced_axis];
+        const long nblocks = nblocks_along(extent);
+
+        //the accumulators themselves, without the broadcasting
+        auto out_acc = out;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            if (out_strides[i] == 0) {
+                out_acc = axis_subview(out_acc, i, 0, 1);
+            }
+        }
+
+        //block 0 folds into out
+        std::vector<nvector<Tacc, ndims>> partials;
+        for (long iblock = 1; iblock < nblocks; ++iblock) {
+            partials.push_back(nvector<Tacc, ndims>(indexer<ndims>(out_acc.get_shape()), identity));
+        }
+
+        auto block_out = [&] (long iblock) {
+            if (iblock == 0) {
+                return out;
+            }
+            auto & partial = partials[iblock-1];
+            auto strides = partial.get_strides();
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                if (out_strides[i] == 0) {
+                    strides[i] = 0;
+                }
+            }
+            return partial.reshape(shape, strides);
+        };
+
+        parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+            for (long iblock = iblock_begin; iblock < iblock_end; ++iblock) {
+                long begin = extent*iblock/nblocks;
+                long end = extent*(iblock+1)/nblocks;
+                fold_axes(
+                            serial_policy(),
+                            axis_subview(block_out(iblock), reduced_axis, begin, end),
+                            axis_subviews(ops, reduced_axis, begin, end),
+                            identity,
+                            acc_func,
+                            combine
+                            );
+            }
+        });
+
+        for (auto & partial: partials) {
+            nforeach(
+                policy,
+                std::make_tuple(out_acc, partial.as_view()),
+                [&combine] (Tacc & acc, Tacc & acc_block) {
+                    acc = combine(acc, acc_block);
+                });
+        }
+    }
+
+    template <long ndims, long naxes>
+    vecarray<bool, ndims>
+    reduced_axes_mask(vecarray<size_t, naxes> axes) {
+        static_assert(ndims != DYNAMICALLY_SIZED and naxes != DYNAMICALLY_SIZED, "not implemented");
+
+        vecarray<bool, ndims> reduced (STATICALLY_SIZED, false);
+        for (size_t iax = 0; iax < axes.size(); ++iax) {
+            assert(axes[iax] < size_t(ndims));
+            assert(not reduced[axes[iax]]);
+            reduced[axes[iax]] = true;
+        }
+        return reduced;
+    }
+
+    /**
+     * @brief Result of a reduction of an array of the given shape, with ndims_ret dimensions:
+     *  either the shape without the reduced axes, or with a size of 1 along them.
+     */
+    template <typename Tacc, long ndims_ret, long ndims>
+    nvector<Tacc, ndims_ret>
+    make_reduced_nvector(vecarray<long, ndims> shape, vecarray<bool, ndims> reduced, Tacc identity) {
+        vecarray<long, ndims_ret> ret_shape (STATICALLY_SIZED);
+        for (size_t i = 0, j = 0; i < size_t(ndims); ++i) {
+            if (ndims_ret == ndims) {
+                ret_shape[j++] = reduced[i]? 1 : shape[i];
+            } else if (not reduced[i]) {
+                ret_shape[j++] = shape[i];
+            }
+        }
+        return nvector<Tacc, ndims_ret>(indexer<ndims_ret>(ret_shape), identity);
+    }
+
+    /**
+     * @brief Folds the operands (all of the same shape) into ret, the result of make_reduced_nvector.
+     */
+    template <
+        typename PolicyT,
+        typename Tacc,
+        long ndims_ret,
+        typename ... Ts,
+        long ndims,
+        typename AccFuncT,
+        typename CombineT
+    >
+    void
+    fold_axes_into(
+            PolicyT const & policy,
+            nvector<Tacc, ndims_ret> & ret,
+            vecarray<bool, ndims> reduced,
+            std::tuple<ndataview<Ts, ndims>...> ops,
+            Tacc const & identity,
+            AccFuncT & acc_func,
+            CombineT & combine
+            )
+    {
+        auto ret_strides = ret.get_strides();
+
+        //ret broadcasted to the shape of the operands
+        vecarray<long, ndims> bc_strides (STATICALLY_SIZED, 0l);
+        for (size_t i = 0, j = 0; i < size_t(ndims); ++i) {
+            if (ndims_ret == ndims) {
+                bc_strides[i] = reduced[i]? 0 : ret_strides[j];
+                ++j;
+            } else if (not reduced[i]) {
+                bc_strides[i] = ret_strides[j++];
+            }
+        }
+
+        fold_axes(
+                    policy,
+                    ret.reshape(std::get<0>(ops).get_shape(), bc_strides),
+                    ops,
+                    identity,
+                    acc_func,
+                    combine
+                    );
+    }
+
+    template <long ndims_ret, typename PolicyT, typename ContainerT, typename T, long ndims, typename Tacc, typename AccFuncT, typename CombineT>
+    nvector<Tacc, ndims_ret>
+    reduce_axes_impl(
+            PolicyT const & policy,
+            ndatacontainer<ContainerT, T, ndims> const & u,
+            vecarray<bool, ndims> reduced,
+            Tacc identity,
+            AccFuncT & acc_func,
+            CombineT & combine
+            )
+    {
+        auto ret = make_reduced_nvector<Tacc, ndims_ret>(u.get_shape(), reduced, identity);
+        fold_axes_into(policy, ret, reduced, std::make_tuple(u.as_view()), identity, acc_func, combine);
+        return ret;
+    }
+
+    /**
+     * @brief Number of elements reduced into each element of the result.
+     */
+    template <long ndims>
+    long
+    reduced_count(vecarray<long, ndims> shape, vecarray<bool, ndims> reduced) {
+        long count = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            if (reduced[i]) {
+                count *= shape[i];
+            }
+        }
+        return count;
+    }
+
+    template <long ndims_ret, typename PolicyT, typename ContainerT, typename T, long ndims>
+    nvector<T, ndims_ret>
+    mean_axes_impl(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<bool, ndims> reduced) {
+        auto acc_func = [] (T & acc, T val) {acc += val;};
+        auto combine = [] (T a, T b) -> T {return a+b;};
+
+        auto ret = reduce_axes_impl<ndims_ret>(policy, u, reduced, numtype_adapter<T>::ZERO, acc_func, combine);
+
+        const long count = reduced_count(u.get_shape(), reduced);
+        nforeach(policy, std::tie(ret), [count] (T & val) {val /= count;});
+        return ret;
+    }
+
+    /**
+     * @brief Index along axis of the first element of u for which better(val, current_best) never holds
+     *  for the following ones. Throws on an empty axis, which has no such element.
+     */
+    template <long ndims_ret, typename PolicyT, typename ContainerT, typename T, long ndims, typename BetterT>
+    nvector<long, ndims_ret>
+    arg_best_impl(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, BetterT better) {
+        static_assert(ndims != DYNAMICALLY_SIZED, "not implemented");
+        assert(axis < size_t(ndims));
+
+        typedef std::pair<T, long> acc_t;
+
+        auto shape = u.get_shape();
+        if (shape[axis] == 0) {
+            throw std::domain_error("nargmax/nargmin: the axis is empty");
+        }
+
+        //index along axis, broadcasted to the shape of u
+        auto iota = numrange(0l, shape[axis]);
+        vecarray<long, ndims> iota_strides (STATICALLY_SIZED, 0l);
+        iota_strides[axis] = 1;
+        ndataview<long, ndims> indices (indexer<ndims>(0, shape, iota_strides), &iota.data_[0]);
+
+        vecarray<bool, ndims> reduced (STATICALLY_SIZED, false);
+        reduced[axis] = true;
+
+        //index -1 marks the identity
+        acc_t identity (T(), -1);
+
+        auto acc_func = [better] (acc_t & acc, T val, long i) {
+            if (acc.second < 0 or better(val, acc.first)) {
+                acc = acc_t(val, i);
+            }
+        };
+
+        //blocks are combined in axis order, so ties go to the left one
+        auto combine = [better] (acc_t a, acc_t b) {
+            if (a.second < 0 or (b.second >= 0 and better(b.first, a.first))) {
+                return b;
+            }
+            return a;
+        };
+
+        auto best = make_reduced_nvector<acc_t, ndims_ret>(shape, reduced, identity);
+        fold_axes_into(policy, best, reduced, std::make_tuple(u.as_view(), indices), identity, acc_func, combine);
+
+        return ntransform<long>(policy, std::tie(best), [] (acc_t const & b) {return b.second;});
+    }
+
+    template <typename PolicyT>
+    using enable_if_policy = typename std::enable_if<is_execution_policy<PolicyT>::value>::type;
+
+} //end namespace helpers
+
+
+/**
+ * @brief Reduces u along the given axes, which are removed from the result.
+ *
+ * acc_func(acc, val) folds an element into an accumulator of type Tacc initialized with identity,
+ * combine(acc1, acc2) merges two accumulators (see nreduce).
+ */
+template <
+    typename PolicyT,
+    typename ContainerT,
+    typename T,
+    long ndims,
+    long naxes,
+    typename Tacc,
+    typename AccFuncT,
+    typename CombineT,
+    typename = helpers::enable_if_policy<PolicyT>
+>
+nvector<Tacc, ndims-naxes>
+nreduce_axes(
+        PolicyT const & policy,
+        ndatacontainer<ContainerT, T, ndims> const & u,
+        vecarray<size_t, naxes> axes,
+        Tacc identity,
+        AccFuncT acc_func,
+        CombineT combine
+        )
+{
+    auto reduced = helpers::reduced_axes_mask<ndims>(axes);
+    return helpers::reduce_axes_impl<ndims-naxes>(policy, u, reduced, identity, acc_func, combine);
+}
+
+/**
+ * @brief Same as nreduce_axes, the reduced axes are kept in the result with a size of 1.
+ */
+template <
+    typename PolicyT,
+    typename ContainerT,
+    typename T,
+    long ndims,
+    long naxes,
+    typename Tacc,
+    typename AccFuncT,
+    typename CombineT,
+    typename = helpers::enable_if_policy<PolicyT>
+>
+nvector<Tacc, ndims>
+nreduce_axes(
+        PolicyT const & policy,
+        ndatacontainer<ContainerT, T, ndims> const & u,
+        vecarray<size_t, naxes> axes,
+        KEEPDIMS_T,
+        Tacc identity,
+        AccFuncT acc_func,
+        CombineT combine
+        )
+{
+    auto reduced = helpers::reduced_axes_mask<ndims>(axes);
+    return helpers::reduce_axes_impl<ndims>(policy, u, reduced, identity, acc_func, combine);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes, typename Tacc, typename AccFuncT, typename CombineT>
+nvector<Tacc, ndims-naxes>
+nreduce_axes(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, Tacc identity, AccFuncT acc_func, CombineT combine) {
+    return nreduce_axes(serial_policy(), u, axes, identity, acc_func, combine);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes, typename Tacc, typename AccFuncT, typename CombineT>
+nvector<Tacc, ndims>
+nreduce_axes(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T, Tacc identity, AccFuncT acc_func, CombineT combine) {
+    return nreduce_axes(serial_policy(), u, axes, KEEPDIMS, identity, acc_func, combine);
+}
+
+/**
+ * @brief Sum of the elements of u along the given axes.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims-naxes>
+nsum(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                helpers::numtype_adapter<T>::ZERO,
+                [] (T & acc, T val) {acc += val;},
+                [] (T a, T b) -> T {return a+b;}
+                );
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nsum(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                KEEPDIMS,
+                helpers::numtype_adapter<T>::ZERO,
+                [] (T & acc, T val) {acc += val;},
+                [] (T a, T b) -> T {return a+b;}
+                );
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims-naxes>
+nsum(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return nsum(serial_policy(), u, axes);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims>
+nsum(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return nsum(serial_policy(), u, axes, KEEPDIMS);
+}
+
+/**
+ * @brief Mean of the elements of u along the given axes, computed in type T (truncated for integral types).
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims-naxes>
+nmean(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return helpers::mean_axes_impl<ndims-naxes>(policy, u, helpers::reduced_axes_mask<ndims>(axes));
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nmean(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return helpers::mean_axes_impl<ndims>(policy, u, helpers::reduced_axes_mask<ndims>(axes));
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims-naxes>
+nmean(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return nmean(serial_policy(), u, axes);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims>
+nmean(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return nmean(serial_policy(), u, axes, KEEPDIMS);
+}
+
+/**
+ * @brief Minimum of the elements of u along the given axes.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims-naxes>
+nmin(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    static_assert(std::numeric_limits<T>::is_specialized, "nmin requires std::numeric_limits<T>");
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                std::numeric_limits<T>::max(),
+                [] (T & acc, T val) {acc = (val < acc)? val : acc;},
+                [] (T a, T b) {return (b < a)? b : a;}
+                );
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nmin(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    static_assert(std::numeric_limits<T>::is_specialized, "nmin requires std::numeric_limits<T>");
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                KEEPDIMS,
+                std::numeric_limits<T>::max(),
+                [] (T & acc, T val) {acc = (val < acc)? val : acc;},
+                [] (T a, T b) {return (b < a)? b : a;}
+                );
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims-naxes>
+nmin(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return nmin(serial_policy(), u, axes);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims>
+nmin(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return nmin(serial_policy(), u, axes, KEEPDIMS);
+}
+
+/**
+ * @brief Maximum of the elements of u along the given axes.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims-naxes>
+nmax(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    static_assert(std::numeric_limits<T>::is_specialized, "nmax requires std::numeric_limits<T>");
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                std::numeric_limits<T>::lowest(),
+                [] (T & acc, T val) {acc = (acc < val)? val : acc;},
+                [] (T a, T b) {return (a < b)? b : a;}
+                );
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, long naxes, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nmax(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    static_assert(std::numeric_limits<T>::is_specialized, "nmax requires std::numeric_limits<T>");
+    return nreduce_axes(
+                policy,
+                u,
+                axes,
+                KEEPDIMS,
+                std::numeric_limits<T>::lowest(),
+                [] (T & acc, T val) {acc = (acc < val)? val : acc;},
+                [] (T a, T b) {return (a < b)? b : a;}
+                );
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims-naxes>
+nmax(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes) {
+    return nmax(serial_policy(), u, axes);
+}
+
+template <typename ContainerT, typename T, long ndims, long naxes>
+nvector<T, ndims>
+nmax(ndatacontainer<ContainerT, T, ndims> const & u, vecarray<size_t, naxes> axes, KEEPDIMS_T) {
+    return nmax(serial_policy(), u, axes, KEEPDIMS);
+}
+
+/**
+ * @brief Index of the maximum along axis, the first one in case of ties.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<long, ndims-1>
+nargmax(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis) {
+    return helpers::arg_best_impl<ndims-1>(policy, u, axis, [] (T const & a, T const & b) {return b < a;});
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<long, ndims>
+nargmax(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, KEEPDIMS_T) {
+    return helpers::arg_best_impl<ndims>(policy, u, axis, [] (T const & a, T const & b) {return b < a;});
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<long, ndims-1>
+nargmax(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis) {
+    return nargmax(serial_policy(), u, axis);
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<long, ndims>
+nargmax(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, KEEPDIMS_T) {
+    return nargmax(serial_policy(), u, axis, KEEPDIMS);
+}
+
+/**
+ * @brief Index of the minimum along axis, the first one in case of ties.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<long, ndims-1>
+nargmin(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis) {
+    return helpers::arg_best_impl<ndims-1>(policy, u, axis, [] (T const & a, T const & b) {return a < b;});
+}
+
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<long, ndims>
+nargmin(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, KEEPDIMS_T) {
+    return helpers::arg_best_impl<ndims>(policy, u, axis, [] (T const & a, T const & b) {return a < b;});
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<long, ndims-1>
+nargmin(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis) {
+    return nargmin(serial_policy(), u, axis);
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<long, ndims>
+nargmin(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, KEEPDIMS_T) {
+    return nargmin(serial_policy(), u, axis, KEEPDIMS);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: REDUCE_HPP_T5WQ8NLD */
@@ -0,0 +1,357 @@
+/*! \file Contains rolling window aggregates (moving sums, means, variances, minima and maxima) of
+ *  ndatacontainers along an axis */
+#ifndef ROLLING_HPP_QF3YB8TN
+#define ROLLING_HPP_QF3YB8TN
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/numtype_adapter_fundamental.hpp"
+#include "ndata/algorithm/reduce.hpp"
+#include "ndata/algorithm/scan.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    //running mean and sum of squared deviations of a window
+    template <typename T>
+    struct rolling_moments {
+        T mean;
+        T m2;
+    };
+
+    template <long ndims>
+    vecarray<long, ndims>
+    rolling_shape(vecarray<long, ndims> shape, size_t axis, long window) {
+        assert(axis < shape.size());
+        if (window < 1 or window > shape[axis]) {
+            throw std::domain_error("rolling: the window must hold between 1 and the length of the axis elements");
+        }
+        shape[axis] -= window-1;
+        return shape;
+    }
+
+    /**
+     * @brief Moving sums of the windows of in along axis into out. Each sum is the previous one plus the
+     *  element entering the window minus the one leaving it, the lines being visited in order like in
+     *  scan_lines.
+     */
+    template <typename T, long ndims>
+    void
+    rolling_sum_lines(ndataview<T, ndims> out, ndataview<T const, ndims> in, size_t axis, long window) {
+        auto shape = in.get_shape();
+        const long n = shape[axis];
+        const T zero = numtype_adapter<T>::ZERO;
+
+        auto carry = make_scan_carry(shape, axis, zero);
+        auto carry_view = carry.as_view();
+
+        auto shape_window = shape;
+        shape_window[axis] = window;
+        nforeach_accumulate(
+            serial_policy(),
+            std::make_tuple(broadcast_scan_carry(carry, shape_window, axis), axis_subview(in, axis, 0, window)),
+            [] (T & c, T const & v) {
+                c += v;
+            });
+        nforeach(
+            serial_policy(),
+            std::make_tuple(axis_subview(out, axis, 0, 1), carry_view),
+            [] (T & o, T const & c) {
+                o = c;
+            });
+
+        auto shape_rest = shape;
+        shape_rest[axis] = n-window;
+        nforeach_accumulate(
+            serial_policy(),
+            std::make_tuple(
+                broadcast_scan_carry(carry, shape_rest, axis),
+                axis_subview(out, axis, 1, n-window+1),
+                axis_subview(in, axis, window, n),
+                axis_subview(in, axis, 0, n-window)
+                ),
+            [] (T & c, T & o, T const & entering, T const & leaving) {
+                c += entering-leaving;
+                o = c;
+            });
+    }
+
+    /**
+     * @brief Moving variances, from the mean and sum of squared deviations of each window updated with the
+     *  fixed size Welford recurrence (more accurate than differences of sums of squares).
+     */
+    template <typename T, long ndims>
+    void
+    rolling_var_lines(ndataview<T, ndims> out, ndataview<T const, ndims> in, size_t axis, long window, long ddof) {
+        auto shape = in.get_shape();
+        const long n = shape[axis];
+        const T w = T(window);
+        const T denom = T(window-ddof);
+        const T zero = numtype_adapter<T>::ZERO;
+
+        auto carry = make_scan_carry(shape, axis, rolling_moments<T>{zero, zero});
+
+        auto shape_window = shape;
+        shape_window[axis] = window;
+        auto first_window = std::make_tuple(broadcast_scan_carry(carry, shape_window, axis), axis_subview(in, axis, 0, window));
+        nforeach_accumulate(serial_policy(), first_window, [w] (rolling_moments<T> & c, T const & v) {
+            c.mean += v/w;
+        });
+        nforeach_accumulate(serial_policy(), first_window, [] (rolling_moments<T> & c, T const & v) {
+            c.m2 += (v-c.mean)*(v-c.mean);
+        });
+        nforeach(
+            serial_policy(),
+            std::make_tuple(axis_subview(out, axis, 0, 1), carry.as_view()),
+            [zero, denom] (T & o, rolling_moments<T> const & c) {
+                o = std::max(c.m2, zero)/denom;
+            });
+
+        auto shape_rest = shape;
+        shape_rest[axis] = n-window;
+        nforeach_accumulate(
+            serial_policy(),
+            std::make_tuple(
+                broadcast_scan_carry(carry, shape_rest, axis),
+                axis_subview(out, axis, 1, n-window+1),
+                axis_subview(in, axis, window, n),
+                axis_subview(in, axis, 0, n-window)
+                ),
+            [w, zero, denom] (rolling_moments<T> & c, T & o, T const & entering, T const & leaving) {
+                T delta = entering-leaving;
+                T old_mean = c.mean;
+                c.mean += delta/w;
+                c.m2 += delta*(entering-c.mean+leaving-old_mean);
+                o = std::max(c.m2, zero)/denom;
+            });
+    }
+
+    /**
+     * @brief Moving extrema with a monotone deque per line: the deque holds the positions of the elements
+     *  that can still become the extremum of a window, keep(a, b) being true if a must be kept before b
+     *  (a > b for the maximum). Each element enters and leaves the deque once.
+     *
+     * The lines are walked one at a time, from the data of the views and their strides.
+     */
+    template <typename T, long ndims, typename KeepT>
+    void
+    rolling_extremum_lines(ndataview<T, ndims> out, ndataview<T const, ndims> in, size_t axis, long window, KeepT keep) {
+        auto shape = in.get_shape();
+        auto in_strides = in.get_strides();
+        auto out_strides = out.get_strides();
+        const long n = shape[axis];
+        const long in_stride = in_strides[axis];
+        const long out_stride = out_strides[axis];
+
+        long nlines = 1;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            nlines *= (i == axis)? 1 : shape[i];
+        }
+
+        T const * in_data = in.data_ + in.get_start_index();
+        T * out_data = out.data_ + out.get_start_index();
+
+        //ring buffer of positions, the deque never holds more than window of them
+        std::vector<long> deque (window);
+
+        for (long iline = 0; iline < nlines; ++iline) {
+            //first elements of the line, from its index in C order over the other axes
+            long in_offset = 0, out_offset = 0;
+            long rem = iline;
+            for (size_t i = shape.size(); i-- > 0; ) {
+                if (i != axis) {
+                    in_offset += (rem%shape[i])*in_strides[i];
+                    out_offset += (rem%shape[i])*out_strides[i];
+                    rem /= shape[i];
+                }
+            }
+
+            T const * line = in_data + in_offset;
+            T * out_line = out_data + out_offset;
+            long front = 0, size = 0;
+
+            for (long i = 0; i < n; ++i) {
+                //the element leaving the window, before making room for the new one
+                if (size > 0 and deque[front] <= i-window) {
+                    front = (front+1)%window;
+                    --size;
+                }
+
+                T const & v = line[i*in_stride];
+                while (size > 0 and not keep(line[deque[(front+size-1)%window]*in_stride], v)) {
+                    --size;
+                }
+                deque[(front+size)%window] = i;
+                ++size;
+
+                if (i >= window-1) {
+                    out_line[(i-window+1)*out_stride] = line[deque[front]*in_stride];
+                }
+            }
+        }
+    }
+
+    template <long ndims, typename Tout, typename T, typename KernelT>
+    void
+    rolling_axis(serial_policy const &, ndataview<Tout, ndims> out, ndataview<T, ndims> in, size_t, KernelT & kernel) {
+        kernel(out, in);
+    }
+
+    /**
+     * In parallel, the lines are split between the threads along another axis with at least one element
+     * per thread (the one with the largest stride in out). The windows of a line depend on each other,
+     * a single line is computed serially.
+     */
+    template <long ndims, typename Tout, typename T, typename KernelT>
+    void
+    rolling_axis(parallel_policy const & policy, ndataview<Tout, ndims> out, ndataview<T, ndims> in, size_t axis, KernelT & kernel) {
+        static_assert(ndims != DYNAMICALLY_SIZED, "not implemented");
+
+        auto shape = in.get_shape();
+        auto out_strides = out.get_strides();
+
+        long total = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            total *= shape[i];
+        }
+
+        const long nthreads = parallel_num_threads(policy);
+
+        long split_axis = -1;
+        for (long i = 0; i < long(ndims); ++i) {
+            if (i != long(axis) and shape[i] >= nthreads
+                    and (split_axis < 0 or std::labs(out_strides[i]) > std::labs(out_strides[split_axis]))) {
+                split_axis = i;
+            }
+        }
+
+        if (total == 0 or total < policy.min_work or nthreads <= 1 or split_axis < 0) {
+            kernel(out, in);
+            return;
+        }
+
+        const long extent = shape[split_axis];
+        long n = (policy.chunk_size > 0)? total/policy.chunk_size : nthreads*REDUCE_BLOCKS_PER_THREAD;
+        const long nblocks = std::max(1l, std::min(extent, n));
+
+        parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+            long begin = extent*iblock_begin/nblocks;
+            long end = extent*iblock_end/nblocks;
+            kernel(axis_subview(out, split_axis, begin, end), axis_subview(in, split_axis, begin, end));
+        });
+    }
+
+    template <typename PolicyT, typename ContainerT, typename T, long ndims, typename KernelT>
+    nvector<T, ndims>
+    rolling(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window, KernelT kernel) {
+        nvector<T, ndims> ret (indexer<ndims>(rolling_shape(u.get_shape(), axis, window)), UNINITIALIZED);
+        rolling_axis(policy, ret.as_view(), u.as_view(), axis, kernel);
+        return ret;
+    }
+
+} //end namespace helpers
+
+
+/**
+ * @brief Moving sums of window consecutive elements along axis. Element i of the result along axis is the
+ *  sum of the elements i to i+window-1 of u, the result has shape[axis]-window+1 elements along axis (the
+ *  windows of sliding_window_view).
+ *
+ * The cost doesn't depend on window: each sum is computed from the previous one. With floating point data
+ * the sums can drift from the exact ones by a few ulps of the largest partial sums.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nrolling_sum(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return helpers::rolling(policy, u, axis, window, [axis, window] (ndataview<T, ndims> out, ndataview<T const, ndims> in) {
+        helpers::rolling_sum_lines(out, in, axis, window);
+    });
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+nrolling_sum(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return nrolling_sum(serial_policy(), u, axis, window);
+}
+
+/**
+ * @brief Moving means of window consecutive elements along axis, see nrolling_sum.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nrolling_mean(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    auto ret = nrolling_sum(policy, u, axis, window);
+    const T w = T(window);
+    nforeach(policy, std::tie(ret), [w] (T & v) {
+        v /= w;
+    });
+    return ret;
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+nrolling_mean(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return nrolling_mean(serial_policy(), u, axis, window);
+}
+
+/**
+ * @brief Moving variances of window consecutive elements along axis, see nrolling_sum. The sums of squared
+ *  deviations are divided by window-ddof (ddof = 1 for the unbiased estimator).
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nrolling_var(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window, long ddof = 0) {
+    if (ddof >= window) {
+        throw std::domain_error("nrolling_var: ddof must be smaller than the window");
+    }
+    return helpers::rolling(policy, u, axis, window, [axis, window, ddof] (ndataview<T, ndims> out, ndataview<T const, ndims> in) {
+        helpers::rolling_var_lines(out, in, axis, window, ddof);
+    });
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+nrolling_var(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window, long ddof = 0) {
+    return nrolling_var(serial_policy(), u, axis, window, ddof);
+}
+
+/**
+ * @brief Moving minima of window consecutive elements along axis, see nrolling_sum.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nrolling_min(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return helpers::rolling(policy, u, axis, window, [axis, window] (ndataview<T, ndims> out, ndataview<T const, ndims> in) {
+        helpers::rolling_extremum_lines(out, in, axis, window, [] (T const & a, T const & b) {return a < b;});
+    });
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+nrolling_min(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return nrolling_min(serial_policy(), u, axis, window);
+}
+
+/**
+ * @brief Moving maxima of window consecutive elements along axis, see nrolling_sum.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+nrolling_max(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return helpers::rolling(policy, u, axis, window, [axis, window] (ndataview<T, ndims> out, ndataview<T const, ndims> in) {
+        helpers::rolling_extremum_lines(out, in, axis, window, [] (T const & a, T const & b) {return a > b;});
+    });
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+nrolling_max(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, long window) {
+    return nrolling_max(serial_policy(), u, axis, window);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: ROLLING_HPP_QF3YB8TN */
@@ -0,0 +1,325 @@
+/*! \file Contains prefix scans (cumulative sums, products...) of ndatacontainers along an axis */
+#ifndef SCAN_HPP_H4NQ7WZE
+#define SCAN_HPP_H4NQ7WZE
+
+#include <vector>
+#include "ndata.hpp"
+#include "ndata/algorithm/numtype_adapter_fundamental.hpp"
+#include "ndata/algorithm/reduce.hpp"
+
+namespace ndata {
+
+/**
+ * @brief INCLUSIVE: element i of the result includes element i of the input (cumsum of {1, 2, 3} is {1, 3, 6}).
+ *  EXCLUSIVE: it only includes the preceding ones, starting with the identity ({0, 1, 3}).
+ */
+enum class scan_mode {
+    INCLUSIVE,
+    EXCLUSIVE
+};
+
+namespace helpers {
+
+    /**
+     * @brief One running value per line along axis, initialized with identity.
+     */
+    template <typename Tacc, long ndims>
+    nvector<Tacc, ndims>
+    make_scan_carry(vecarray<long, ndims> shape, size_t axis, Tacc const & identity) {
+        shape[axis] = 1;
+        return nvector<Tacc, ndims>(indexer<ndims>(shape), identity);
+    }
+
+    /**
+     * @brief carry broadcasted along axis to the given shape.
+     */
+    template <typename Tacc, long ndims>
+    ndataview<Tacc, ndims>
+    broadcast_scan_carry(nvector<Tacc, ndims> & carry, vecarray<long, ndims> shape, size_t axis) {
+        auto strides = carry.get_strides();
+        strides[axis] = 0;
+        return carry.reshape(shape, strides);
+    }
+
+    /**
+     * @brief Scans the lines of in along axis into out, carry holds the running value of each line
+     *  (broadcasted along axis) and is updated.
+     *
+     * The loop planner never reverses the direction of a dimension, so each line is visited in order
+     * whatever the nesting of the loops: in the inner loop when axis is contiguous (the carry then stays
+     * in a register, see nforeach_accumulate), otherwise the carries are updated row by row.
+     */
+    template <typename Tacc, long ndims, typename T, typename OpT>
+    void
+    scan_lines(
+            ndataview<Tacc, ndims> carry,
+            ndataview<Tacc, ndims> out,
+            ndataview<T, ndims> in,
+            OpT & op,
+            scan_mode mode
+            )
+    {
+        if (mode == scan_mode::INCLUSIVE) {
+            nforeach_accumulate(
+                serial_policy(),
+                std::make_tuple(carry, out, in),
+                [&op] (Tacc & c, Tacc & o, T const & v) {
+                    c = op(c, v);
+                    o = c;
+                });
+        } else {
+            nforeach_accumulate(
+                serial_policy(),
+                std::make_tuple(carry, out, in),
+                [&op] (Tacc & c, Tacc & o, T const & v) {
+                    o = c;
+                    c = op(c, v);
+                });
+        }
+    }
+
+    template <typename Tacc, long ndims, typename T, typename OpT>
+    void
+    scan_axis(
+            serial_policy const &,
+            ndataview<Tacc, ndims> out,
+            ndataview<T, ndims> in,
+            size_t axis,
+            Tacc const & identity,
+            OpT & op,
+            scan_mode mode
+            )
+    {
+        auto shape = in.get_shape();
+        auto carry = make_scan_carry(shape, axis, identity);
+        scan_lines(broadcast_scan_carry(carry, shape, axis), out, in, op, mode);
+    }
+
+    /**
+     * In parallel, if another axis has at least one element per thread, the lines are split between
+     * the threads along it (the one with the largest stride in out).
+     *
+     * Otherwise, when the scanned axis is long, it is split in blocks and scanned in two passes: the
+     * total of each block but the last is reduced in parallel, the totals are scanned serially into the
+     * starting value of each block, then the blocks are scanned in parallel from those. op must be
+     * associative and identity its neutral element.
+     */
+    template <typename Tacc, long ndims, typename T, typename OpT>
+    void
+    scan_axis(
+            parallel_policy const & policy,
+            ndataview<Tacc, ndims> out,
+            ndataview<T, ndims> in,
+            size_t axis,
+            Tacc const & identity,
+            OpT & op,
+            scan_mode mode
+            )
+    {
+        static_assert(ndims != DYNAMICALLY_SIZED, "not implemented");
+
+        auto shape = in.get_shape();
+        auto out_strides = out.get_strides();
+
+        long total = 1;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            total *= shape[i];
+        }
+
+        const long nthreads = parallel_num_threads(policy);
+        if (total == 0 or total < policy.min_work or nthreads <= 1) {
+            scan_axis(serial_policy(), out, in, axis, identity, op, mode);
+            return;
+        }
+
+        auto nblocks_along = [&] (long extent) {
+            long n = (policy.chunk_size > 0)? total/policy.chunk_size : nthreads*REDUCE_BLOCKS_PER_THREAD;
+            return std::max(1l, std::min(extent, n));
+        };
+
+        long split_axis = -1;
+        for (long i = 0; i < long(ndims); ++i) {
+            if (i != long(axis) and shape[i] >= nthreads
+                    and (split_axis < 0 or std::labs(out_strides[i]) > std::labs(out_strides[split_axis]))) {
+                split_axis = i;
+            }
+        }
+
+        auto carry = make_scan_carry(shape, axis, identity);
+        auto carry_bc = broadcast_scan_carry(carry, shape, axis);
+
+        if (split_axis >= 0) {
+            const long extent = shape[split_axis];
+            const long nblocks = nblocks_along(extent);
+
+            parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+                long begin = extent*iblock_begin/nblocks;
+                long end = extent*iblock_end/nblocks;
+                scan_lines(
+                            axis_subview(carry_bc, split_axis, begin, end),
+                            axis_subview(out, split_axis, begin, end),
+                            axis_subview(in, split_axis, begin, end),
+                            op,
+                            mode
+                            );
+            });
+            return;
+        }
+
+        const long extent = shape[axis];
+        const long nblocks = nblocks_along(extent);
+        if (nblocks < 2) {
+            scan_lines(carry_bc, out, in, op, mode);
+            return;
+        }
+
+        //starting value of each block, block 0 starts from carry
+        std::vector<nvector<Tacc, ndims>> starts;
+        for (long iblock = 1; iblock < nblocks; ++iblock) {
+            starts.push_back(make_scan_carry(shape, axis, identity));
+        }
+
+        auto block_carry = [&] (long iblock) {
+            return (iblock == 0)? carry_bc : broadcast_scan_carry(starts[iblock-1], shape, axis);
+        };
+        auto block_begin = [&] (long iblock) {
+            return extent*iblock/nblocks;
+        };
+
+        //first pass: starts[i] holds the total of block i
+        auto acc_func = [&op] (Tacc & acc, T const & v) {
+            acc = op(acc, v);
+        };
+        auto combine = [&op] (Tacc a, Tacc b) -> Tacc {
+            return op(a, b);
+        };
+
+        parallel_blocks(policy, nthreads, nblocks-1, [&] (long iblock_begin, long iblock_end) {
+            for (long iblock = iblock_begin; iblock < iblock_end; ++iblock) {
+                long begin = block_begin(iblock);
+                long end = block_begin(iblock+1);
+                fold_axes(
+                            serial_policy(),
+                            axis_subview(block_carry(iblock+1), axis, begin, end),
+                            std::make_tuple(axis_subview(in, axis, begin, end)),
+                            identity,
+                            acc_func,
+                            combine
+                            );
+            }
+        });
+
+        //the totals are turned into the starting values, in block order as op may not commute
+        for (long iblock = 2; iblock < nblocks; ++iblock) {
+            nforeach(
+                serial_policy(),
+                std::tie(starts[iblock-1], starts[iblock-2]),
+                [&op] (Tacc & start, Tacc const & previous_start) {
+                    start = op(previous_start, start);
+                });
+        }
+
+        //second pass
+        parallel_blocks(policy, nthreads, nblocks, [&] (long iblock_begin, long iblock_end) {
+            for (long iblock = iblock_begin; iblock < iblock_end; ++iblock) {
+                long begin = block_begin(iblock);
+                long end = block_begin(iblock+1);
+                scan_lines(
+                            axis_subview(block_carry(iblock), axis, begin, end),
+                            axis_subview(out, axis, begin, end),
+                            axis_subview(in, axis, begin, end),
+                            op,
+                            mode
+                            );
+            }
+        });
+    }
+
+} //end namespace helpers
+
+
+/**
+ * @brief Prefix scan of u along axis with the associative operation op(acc, val) -> Tacc, identity being
+ *  its neutral element. The result has the shape of u and is C contiguous, whatever the strides of u.
+ *
+ * nscan(u, 0, 0l, [] (long a, long b) {return a+b;}) is the cumulative sum along the first axis.
+ */
+template <
+    typename PolicyT,
+    typename ContainerT,
+    typename T,
+    long ndims,
+    typename Tacc,
+    typename OpT,
+    typename = helpers::enable_if_policy<PolicyT>
+>
+nvector<Tacc, ndims>
+nscan(
+        PolicyT const & policy,
+        ndatacontainer<ContainerT, T, ndims> const & u,
+        size_t axis,
+        Tacc identity,
+        OpT op,
+        scan_mode mode = scan_mode::INCLUSIVE
+        )
+{
+    assert(axis < u.get_shape().size());
+
+    nvector<Tacc, ndims> ret (indexer<ndims>(u.get_shape()), identity);
+    helpers::scan_axis(policy, ret.as_view(), u.as_view(), axis, identity, op, mode);
+    return ret;
+}
+
+template <typename ContainerT, typename T, long ndims, typename Tacc, typename OpT>
+nvector<Tacc, ndims>
+nscan(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, Tacc identity, OpT op, scan_mode mode = scan_mode::INCLUSIVE) {
+    return nscan(serial_policy(), u, axis, identity, op, mode);
+}
+
+/**
+ * @brief Cumulative sum along axis.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+ncumsum(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, scan_mode mode = scan_mode::INCLUSIVE) {
+    return nscan(
+                policy,
+                u,
+                axis,
+                helpers::numtype_adapter<T>::ZERO,
+                [] (T a, T b) -> T {return a+b;},
+                mode
+                );
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+ncumsum(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, scan_mode mode = scan_mode::INCLUSIVE) {
+    return ncumsum(serial_policy(), u, axis, mode);
+}
+
+/**
+ * @brief Cumulative product along axis.
+ */
+template <typename PolicyT, typename ContainerT, typename T, long ndims, typename = helpers::enable_if_policy<PolicyT>>
+nvector<T, ndims>
+ncumprod(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, scan_mode mode = scan_mode::INCLUSIVE) {
+    return nscan(
+                policy,
+                u,
+                axis,
+                T(1),
+                [] (T a, T b) -> T {return a*b;},
+                mode
+                );
+}
+
+template <typename ContainerT, typename T, long ndims>
+nvector<T, ndims>
+ncumprod(ndatacontainer<ContainerT, T, ndims> const & u, size_t axis, scan_mode mode = scan_mode::INCLUSIVE) {
+    return ncumprod(serial_policy(), u, axis, mode);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: SCAN_HPP_H4NQ7WZE */
@@ -0,0 +1,201 @@
+/*! \file Contains nforeach_stencil, a loop handing each output element the neighborhood of the matching
+ *  input element, with the borders handled by the overflow behaviours of interp */
+#ifndef STENCIL_HPP_V8PJ3LQD
+#define STENCIL_HPP_V8PJ3LQD
+
+#include <array>
+#include <stdexcept>
+#include <tuple>
+#include "ndata.hpp"
+#include "ndata/algorithm/padded_view.hpp"
+
+namespace ndata {
+
+/**
+ * @brief Access to the neighbors of an element of the input of nforeach_stencil: nb(di, dj...) is the
+ *  element at offset (di, dj...) from it, read through the strides of the input. Only the offsets within
+ *  the radius passed to nforeach_stencil are valid.
+ */
+template <typename T, long ndims>
+struct stencil_neighborhood {
+
+    T const * center;
+
+    std::array<long, size_t(ndims)> strides;
+
+    template <typename ... Long>
+    T const &
+    operator()(Long ... offsets) const {
+        static_assert(sizeof...(Long) == size_t(ndims), "one offset per dimension");
+        const long offs[] = {long(offsets)...};
+        long delta = 0;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            delta += offs[i]*strides[i];
+        }
+        return center[delta];
+    }
+};
+
+namespace helpers {
+
+    /**
+     * @brief Runs func on the elements of out, each with the neighborhood of the matching element of in,
+     *  whose neighbors within the radius must all be readable.
+     */
+    template <typename PolicyT, typename Tout, typename T, long ndims, typename FuncT>
+    void
+    run_stencil(PolicyT const & policy, ndataview<Tout, ndims> out, ndataview<T, ndims> in, FuncT & func) {
+        stencil_neighborhood<T, ndims> nb;
+        nb.center = nullptr;
+        auto in_strides = in.get_strides();
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            nb.strides[i] = in_strides[i];
+        }
+
+        //the center is the element nforeach hands over, whose address is in the data of in (broadcasted,
+        //zero stride inputs included), the loop planner orders the dimensions after the strides
+        nforeach(policy, std::tie(out, in), [&nb, &func] (Tout & o, T const & v) {
+            stencil_neighborhood<T, ndims> nb_c = nb;
+            nb_c.center = &v;
+            func(o, nb_c);
+        });
+    }
+
+    /**
+     * @brief The border region [begin, begin+shape) of out: its input, with the halo of the neighborhoods,
+     *  is copied from the padded input to a small contiguous buffer, then run like the interior.
+     */
+    template <typename PolicyT, typename Tout, typename T, long ndims, typename FuncT>
+    void
+    run_stencil_border(
+            PolicyT const & policy,
+            ndataview<Tout, ndims> out,
+            padded_view<T, ndims> & padded,
+            vecarray<long, ndims> radius,
+            vecarray<long, ndims> begin,
+            vecarray<long, ndims> shape,
+            FuncT & func
+            )
+    {
+        auto halo_shape = shape;
+        for (size_t i = 0; i < size_t(ndims); ++i) {
+            if (shape[i] == 0) {
+                return;
+            }
+            halo_shape[i] += 2*radius[i];
+        }
+
+        nvector<T, ndims> halo (indexer<ndims>(halo_shape), UNINITIALIZED);
+        padded.window(begin, halo_shape).copy_to(halo);
+
+        run_stencil(policy, region_view(out, begin, shape), region_view(halo.as_view(), radius, shape), func);
+    }
+
+} //end namespace helpers
+
+/**
+ * @brief Calls func(out_val, nb) for each element of out, nb being the stencil_neighborhood of the element
+ *  of in at the same position, in and out having the same shape. The neighbors up to radius[i] away
+ *  along axis i can be read, beyond the borders of in they are given by the overflow behaviour of the axis
+ *  (a tuple like std::make_tuple(interp::overflow_behaviour::cyclic(), interp::overflow_behaviour::zero())).
+ *
+ * auto laplacian = [] (double & o, auto const & nb) {
+ *     o = nb(-1, 0)+nb(1, 0)+nb(0, -1)+nb(0, 1)-4*nb(0, 0);
+ * };
+ * nforeach_stencil(parallel_policy(), out, in, make_vecarray(1l, 1l), behaviours, laplacian);
+ *
+ * The interior, whose neighborhoods are all inside in, runs as an nforeach on in directly: the
+ * neighbors are read at fixed offsets from the element, with no branch nor remapping. The border slabs
+ * are copied with their halo from a padded_view of in into small buffers first, and run the same way.
+ * out must not overlap in.
+ */
+template <
+    typename PolicyT,
+    typename ContainerT_out,
+    typename Tout,
+    typename ContainerT,
+    typename T,
+    long ndims,
+    typename ... OverflowBehaviours,
+    typename FuncT
+>
+typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+nforeach_stencil(
+        PolicyT const & policy,
+        ndatacontainer<ContainerT_out, Tout, ndims> & out,
+        ndatacontainer<ContainerT, T, ndims> & in,
+        vecarray<long, ndims> radius,
+        std::tuple<OverflowBehaviours...> overflow_behaviours,
+        FuncT func
+        )
+{
+    static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+    auto shape = in.get_shape();
+    auto out_shape = out.get_shape();
+    for (size_t i = 0; i < size_t(ndims); ++i) {
+        assert(radius[i] >= 0);
+        if (out_shape[i] != shape[i]) {
+            throw std::domain_error("nforeach_stencil: out and in must have the same shape");
+        }
+    }
+
+    auto out_view = out.as_view();
+    auto in_view = in.as_view();
+
+    //along each axis, [lo_end, hi_begin) is the interior
+    vecarray<long, ndims> lo_end (STATICALLY_SIZED);
+    vecarray<long, ndims> hi_begin (STATICALLY_SIZED);
+    vecarray<long, ndims> interior_shape (STATICALLY_SIZED);
+    for (size_t i = 0; i < size_t(ndims); ++i) {
+        lo_end[i] = std::min(radius[i], shape[i]);
+        hi_begin[i] = std::max(lo_end[i], shape[i]-radius[i]);
+        interior_shape[i] = hi_begin[i]-lo_end[i];
+    }
+
+    helpers::run_stencil(
+                policy,
+                helpers::region_view(out_view, lo_end, interior_shape),
+                helpers::region_view(in_view, lo_end, interior_shape),
+                func
+                );
+
+    //border slabs: along axis a, the elements before lo_end[a] and after hi_begin[a], restricted to the
+    //interior along the axes before a, so that each element is in exactly one slab
+    auto padded = make_padded_view(in, radius, overflow_behaviours);
+    for (size_t a = 0; a < size_t(ndims); ++a) {
+        vecarray<long, ndims> begin (STATICALLY_SIZED, 0l);
+        vecarray<long, ndims> slab_shape = shape;
+        for (size_t i = 0; i < a; ++i) {
+            begin[i] = lo_end[i];
+            slab_shape[i] = interior_shape[i];
+        }
+
+        slab_shape[a] = lo_end[a];
+        helpers::run_stencil_border(policy, out_view, padded, radius, begin, slab_shape, func);
+
+        begin[a] = hi_begin[a];
+        slab_shape[a] = shape[a]-hi_begin[a];
+        helpers::run_stencil_border(policy, out_view, padded, radius, begin, slab_shape, func);
+    }
+}
+
+/**
+ * @brief Same as nforeach_stencil(serial_policy(), out, in, radius, overflow_behaviours, func).
+ */
+template <typename ContainerT_out, typename Tout, typename ContainerT, typename T, long ndims, typename ... OverflowBehaviours, typename FuncT>
+void
+nforeach_stencil(
+        ndatacontainer<ContainerT_out, Tout, ndims> & out,
+        ndatacontainer<ContainerT, T, ndims> & in,
+        vecarray<long, ndims> radius,
+        std::tuple<OverflowBehaviours...> overflow_behaviours,
+        FuncT func
+        )
+{
+    nforeach_stencil(serial_policy(), out, in, radius, overflow_behaviours, func);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: STENCIL_HPP_V8PJ3LQD */
@@ -0,0 +1,131 @@
+/*! \file Contains the kernels copying or converting contiguous runs of elements, used by the copies of
+ *  assign and concatenate */
+#ifndef COPY_KERNELS_HPP_Q8TZ4WLC
+#define COPY_KERNELS_HPP_Q8TZ4WLC
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+   #include <emmintrin.h>
+#endif
+
+/**
+ * Copies writing at least this many bytes use non-temporal (streaming) stores, which bypass the caches:
+ * the destination is too large to be still there when it is read again, and caching it would only evict
+ * useful data. Can be defined before including ndata.
+ */
+#ifndef NDATA_STREAMING_STORE_BYTES
+   #define NDATA_STREAMING_STORE_BYTES (std::size_t(1) << 30)
+#endif
+
+namespace ndata {
+
+namespace helpers {
+
+    /**
+     * @brief memcpy with non-temporal stores of 16 bytes, after a head aligning the destination. Falls back
+     *  on memcpy without SSE2 or for short copies.
+     */
+    inline
+    void
+    stream_copy(void * dst, void const * src, std::size_t nbytes) {
+#if defined(__SSE2__)
+        char * d = static_cast<char *>(dst);
+        char const * s = static_cast<char const *>(src);
+        if (nbytes < 256) {
+            std::memcpy(d, s, nbytes);
+            return;
+        }
+
+        const std::size_t head = (16-reinterpret_cast<std::uintptr_t>(d)%16)%16;
+        std::memcpy(d, s, head);
+        d += head;
+        s += head;
+        nbytes -= head;
+
+        std::size_t i = 0;
+        for (; i+64 <= nbytes; i += 64) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+i+16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+i+32));
+            __m128i e = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+i+48));
+            _mm_stream_si128(reinterpret_cast<__m128i *>(d+i), a);
+            _mm_stream_si128(reinterpret_cast<__m128i *>(d+i+16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i *>(d+i+32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i *>(d+i+48), e);
+        }
+        //the streaming stores are weakly ordered, make them visible before returning
+        _mm_sfence();
+        std::memcpy(d+i, s+i, nbytes-i);
+#else
+        std::memcpy(dst, src, nbytes);
+#endif
+    }
+
+    /**
+     * @brief d[i] = T(s[i]) for i in [0, n). The overloads below convert several elements per instruction
+     *  with SSE2, this loop is left to the auto-vectorizer.
+     */
+    template <typename T, typename S>
+    void
+    convert_run(T * d, S const * s, long n) {
+        for (long i = 0; i < n; ++i) {
+            d[i] = T(s[i]);
+        }
+    }
+
+#if defined(__SSE2__)
+    inline
+    void
+    convert_run(double * d, float const * s, long n) {
+        long i = 0;
+        for (; i+4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(s+i);
+            _mm_storeu_pd(d+i, _mm_cvtps_pd(v));
+            _mm_storeu_pd(d+i+2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+        for (; i < n; ++i) {
+            d[i] = double(s[i]);
+        }
+    }
+
+    //rounded with the current rounding mode, like the scalar conversion
+    inline
+    void
+    convert_run(float * d, double const * s, long n) {
+        long i = 0;
+        for (; i+4 <= n; i += 4) {
+            __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(s+i));
+            __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(s+i+2));
+            _mm_storeu_ps(d+i, _mm_movelh_ps(lo, hi));
+        }
+        for (; i < n; ++i) {
+            d[i] = float(s[i]);
+        }
+    }
+
+    inline
+    void
+    convert_run(float * d, std::int16_t const * s, long n) {
+        long i = 0;
+        for (; i+8 <= n; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+i));
+            //each int16 in the upper half of an int32, shifted back with its sign
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(d+i, _mm_cvtepi32_ps(lo));
+            _mm_storeu_ps(d+i+4, _mm_cvtepi32_ps(hi));
+        }
+        for (; i < n; ++i) {
+            d[i] = float(s[i]);
+        }
+    }
+#endif
+
+} //end namespace helpers
+
+} //end namespace ndata
+
+#endif /* end of include guard: COPY_KERNELS_HPP_Q8TZ4WLC */
@@ -0,0 +1,114 @@
+/*! \file Contains the execution policies accepted by the looping constructs */
+#ifndef EXECUTION_POLICY_HPP_M2V7HQZC
+#define EXECUTION_POLICY_HPP_M2V7HQZC
+
+#include <cstddef>
+#include <type_traits>
+
+namespace ndata {
+
+/**
+ * @brief How the iterations of a parallel loop are distributed between threads.
+ *
+ * STATIC: one contiguous block per thread, or round robin blocks of parallel_policy::chunk_size elements.
+ * DYNAMIC: blocks of chunk_size elements are handed to threads as they become idle, for loops with
+ *  uneven per element cost.
+ * GUIDED: like DYNAMIC, with big blocks first and shrinking down to chunk_size.
+ *
+ * With the thread pool backend DYNAMIC and GUIDED both map to work stealing.
+ */
+enum class schedule_kind {
+    STATIC,
+    DYNAMIC,
+    GUIDED
+};
+
+/**
+ * @brief Threading backend of the parallel loops. DEFAULT is OpenMP when the code is compiled
+ *  with OpenMP support, and the thread_pool otherwise.
+ */
+enum class parallel_backend {
+    DEFAULT,
+    OPENMP,
+    THREAD_POOL
+};
+
+/**
+ * @brief Run the loops on the calling thread.
+ */
+struct serial_policy {
+};
+
+/**
+ * @brief Run the loops in parallel. Default constructed, it splits the iterations in one block per
+ *  thread of the backend. The with_* methods return a modified copy, so that a policy can be built inline:
+ *
+ * nforeach(parallel_policy().with_schedule(schedule_kind::DYNAMIC).with_chunk_size(4096), std::tie(u, v), func);
+ */
+struct parallel_policy {
+
+    //number of threads, 0 means the backend default (capped to the size of the thread pool)
+    size_t num_threads = 0;
+
+    //number of elements in a scheduling block, 0 means automatic. It is rounded up so that blocks don't
+    //share cache lines of a contiguous output
+    long chunk_size = 0;
+
+    schedule_kind schedule = schedule_kind::STATIC;
+
+    //pin threads to cores (OpenMP proc_bind(close), or the cores of the thread pool workers on linux)
+    bool bind_threads = false;
+
+    //loops with fewer elements than that run serially
+    long min_work = 0;
+
+    parallel_backend backend = parallel_backend::DEFAULT;
+
+    parallel_policy with_threads(size_t n) const {
+        parallel_policy ret = *this;
+        ret.num_threads = n;
+        return ret;
+    }
+
+    parallel_policy with_chunk_size(long n) const {
+        parallel_policy ret = *this;
+        ret.chunk_size = n;
+        return ret;
+    }
+
+    parallel_policy with_schedule(schedule_kind s) const {
+        parallel_policy ret = *this;
+        ret.schedule = s;
+        return ret;
+    }
+
+    parallel_policy with_affinity(bool bind = true) const {
+        parallel_policy ret = *this;
+        ret.bind_threads = bind;
+        return ret;
+    }
+
+    parallel_policy with_min_work(long n) const {
+        parallel_policy ret = *this;
+        ret.min_work = n;
+        return ret;
+    }
+
+    parallel_policy with_backend(parallel_backend b) const {
+        parallel_policy ret = *this;
+        ret.backend = b;
+        return ret;
+    }
+};
+
+template <typename T>
+struct is_execution_policy : std::integral_constant<
+        bool,
+        std::is_same<typename std::decay<T>::type, serial_policy>::value
+        or std::is_same<typename std::decay<T>::type, parallel_policy>::value
+        >
+{ };
+
+} //end namespace ndata
+
+#endif /* end of include guard: EXECUTION_POLICY_HPP_M2V7HQZC */
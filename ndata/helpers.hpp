@@ -5,6 +5,7 @@
 #include <utility>
 #include "tuple_utilities.hpp"
 #include <exception>
+#include <stdexcept>
 #include <type_traits>
 
 #include "vecarray.hpp"
@@ -2,11 +2,14 @@
 #ifndef NDINDEXER_HPP_9FICI4GD
 #define NDINDEXER_HPP_9FICI4GD
 
+#include <algorithm>
 #include <vector>
 
 #include <initializer_list>
 #include <cstdlib>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 #include "vecarray.hpp"
 #include "ndata.hpp"
@@ -61,6 +64,10 @@ struct range {
 struct newdimT {};
 constexpr newdimT NEWDIM = newdimT();
 
+//tag for the constructors laying out the data in column major (fortran) order
+struct FORTRAN_ORDER_T { };
+constexpr FORTRAN_ORDER_T FORTRAN_ORDER = FORTRAN_ORDER_T();
+
 /**
  * @brief Helper function allowing the user to create an indexer, dimensionality is infered
  * from the number of arguments.
@@ -109,6 +116,112 @@ namespace helpers {
             assert(shape[i] >= 0);
         }
     }
+
+    /**
+     * @brief Replaces the (at most one) -1 of new_shape by the size making the number of elements
+     *  equal to size, throws std::domain_error if no shape fits.
+     */
+    template <long new_ndims>
+    vecarray<long, new_ndims>
+    resolve_reshape(size_t size, vecarray<long, new_ndims> new_shape) {
+        long known = 1;
+        long inferred_axis = -1;
+        for (size_t i = 0; i < new_shape.size(); ++i) {
+            if (new_shape[i] == -1 and inferred_axis == -1) {
+                inferred_axis = long(i);
+            } else if (new_shape[i] < 0) {
+                throw std::domain_error("reshape: negative size in the new shape");
+            } else {
+                known *= new_shape[i];
+            }
+        }
+
+        if (inferred_axis >= 0) {
+            if (known == 0 or long(size)%known != 0) {
+                throw std::domain_error("reshape: can't infer the size of the -1 axis");
+            }
+            new_shape[size_t(inferred_axis)] = long(size)/known;
+        } else if (size_t(known) != size) {
+            throw std::domain_error("reshape: the new shape doesn't have the same number of elements");
+        }
+
+        return new_shape;
+    }
+
+    /**
+     * @brief Computes the strides indexing the elements of (old_shape, old_strides) in the same C order
+     *  with new_shape, which must have the same number of elements. Returns false when no strides can,
+     *  because axes merged together by the new shape aren't laid out contiguously one in the other.
+     *
+     * Same algorithm as numpy: the two shapes are cut in groups of axes of equal sizes, within a group
+     * the old axes must be contiguous and the new strides are derived from the stride of its last axis.
+     */
+    template <long ndims, long new_ndims>
+    bool
+    nocopy_reshape_strides(
+            vecarray<long, ndims> old_shape,
+            vecarray<long, ndims> old_strides,
+            vecarray<long, new_ndims> new_shape,
+            vecarray<long, new_ndims> & new_strides
+            )
+    {
+        //dimensions of size 1 don't constrain anything
+        std::vector<long> odims, ostrides;
+        long size = 1;
+        for (size_t i = 0; i < old_shape.size(); ++i) {
+            size *= old_shape[i];
+            if (old_shape[i] != 1) {
+                odims.push_back(old_shape[i]);
+                ostrides.push_back(old_strides[i]);
+            }
+        }
+
+        if (size == 0) {
+            //nothing is indexed, any strides will do
+            long stride = 1;
+            for (size_t i = new_shape.size(); i-- > 0; ) {
+                new_strides[i] = stride;
+                stride *= std::max(new_shape[i], 1l);
+            }
+            return true;
+        }
+
+        size_t oi = 0, oj = 1, ni = 0, nj = 1;
+        while (ni < new_shape.size() and oi < odims.size()) {
+            long np = new_shape[ni];
+            long op = odims[oi];
+
+            while (np != op) {
+                if (np < op) {
+                    np *= new_shape[nj++];
+                } else {
+                    op *= odims[oj++];
+                }
+            }
+
+            for (size_t ok = oi; ok+1 < oj; ++ok) {
+                if (ostrides[ok] != odims[ok+1]*ostrides[ok+1]) {
+                    return false;
+                }
+            }
+
+            new_strides[nj-1] = ostrides[oj-1];
+            for (size_t nk = nj-1; nk > ni; --nk) {
+                new_strides[nk-1] = new_strides[nk]*new_shape[nk];
+            }
+
+            ni = nj++;
+            oi = oj++;
+        }
+
+        //trailing dimensions of size 1
+        long last_stride = (ni >= 1)? new_strides[ni-1] : 1;
+        for (size_t nk = ni; nk < new_shape.size(); ++nk) {
+            new_strides[nk] = last_stride;
+        }
+
+        return true;
+    }
 }
 
 /**
@@ -159,6 +272,18 @@ struct indexer {
         helpers::check_shape(shape_);
     }
 
+    /**
+     * @brief Initialize from shape with column major strides, the first index varying the fastest
+     *  like in fortran.
+     */
+    indexer(vecarray<long, ndims> shape, FORTRAN_ORDER_T):
+        start_index_(0),
+        shape_(shape),
+        strides_(calc_strides_from_shape(shape, FORTRAN_ORDER))
+    {
+        helpers::check_shape(shape_);
+    }
+
     /**
      * @brief construct from members
      */
@@ -202,7 +327,7 @@ struct indexer {
     size_t index(vecarray<long, ndims> ndindex) {
         vecarray<size_t, ndims> rev_index (ndindex.dynsize());
         for (size_t i = 0; i < ndindex.size(); ++i) {
-            rev_index[i] = reverse_negative_index(ndindex[i]);
+            rev_index[i] = reverse_negative_index(i, ndindex[i]);
         }
         return index(rev_index);
     }
@@ -383,22 +508,22 @@ struct indexer {
         return indexer<RET_STATIC_SIZE>(ret_start_index, ret_shape, ret_strides);
     }
 
-    size_t get_start_index() {
+    size_t get_start_index() const {
         return start_index_;
     }
 
-    vecarray<long, ndims> get_shape() {
+    vecarray<long, ndims> get_shape() const {
         return shape_;
     }
 
     /**
      * Return the stride for the current dimension
      */
-    vecarray<long, ndims> get_strides() {
+    vecarray<long, ndims> get_strides() const {
         return strides_;
     }
 
-    size_t size(){
+    size_t size() const {
         size_t acc=1;
         for(size_t i=0;i<shape_.size();i++){
             acc*=shape_[i];
@@ -479,7 +604,227 @@ struct indexer {
         return ndindex;
     }
 
-    //TODO fortran_order, swap_dimensions
+    /**
+     * @brief Returns an indexer on the same elements with its axes reordered: axis i of the result
+     *  is axis axes[i] of this one. Only the shape and strides are permuted.
+     *
+     * @param axes a permutation of 0..ndims-1
+     */
+    indexer<ndims>
+    permute_axes_indexer(vecarray<size_t, ndims> axes) {
+        assert(axes.size() == shape_.size());
+
+        vecarray<long, ndims> shape (shape_.dynsize());
+        vecarray<long, ndims> strides (shape_.dynsize());
+        vecarray<bool, ndims> seen (shape_.dynsize(), false);
+
+        for (size_t i = 0; i < axes.size(); ++i) {
+            assert(axes[i] < shape_.size() and not seen[axes[i]]);
+            seen[axes[i]] = true;
+            shape[i] = shape_[axes[i]];
+            strides[i] = strides_[axes[i]];
+        }
+
+        return indexer<ndims>(start_index_, shape, strides);
+    }
+
+    /**
+     * @brief Returns an indexer with the axes in reverse order. The transposition of a C ordered
+     *  indexer is fortran ordered, and vice versa.
+     */
+    indexer<ndims>
+    transpose_indexer() {
+        vecarray<size_t, ndims> axes (shape_.dynsize());
+        for (size_t i = 0; i < axes.size(); ++i) {
+            axes[i] = axes.size()-1-i;
+        }
+        return permute_axes_indexer(axes);
+    }
+
+    /**
+     * @brief Returns an indexer with the axes axis1 and axis2 exchanged.
+     */
+    indexer<ndims>
+    swapaxes_indexer(size_t axis1, size_t axis2) {
+        vecarray<size_t, ndims> axes (shape_.dynsize());
+        for (size_t i = 0; i < axes.size(); ++i) {
+            axes[i] = i;
+        }
+        std::swap(axes[axis1], axes[axis2]);
+        return permute_axes_indexer(axes);
+    }
+
+    /**
+     * @brief true if the indexed elements are laid out contiguously in C order (dimensions of size 1
+     *  can have any stride).
+     */
+    bool
+    is_c_contiguous() {
+        return has_strides(calc_strides_from_shape(shape_));
+    }
+
+    /**
+     * @brief true if the indexed elements are laid out contiguously in fortran order.
+     */
+    bool
+    is_fortran_contiguous() {
+        return has_strides(calc_strides_from_shape(shape_, FORTRAN_ORDER));
+    }
+
+    /**
+     * @brief true if reshape_indexer(new_shape) can index the same elements without copying them.
+     */
+    template <long new_ndims>
+    bool
+    can_reshape_view(vecarray<long, new_ndims> new_shape) {
+        new_shape = helpers::resolve_reshape(size(), new_shape);
+        vecarray<long, new_ndims> new_strides (new_shape.dynsize());
+        return helpers::nocopy_reshape_strides(shape_, strides_, new_shape, new_strides);
+    }
+
+    /**
+     * @brief Returns an indexer of shape new_shape on the same elements, taken in C order like numpy.reshape.
+     *  One axis of new_shape may be -1, its size is then inferred from the number of elements.
+     *
+     * Throws std::domain_error if the number of elements differs, or if the strides of this indexer
+     * don't allow the new shape without a copy (see can_reshape_view and ndatacontainer::reshape).
+     */
+    template <long new_ndims>
+    indexer<new_ndims>
+    reshape_indexer(vecarray<long, new_ndims> new_shape) {
+        new_shape = helpers::resolve_reshape(size(), new_shape);
+        vecarray<long, new_ndims> new_strides (new_shape.dynsize());
+        if (not helpers::nocopy_reshape_strides(shape_, strides_, new_shape, new_strides)) {
+            throw std::domain_error("reshape: the strides don't allow this shape without a copy");
+        }
+        return indexer<new_ndims>(start_index_, new_shape, new_strides);
+    }
+
+    /**
+     * @brief Returns an indexer without the axis axis, which must have a size of 1.
+     */
+    indexer<ndims-1>
+    squeeze_indexer(size_t axis) {
+        static_assert(ndims > 0, "only for a number of dimensions known at compile time");
+        assert(axis < shape_.size());
+
+        if (shape_[axis] != 1) {
+            throw std::domain_error("squeeze: the axis doesn't have a size of 1");
+        }
+
+        vecarray<long, ndims-1> shape (STATICALLY_SIZED);
+        vecarray<long, ndims-1> strides (STATICALLY_SIZED);
+        for (size_t i = 0, j = 0; i < shape_.size(); ++i) {
+            if (i != axis) {
+                shape[j] = shape_[i];
+                strides[j] = strides_[i];
+                ++j;
+            }
+        }
+
+        return indexer<ndims-1>(start_index_, shape, strides);
+    }
+
+    /**
+     * @brief Returns an indexer with a new axis of size 1 inserted before axis axis (axis == ndims appends it).
+     */
+    indexer<ndims+1>
+    expand_dims_indexer(size_t axis) {
+        static_assert(ndims >= 0, "only for a number of dimensions known at compile time");
+        assert(axis <= shape_.size());
+
+        vecarray<long, ndims+1> shape (STATICALLY_SIZED);
+        vecarray<long, ndims+1> strides (STATICALLY_SIZED);
+        for (size_t i = 0, j = 0; i < shape.size(); ++i) {
+            if (i == axis) {
+                shape[i] = 1;
+                strides[i] = 0; //only one element along it
+            } else {
+                shape[i] = shape_[j];
+                strides[i] = strides_[j];
+                ++j;
+            }
+        }
+
+        return indexer<ndims+1>(start_index_, shape, strides);
+    }
+
+    /**
+     * @brief Returns an indexer on the same elements in reverse order along axis, through a negative stride.
+     */
+    indexer<ndims>
+    flip_indexer(size_t axis) {
+        assert(axis < shape_.size());
+
+        indexer<ndims> ret (*this);
+        if (shape_[axis] > 0) {
+            ret.start_index_ += (shape_[axis]-1)*strides_[axis];
+        }
+        ret.strides_[axis] = -strides_[axis];
+        return ret;
+    }
+
+    /**
+     * @brief Returns an indexer on the same elements in reverse order along every axis.
+     */
+    indexer<ndims>
+    flip_indexer() {
+        indexer<ndims> ret (*this);
+        for (size_t i = 0; i < shape_.size(); ++i) {
+            ret = ret.flip_indexer(i);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Returns an indexer on all the windows of shape window_shape over the axes axes, like
+     *  numpy.lib.stride_tricks.sliding_window_view. Nothing is copied, windows overlap in the indexed data.
+     *
+     * Axis axes[i] is shortened to its number of window positions (shape-window_shape[i]+1), and a trailing
+     * dimension of size window_shape[i] with the same stride is appended, the same way NEWDIM adds
+     * dimensions in slice_indexer. An axis may be repeated.
+     *
+     * Throws std::domain_error if a window is larger than its axis.
+     */
+    template <long nwin>
+    indexer<ndims+nwin>
+    sliding_window_indexer(vecarray<long, nwin> window_shape, vecarray<size_t, nwin> axes) {
+        static_assert(ndims >= 0 and nwin >= 0, "only for a number of dimensions known at compile time");
+
+        vecarray<long, ndims+nwin> shape (STATICALLY_SIZED);
+        vecarray<long, ndims+nwin> strides (STATICALLY_SIZED);
+        for (size_t i = 0; i < shape_.size(); ++i) {
+            shape[i] = shape_[i];
+            strides[i] = strides_[i];
+        }
+
+        for (size_t iwin = 0; iwin < window_shape.size(); ++iwin) {
+            size_t axis = axes[iwin];
+            assert(axis < shape_.size());
+
+            if (window_shape[iwin] < 0 or window_shape[iwin] > shape[axis]) {
+                throw std::domain_error("sliding_window: the window is larger than the axis");
+            }
+
+            shape[axis] -= window_shape[iwin]-1;
+            shape[shape_.size()+iwin] = window_shape[iwin];
+            strides[shape_.size()+iwin] = strides_[axis];
+        }
+
+        return indexer<ndims+nwin>(start_index_, shape, strides);
+    }
+
+    /**
+     * @brief Same as sliding_window_indexer(window_shape, axes) with a window along every axis.
+     */
+    indexer<2*ndims>
+    sliding_window_indexer(vecarray<long, ndims> window_shape) {
+        vecarray<size_t, ndims> axes (shape_.dynsize());
+        for (size_t i = 0; i < axes.size(); ++i) {
+            axes[i] = i;
+        }
+        return sliding_window_indexer(window_shape, axes);
+    }
 
     /**
      * used by broadcast
@@ -521,6 +866,31 @@ struct indexer {
         return ret;
     }
 
+    static
+    vecarray<long, ndims>
+    calc_strides_from_shape(vecarray<long, ndims> shape, FORTRAN_ORDER_T) {
+
+        vecarray<long, ndims> ret (shape.dynsize());
+
+        long this_stride = 1;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            ret[i] = this_stride;
+            this_stride *= shape[i];
+        }
+
+        return ret;
+    }
+
+    bool
+    has_strides(vecarray<long, ndims> strides) {
+        for (size_t i = 0; i < shape_.size(); ++i) {
+            if (shape_[i] > 1 and strides_[i] != strides[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // FIXME: A note: the slice_rec family of functions is redundant with the the vecarray based
     // slice_indexer implementation. Maybe it should go away at some point, and the variadic slice_indexer implementation
     // should rely on the vecarray based one instead. However it seems more info (namely the ordering
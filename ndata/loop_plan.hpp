@@ -0,0 +1,196 @@
+/*! \file Contains loop_plan, the setup of a loop saved to run it again on operands of the same geometry */
+#ifndef LOOP_PLAN_HPP_W8DN3KXA
+#define LOOP_PLAN_HPP_W8DN3KXA
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "ndata.hpp"
+#include "ndata/loops.hpp"
+
+namespace ndata {
+
+namespace helpers {
+
+    //pointers to the first elements from the base pointers
+    template <typename ... Ts, size_t nops, size_t ... Is>
+    std::tuple<Ts*...>
+    add_start_indices(std::tuple<Ts*...> const & base_ptrs, std::array<size_t, nops> const & start_indices, std::index_sequence<Is...>) {
+        return std::tuple<Ts*...>(std::get<Is>(base_ptrs) + start_indices[Is]...);
+    }
+
+}
+
+/**
+ * @brief Everything nforeach computes before running the loops: broadcasting of the operands, ordering and
+ *  coalescing of the dimensions, and for a parallel policy the split of the iterations between the threads.
+ *  Operands with conflicting strides are traversed in tiles like in nforeach, the split of the tiled loops
+ *  is then made by each run.
+ *
+ * For loops run many times on operands with the same shapes, strides and start indices, like the blocks
+ * of a blocked grid, the plan is made once and then run on the data of each set of operands:
+ *
+ * auto plan = make_loop_plan(parallel_policy(), std::tie(blocks_out[0], blocks_in[0]));
+ * for (size_t i = 0; i < blocks_in.size(); ++i) {
+ *     plan.run(std::tie(blocks_out[i], blocks_in[i]), func);
+ * }
+ *
+ * run takes the containers, or directly the base pointers of their data (the data_ member of a view).
+ * Only the base pointers are read from the containers, in debug builds an assertion checks that their
+ * geometry matches the plan.
+ */
+template <long ndims, typename ... Ts>
+struct loop_plan {
+    static_assert(ndims > 0, "nothing to plan for 0D data");
+
+    static constexpr size_t NOPS = sizeof...(Ts);
+
+    //broadcasted, reordered and coalesced loops
+    helpers::loop_geometry<NOPS, ndims> geom_;
+
+    //index of the first element of each operand from its base pointer
+    std::array<size_t, NOPS> start_indices_;
+
+    bool parallel_;
+
+    //traversed in tiles, see helpers::tiling_dim
+    bool tiled_;
+
+    parallel_policy policy_;
+
+    helpers::parallel_partition partition_;
+
+    /**
+     * @param ndata_views the operands, already broadcasted together
+     */
+    loop_plan(serial_policy const &, std::tuple<ndataview<Ts, ndims>...> ndata_views):
+        geom_(helpers::make_loop_geometry<ndims>(ndata_views)),
+        parallel_(false)
+    {
+        init(ndata_views, std::index_sequence_for<Ts...>());
+    }
+
+    loop_plan(parallel_policy const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views):
+        geom_(helpers::make_loop_geometry<ndims>(ndata_views)),
+        policy_(policy)
+    {
+        init(ndata_views, std::index_sequence_for<Ts...>());
+        parallel_ = helpers::loop_size(geom_) >= policy.min_work;
+        if (parallel_ and not tiled_) {
+            partition_ = helpers::make_parallel_partition<typename std::tuple_element<0, std::tuple<Ts...>>::type>(policy, geom_);
+        }
+    }
+
+    /**
+     * @brief Runs the loops on the operands whose data start at base_ptrs.
+     */
+    template <typename FuncT>
+    void
+    run(std::tuple<Ts*...> base_ptrs, FuncT func) const {
+        std::tuple<Ts*...> tup_ndata_ptrs = helpers::add_start_indices(base_ptrs, start_indices_, std::index_sequence_for<Ts...>());
+
+        if (not parallel_) {
+            helpers::loop_runner<ndims>::do_it(serial_policy(), tup_ndata_ptrs, func, geom_);
+            return;
+        }
+
+        if (tiled_) {
+            helpers::loop_runner<ndims>::do_it(policy_, tup_ndata_ptrs, func, geom_);
+            return;
+        }
+
+        auto cont = [&] (auto row_kernel) {
+            helpers::run_partitioned<decltype(row_kernel)>(policy_, tup_ndata_ptrs, func, geom_, partition_);
+        };
+        helpers::select_row_kernel<0, NOPS, false>::do_it(geom_.strides[ndims-1], cont);
+    }
+
+    /**
+     * @brief Runs the loops on the containers, which must have the geometry of those the plan was made for.
+     */
+    template <typename FuncT, typename ... Ndatacontainer>
+    void
+    run(std::tuple<Ndatacontainer&...> ndata_tup_refs, FuncT func) const {
+        static_assert(sizeof...(Ndatacontainer) == NOPS, "");
+
+        assert(matches(ndata_tup_refs));
+
+        run(
+            tuple_utilities::tuple_transform([] (auto & u) {return &u.data_[0];}, ndata_tup_refs),
+            func
+            );
+    }
+
+    /**
+     * @brief true if the containers have the geometry of the operands of the plan.
+     */
+    template <typename ... Ndatacontainer>
+    bool
+    matches(std::tuple<Ndatacontainer&...> ndata_tup_refs) const {
+        try {
+            return matches_views(helpers::broadcast_views(ndata_tup_refs));
+        } catch (std::domain_error &) {
+            //the containers don't even broadcast together
+            return false;
+        }
+    }
+
+private:
+
+    bool
+    matches_views(std::tuple<ndataview<Ts, ndims>...> ndata_views) const {
+        loop_plan other (serial_policy(), ndata_views);
+        bool same = other.start_indices_ == start_indices_;
+        for (size_t idim = 0; idim < size_t(ndims); ++idim) {
+            same = same and other.geom_.shape[idim] == geom_.shape[idim] and other.geom_.strides[idim] == geom_.strides[idim];
+        }
+        return same;
+    }
+
+    template <size_t ... Is>
+    void
+    init(std::tuple<ndataview<Ts, ndims>...> & ndata_views, std::index_sequence<Is...>) {
+        start_indices_ = {{std::get<Is>(ndata_views).get_start_index()...}};
+        helpers::optimize_loop_geometry(geom_);
+        tiled_ = helpers::tiling_dim<Ts...>(geom_) >= 0;
+    }
+};
+
+namespace helpers {
+
+    template <typename PolicyT, typename ... Ts, long ndims>
+    loop_plan<ndims, Ts...>
+    make_loop_plan_base(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views) {
+        return loop_plan<ndims, Ts...>(policy, ndata_views);
+    }
+
+}
+
+/**
+ * @brief Plans the loops of nforeach(policy, ndata_tup_refs, func), see loop_plan.
+ */
+template <typename PolicyT, typename... Ndatacontainer>
+auto
+make_loop_plan(PolicyT const & policy, std::tuple<Ndatacontainer&...> ndata_tup_refs) {
+    static_assert(is_execution_policy<PolicyT>::value, "");
+    return helpers::make_loop_plan_base(policy, helpers::broadcast_views(ndata_tup_refs));
+}
+
+template <typename PolicyT, typename... Ts, long ndims>
+auto
+make_loop_plan(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views) {
+    static_assert(is_execution_policy<PolicyT>::value, "");
+    return helpers::make_loop_plan_base(policy, helpers::broadcast(ndata_views));
+}
+
+template <int loop_type = SERIAL, typename... Ndatacontainer>
+auto
+make_loop_plan(std::tuple<Ndatacontainer&...> ndata_tup_refs) {
+    return make_loop_plan(helpers::loop_type_policy<loop_type>(), ndata_tup_refs);
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: LOOP_PLAN_HPP_W8DN3KXA */
@@ -3,138 +3,1440 @@
 #define NDATA_FUNCTIONS_HPP_J3F2DFOA
 
 
+#include <array>
 #include <tuple>
 #include "ndata/helpers.hpp"
 #include <utility>
+#include <initializer_list>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 #include "tuple_utilities.hpp"
+#include "ndata/thread_pool.hpp"
+#include "ndata/execution_policy.hpp"
+#include "ndata/copy_kernels.hpp"
 
 #ifdef _OPENMP
    #include <omp.h>
    #define NDATA_OMP_GET_NUM_THREADS() omp_get_num_threads()
+   #define NDATA_OMP_GET_THREAD_NUM() omp_get_thread_num()
 #else
    #define NDATA_OMP_GET_NUM_THREADS() 1
+   #define NDATA_OMP_GET_THREAD_NUM() 0
 #endif
 
 namespace ndata {
 
+    /**
+     * Loop types. PARALLEL uses OpenMP when the code is compiled with OpenMP support, and the
+     * work stealing thread_pool otherwise. THREAD_POOL always uses the thread_pool.
+     *
+     * They are shorthands for serial_policy(), parallel_policy() and
+     * parallel_policy().with_backend(parallel_backend::THREAD_POOL), pass a policy object
+     * instead to control the threads, chunks and schedule.
+     */
     constexpr int
         SERIAL=0,
-        PARALLEL=1;
+        PARALLEL=1,
+        THREAD_POOL=2;
 
     namespace helpers {
 
+        /**
+         * @brief Shape and per-operand strides of a set of broadcasted ndataviews, laid out so that
+         *  the loops only have to read plain longs. strides[idim][iop] is the stride of operand iop
+         *  along dimension idim.
+         */
+        template <size_t nops, long ndims>
+        struct loop_geometry {
+            static_assert(ndims!=DYNAMICALLY_SIZED, "not implemented");
+
+            std::array<long, ndims> shape;
+            std::array<std::array<long, nops>, ndims> strides;
+
+            template <long ndims_op>
+            void
+            set_operand_strides(size_t iop, vecarray<long, ndims_op> op_strides) {
+                for (size_t idim = 0; idim < size_t(ndims); ++idim) {
+                    strides[idim][iop] = op_strides[idim];
+                }
+            }
+        };
+
+        template <size_t nops, long ndims, typename ... Ts, long ... ndims_ops, size_t ... Is>
+        void
+        gather_strides(
+                loop_geometry<nops, ndims> & geom,
+                std::tuple<ndataview<Ts, ndims_ops>...> & ndata_views,
+                std::index_sequence<Is...>
+                )
+        {
+            (void) std::initializer_list<int> {
+                (geom.set_operand_strides(Is, std::get<Is>(ndata_views).get_strides()), 0)...
+            };
+        }
+
+        template <long ndims, typename ... Ts, long ... ndims_ops>
+        loop_geometry<sizeof...(Ts), ndims>
+        make_loop_geometry(std::tuple<ndataview<Ts, ndims_ops>...> & ndata_views) {
+            loop_geometry<sizeof...(Ts), ndims> geom;
+
+            //all containers have been broadcasted and have the same shape at this point
+            auto shape = std::get<0>(ndata_views).get_shape();
+            for (size_t idim = 0; idim < size_t(ndims); ++idim) {
+                geom.shape[idim] = shape[idim];
+            }
+
+            gather_strides(geom, ndata_views, std::index_sequence_for<Ts...>());
+            return geom;
+        }
+
+        /**
+         * @brief true if dimension idim_outer should be iterated inside of dimension idim_inner, that is
+         *  if it has smaller strides for the operands that move along both dimensions, and no operand disagrees.
+         */
+        template <size_t nops, long ndims>
+        bool
+        should_swap_dims(loop_geometry<nops, ndims> const & geom, size_t idim_outer, size_t idim_inner) {
+            //dimensions of size one don't have a preference either
+            if (geom.shape[idim_outer] == 1 or geom.shape[idim_inner] == 1) {
+                return false;
+            }
+
+            bool swap = false;
+            for (size_t iop = 0; iop < nops; ++iop) {
+                long s_outer = std::abs(geom.strides[idim_outer][iop]);
+                long s_inner = std::abs(geom.strides[idim_inner][iop]);
+
+                //broadcasted operands don't have a preference
+                if (s_outer == 0 or s_inner == 0) {
+                    continue;
+                }
+
+                if (s_outer < s_inner) {
+                    swap = true;
+                } else if (s_outer > s_inner) {
+                    //ambiguous order, keep the declaration order
+                    return false;
+                }
+            }
+            return swap;
+        }
+
+        /**
+         * @brief Loop planning, in the spirit of numpy's nditer.
+         *
+         * Reorders the dimensions so that the ones with the smallest strides are iterated innermost
+         * (transposed views and fortran like slices are still traversed in memory order), then
+         * merges the dimensions that are jointly contiguous for all operands into longer ones.
+         *
+         * The number of dimensions of the geometry is a compile time constant, merged dimensions are
+         * replaced by padding dimensions of size 1 in front.
+         *
+         * Note that iteration order of the elements is not the declaration order anymore for non C-contiguous data.
+         */
+        template <size_t nops, long ndims>
+        void
+        optimize_loop_geometry(loop_geometry<nops, ndims> & geom) {
+
+            if (ndims < 2) {
+                return;
+            }
+
+            //dimensions of size one don't have a preference, they are moved outermost first so that they
+            //don't block the swaps of the others. They keep their strides: when all of them have a size of
+            //one, the single element must not look broadcasted to the row kernels
+            size_t nones = 0;
+            for (size_t idim = 0; idim < size_t(ndims); ++idim) {
+                if (geom.shape[idim] == 1) {
+                    for (size_t j = idim; j > nones; --j) {
+                        std::swap(geom.shape[j], geom.shape[j-1]);
+                        std::swap(geom.strides[j], geom.strides[j-1]);
+                    }
+                    ++nones;
+                }
+            }
+
+            //reordering by stride magnitude, stable bubble sort as ndims is small
+            for (size_t ipass = 0; ipass < size_t(ndims); ++ipass) {
+                for (size_t idim = nones; idim+1 < size_t(ndims); ++idim) {
+                    if (should_swap_dims(geom, idim, idim+1)) {
+                        std::swap(geom.shape[idim], geom.shape[idim+1]);
+                        std::swap(geom.strides[idim], geom.strides[idim+1]);
+                    }
+                }
+            }
+
+            //coalescing, from the innermost dimension outward
+            loop_geometry<nops, ndims> coalesced = geom;
+            long ncoalesced = 0;
+            long i_cur = ndims-1;
+
+            auto push = [&] (long idim) {
+                coalesced.shape[ndims-1-ncoalesced] = geom.shape[idim];
+                coalesced.strides[ndims-1-ncoalesced] = geom.strides[idim];
+                ++ncoalesced;
+            };
+
+            for (long idim = ndims-2; idim >= 0; --idim) {
+                if (geom.shape[idim] == 1) {
+                    continue;
+                }
+
+                if (geom.shape[i_cur] == 1) {
+                    i_cur = idim;
+                    continue;
+                }
+
+                bool contiguous = true;
+                for (size_t iop = 0; iop < nops; ++iop) {
+                    contiguous = contiguous
+                            and geom.strides[idim][iop] == geom.shape[i_cur]*geom.strides[i_cur][iop];
+                }
+
+                if (contiguous) {
+                    geom.shape[i_cur] *= geom.shape[idim];
+                } else {
+                    push(i_cur);
+                    i_cur = idim;
+                }
+            }
+            push(i_cur);
+
+            //padding
+            for (long idim = 0; idim < ndims-ncoalesced; ++idim) {
+                coalesced.shape[idim] = 1;
+                coalesced.strides[idim].fill(0);
+            }
+
+            geom = coalesced;
+        }
+
+        template <typename ... Ts, size_t ... Is>
+        inline
+        void
+        advance_ptrs_impl(std::tuple<Ts*...> & ptrs, const long * strides, std::index_sequence<Is...>) {
+            (void) std::initializer_list<int> {(std::get<Is>(ptrs) += strides[Is], 0)...};
+        }
+
+        /**
+         * @brief Moves each pointer of the tuple by the matching number of elements in strides.
+         */
+        template <typename ... Ts>
+        inline
+        void
+        advance_ptrs(std::tuple<Ts*...> & ptrs, const long * strides) {
+            advance_ptrs_impl(ptrs, strides, std::index_sequence_for<Ts...>());
+        }
+
+        template <typename ... Ts, size_t ... Is>
+        inline
+        std::tuple<Ts*...>
+        offset_ptrs_impl(std::tuple<Ts*...> const & ptrs, const long * strides, long i, std::index_sequence<Is...>) {
+            return std::tuple<Ts*...>(std::get<Is>(ptrs) + i*strides[Is]...);
+        }
+
+        /**
+         * @brief Returns the pointers moved by i times the matching stride.
+         */
+        template <typename ... Ts>
+        inline
+        std::tuple<Ts*...>
+        offset_ptrs(std::tuple<Ts*...> const & ptrs, const long * strides, long i) {
+            return offset_ptrs_impl(ptrs, strides, i, std::index_sequence_for<Ts...>());
+        }
+
+        template <typename FuncT, typename ... Ts, size_t nops, size_t ... Is>
+        inline
+        void
+        apply_at(
+                FuncT & func,
+                std::tuple<Ts*...> const & ptrs,
+                std::array<long, nops> const & strides,
+                long i,
+                std::index_sequence<Is...>
+                )
+        {
+            func(std::get<Is>(ptrs)[i*strides[Is]]...);
+        }
+
+        /**
+         * Row kernel used when some operand has a stride other than 0 or 1 along the innermost
+         * dimension.
+         */
+        struct strided_row {
+
+            template <typename FuncT, typename ... Ts, size_t nops>
+            static
+            inline
+            void
+            run(
+                    FuncT & func,
+                    std::tuple<Ts*...> const & ptrs,
+                    std::array<long, nops> const & strides,
+                    long n
+                    )
+            {
+                for (long i = 0; i < n; ++i) {
+                    apply_at(func, ptrs, strides, i, std::index_sequence_for<Ts...>());
+                }
+            }
+        };
+
+        /**
+         * An operand of a contiguous row, is_bcast is true for a stride of 0 and false for a stride of 1.
+         * cache_bcast is only set by the internal loops accumulating into broadcasted operands, see
+         * helpers::run_views.
+         */
+        template <bool is_bcast, typename T, bool cache_bcast, typename Enable = void>
+        struct row_operand {
+
+            T * ptr;
+
+            explicit row_operand(T * p): ptr(p) { }
+
+            T & at(long i) { return ptr[i]; }
+
+            void finish() { }
+        };
+
+        //broadcasted operand, the functor gets the element itself, index at a constant 0
+        template <typename T, bool cache_bcast, typename Enable>
+        struct row_operand<true, T, cache_bcast, Enable> {
+
+            T * ptr;
+
+            explicit row_operand(T * p): ptr(p) { }
+
+            T & at(long) { return *ptr; }
+
+            void finish() { }
+        };
+
+        /**
+         * Broadcasted accumulator of a trivially copyable type. The value is loaded once per row into
+         * a local which the compiler can keep in a register (the pointer might otherwise alias the
+         * other operands), and stored back at the end of the row if the functor modified it. The
+         * functor gets a reference to the local, not to the element. Const operands are only read
+         * from and keep the plain pointer.
+         */
+        template <typename T>
+        struct row_operand<
+                true,
+                T,
+                true,
+                typename std::enable_if<std::is_trivially_copyable<T>::value and not std::is_const<T>::value>::type
+                >
+        {
+
+            T * ptr;
+            T val;
+
+            explicit row_operand(T * p): ptr(p), val(*p) { }
+
+            T & at(long) { return val; }
+
+            void finish() {
+                if (std::memcmp(&val, ptr, sizeof(T)) != 0) {
+                    *ptr = val;
+                }
+            }
+        };
+
+        /**
+         * Row kernel used when every operand has a stride of 0 or 1 along the innermost dimension,
+         * the strides are then compile time constants (one flag per operand, true for a stride of 0)
+         * and the loop is a tight loop on base pointers that the compiler can vectorize.
+         */
+        template <bool cache_bcast, bool ... is_bcast>
+        struct unit_row {
+
+            template <typename FuncT, typename ... Ts, size_t nops>
+            static
+            inline
+            void
+            run(
+                    FuncT & func,
+                    std::tuple<Ts*...> const & ptrs,
+                    std::array<long, nops> const &, //strides, known at compile time
+                    long n
+                    )
+            {
+                run_impl(func, ptrs, n, std::index_sequence_for<Ts...>());
+            }
+
+        private:
+
+            template <typename FuncT, typename ... Ts, size_t ... Is>
+            static
+            inline
+            void
+            run_impl(
+                    FuncT & func,
+                    std::tuple<Ts*...> const & ptrs,
+                    long n,
+                    std::index_sequence<Is...>
+                    )
+            {
+                static_assert(sizeof...(is_bcast) == sizeof...(Ts), "");
+
+                std::tuple<row_operand<is_bcast, Ts, cache_bcast>...> ops (
+                            row_operand<is_bcast, Ts, cache_bcast>(std::get<Is>(ptrs))...
+                            );
+
+                for (long i = 0; i < n; ++i) {
+                    func(std::get<Is>(ops).at(i)...);
+                }
+
+                (void) std::initializer_list<int> {(std::get<Is>(ops).finish(), 0)...};
+            }
+        };
+
+        /**
+         * Above this number of operands, only the case where all innermost strides are 1 gets
+         * a unit_row kernel, to avoid instantiating the loops for every combination of 0 and 1 strides.
+         */
+        constexpr size_t MAX_BCAST_ROW_OPERANDS = 4;
+
+        /**
+         * Builds the flags of unit_row by checking the innermost strides of each operand in turn,
+         * calls cont with an instance of the selected row kernel (or strided_row).
+         */
+        template <size_t iop, size_t nops, bool cache_bcast, bool ... is_bcast>
+        struct select_row_kernel {
+
+            template <typename ContT>
+            static
+            void
+            do_it(std::array<long, nops> const & strides, ContT & cont) {
+                constexpr bool allow_bcast = nops <= MAX_BCAST_ROW_OPERANDS;
+
+                if (strides[iop] == 1) {
+                    select_row_kernel<iop+1, nops, cache_bcast, is_bcast..., false>::do_it(strides, cont);
+                } else if (allow_bcast and strides[iop] == 0) {
+                    select_row_kernel<iop+1, nops, cache_bcast, is_bcast..., allow_bcast>::do_it(strides, cont);
+                } else {
+                    cont(strided_row());
+                }
+            }
+        };
+
+        template <size_t nops, bool cache_bcast, bool ... is_bcast>
+        struct select_row_kernel<nops, nops, cache_bcast, is_bcast...> {
+
+            template <typename ContT>
+            static
+            void
+            do_it(std::array<long, nops> const &, ContT & cont) {
+                cont(unit_row<cache_bcast, is_bcast...>());
+            }
+        };
+
+        /**
+         * Nested loops over the dimensions idim to ndims-1. The recursion is resolved at compile time,
+         * so once inlined this is equivalent to hand written nested loops incrementing raw pointers.
+         * The innermost dimension is handed over to the row kernel RowT.
+         */
         template <
-            int loop_type,
             long idim,
-            long ndims
+            long ndims,
+            bool innermost = (idim+1 == ndims)
         >
         struct dim_loop_recur {
 
             template <
+                typename RowT,
+                typename FuncT,
+                typename ... Ts,
+                size_t nops
+            >
+            static
+            inline
+            void
+            do_it(
+                    std::tuple<Ts*...> tup_ndata_ptrs, //pointers to data, taken by value and incremented
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    RowT row_kernel
+                    )
+            {
+                static_assert(sizeof...(Ts) == nops, "");
+                static_assert(idim<ndims, "");
+
+                const long n = geom.shape[idim];
+                const long * strides = geom.strides[idim].data();
+
+                for (long i = 0; i < n; ++i) {
+                    //run loop on next dimensions
+                    dim_loop_recur<idim+1, ndims>::do_it(tup_ndata_ptrs, func, geom, row_kernel);
+                    advance_ptrs(tup_ndata_ptrs, strides);
+                }
+            }
+        };
+
+        //innermost dimension, one call to the row kernel
+        template <
+            long idim,
+            long ndims
+        >
+        struct dim_loop_recur<idim, ndims, true> {
+
+            template <
+                typename RowT,
+                typename FuncT,
+                typename ... Ts,
+                size_t nops
+            >
+            static
+            inline
+            void
+            do_it(
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    RowT
+                    )
+            {
+                static_assert(sizeof...(Ts) == nops, "");
+
+                RowT::run(func, tup_ndata_ptrs, geom.strides[idim], geom.shape[idim]);
+            }
+        };
+
+        //recursion termination idim == ndims, only reached for 0D data
+        template <
+            long ndims
+        >
+        struct dim_loop_recur<ndims, ndims, false> {
+
+            template <
+                typename RowT,
                 typename FuncT,
                 typename ... Ts,
-                typename ... VecarrayLong
+                size_t nops
             >
             static
-            void
+            inline
+            void
+            do_it(
+                    std::tuple<Ts*...> tup_ndata_ptrs, //pointers to data
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const &, //geom, no remaining dimensions (last reached)
+                    RowT
+                    )
+            {
+                //apply the function to the scalars pointed by tup_ndata_ptrs
+                tuple_utilities::apply(func, tup_ndata_ptrs);
+            }
+        };
+
+        /**
+         * Cache line size assumed when partitioning loops between threads.
+         */
+        constexpr long CACHE_LINE_SIZE = 64;
+
+        /**
+         * Runs the elements [begin, end) of the flattened iteration space (rows of the innermost dimension
+         * laid end to end), starting in the middle of a row if needed.
+         */
+        template <typename RowT, typename FuncT, typename ... Ts, size_t nops, long ndims>
+        void
+        run_range(
+                std::tuple<Ts*...> const & tup_ndata_ptrs,
+                FuncT & func,
+                loop_geometry<nops, ndims> const & geom,
+                long begin,
+                long end
+                )
+        {
+            const long row_len = geom.shape[ndims-1];
+            if (begin >= end or row_len == 0) {
+                return;
+            }
+
+            //multidimensional index of the first row on the outer dimensions
+            std::array<long, ndims> idx;
+            std::tuple<Ts*...> row_ptrs = tup_ndata_ptrs;
+            long irow = begin/row_len;
+            long col = begin%row_len;
+            for (long idim = ndims-2; idim >= 0; --idim) {
+                idx[idim] = irow%geom.shape[idim];
+                irow /= geom.shape[idim];
+                row_ptrs = offset_ptrs(row_ptrs, geom.strides[idim].data(), idx[idim]);
+            }
+
+            long remaining = end-begin;
+            while (remaining > 0) {
+                long n = std::min(row_len-col, remaining);
+
+                RowT::run(
+                            func,
+                            offset_ptrs(row_ptrs, geom.strides[ndims-1].data(), col),
+                            geom.strides[ndims-1],
+                            n
+                            );
+
+                remaining -= n;
+                col = 0;
+
+                //move to the next row
+                for (long idim = ndims-2; idim >= 0; --idim) {
+                    advance_ptrs(row_ptrs, geom.strides[idim].data());
+                    if (++idx[idim] < geom.shape[idim]) {
+                        break;
+                    }
+                    idx[idim] = 0;
+                    row_ptrs = offset_ptrs(row_ptrs, geom.strides[idim].data(), -geom.shape[idim]);
+                }
+            }
+        }
+
+        /**
+         * @brief Number of elements of the flattened iteration space that chunk boundaries must be a multiple of.
+         *
+         * When there are enough rows, chunks are made of whole rows, grouped so that a chunk of a
+         * contiguous output covers whole cache lines. Otherwise the rows are split at cache line
+         * boundaries of the output. Either way two threads never write to the same cache line
+         * of a contiguous output, except at unaligned chunk borders.
+         *
+         * @param out_stride innermost stride of the output operand (the first one)
+         * @param line_elts number of output elements in a cache line
+         */
+        inline
+        long
+        chunk_grain(long n_rows, long row_len, long out_stride, long line_elts, long nthreads) {
+            bool contiguous_out = out_stride == 1 or out_stride == -1;
+
+            if (n_rows >= nthreads) {
+                long rows_per_line = 1;
+                if (contiguous_out and row_len < line_elts) {
+                    long a = row_len, b = line_elts;
+                    while (b != 0) {
+                        long r = a%b;
+                        a = b;
+                        b = r;
+                    }
+                    rows_per_line = line_elts/a;
+                }
+
+                if (n_rows/rows_per_line < nthreads) {
+                    rows_per_line = 1;
+                }
+
+                return rows_per_line*row_len;
+            }
+
+            return contiguous_out? line_elts : 1;
+        }
+
+        /**
+         * @brief Start of the chunk ithread when splitting total elements between nthreads
+         *  in chunks made of a whole number of grains.
+         */
+        inline
+        long
+        chunk_boundary(long total, long grain, long nthreads, long ithread) {
+            long ngrains = (total+grain-1)/grain;
+            return std::min(total, ngrains*ithread/nthreads*grain);
+        }
+
+        /**
+         * @brief true if the parallel loops of policy run on OpenMP, false for the thread_pool.
+         *  Without OpenMP support, requesting the OpenMP backend falls back on the thread_pool.
+         */
+        inline
+        bool
+        uses_openmp(parallel_policy const & policy) {
+#ifdef _OPENMP
+            return policy.backend != parallel_backend::THREAD_POOL;
+#else
+            (void) policy;
+            return false;
+#endif
+        }
+
+        template <size_t nops, long ndims>
+        long
+        loop_size(loop_geometry<nops, ndims> const & geom) {
+            long size = 1;
+            for (long idim = 0; idim < ndims; ++idim) {
+                size *= geom.shape[idim];
+            }
+            return size;
+        }
+
+        /**
+         * @brief Number of threads a parallel loop runs on with this policy.
+         */
+        inline
+        long
+        parallel_num_threads(parallel_policy const & policy) {
+#ifdef _OPENMP
+            if (uses_openmp(policy)) {
+                return (policy.num_threads > 0)? long(policy.num_threads) : long(omp_get_max_threads());
+            }
+#endif
+            size_t pool_size = thread_pool::global().size();
+            return long((policy.num_threads > 0)? std::min(policy.num_threads, pool_size) : pool_size);
+        }
+
+        /**
+         * @brief Split of the flattened iteration space in blocks of whole grains, the unit of scheduling
+         *  of the parallel loops.
+         */
+        struct block_partition {
+            long total;
+            long grain;
+            long nblocks;
+            long block; //elements in a block, or 0 for one balanced block per thread
+
+            long
+            begin(long iblock) const {
+                if (block == 0) {
+                    return chunk_boundary(total, grain, nblocks, iblock);
+                }
+                return std::min(total, iblock*block);
+            }
+        };
+
+        /**
+         * @brief Blocks of policy.chunk_size elements (rounded up to whole grains).
+         *
+         * Without a chunk size, the OpenMP STATIC schedule gets one balanced block per thread, the other
+         * OpenMP schedules blocks of thread_pool::GLOBAL_DEFAULT_GRAIN elements and the thread pool blocks of
+         * its default_grain(). In that case max_blocks, if not 0, caps the number of blocks.
+         */
+        inline
+        block_partition
+        make_block_partition(parallel_policy const & policy, long total, long grain, long nthreads, long max_blocks = 0) {
+            block_partition part;
+            part.total = total;
+            part.grain = grain;
+
+            long chunk = policy.chunk_size;
+            if (chunk <= 0) {
+                if (uses_openmp(policy) and policy.schedule == schedule_kind::STATIC) {
+                    part.block = 0;
+                    part.nblocks = std::max(1l, std::min(nthreads, (total+grain-1)/grain));
+                    return part;
+                }
+                chunk = uses_openmp(policy)? thread_pool::GLOBAL_DEFAULT_GRAIN : thread_pool::global().default_grain();
+                if (max_blocks > 0) {
+                    chunk = std::max(chunk, (total+max_blocks-1)/max_blocks);
+                }
+            }
+
+            part.block = grain*std::max(1l, (chunk+grain-1)/grain);
+            part.nblocks = std::max(1l, (total+part.block-1)/part.block);
+            return part;
+        }
+
+        /**
+         * @brief Calls func(iblock_begin, iblock_end) on ranges of the blocks [0, nblocks) in parallel, with
+         *  the threads, schedule and backend of the policy.
+         *
+         * OpenMP: the blocks are handed out one at a time with the matching OpenMP schedule.
+         * thread_pool: the blocks are split evenly between the threads then balanced by work stealing,
+         * whatever the schedule.
+         */
+        template <typename FuncT>
+        void
+        parallel_blocks(parallel_policy const & policy, long nthreads, long nblocks, FuncT func) {
+            if (nblocks <= 1 or nthreads <= 1) {
+                func(0l, nblocks);
+                return;
+            }
+
+#ifdef _OPENMP
+            if (uses_openmp(policy)) {
+                auto body = [&] () {
+                    if (policy.schedule == schedule_kind::STATIC) {
+#pragma omp for schedule(static, 1)
+                        for (long iblock = 0; iblock < nblocks; ++iblock) {
+                            func(iblock, iblock+1);
+                        }
+                    } else if (policy.schedule == schedule_kind::DYNAMIC) {
+#pragma omp for schedule(dynamic, 1)
+                        for (long iblock = 0; iblock < nblocks; ++iblock) {
+                            func(iblock, iblock+1);
+                        }
+                    } else {
+#pragma omp for schedule(guided)
+                        for (long iblock = 0; iblock < nblocks; ++iblock) {
+                            func(iblock, iblock+1);
+                        }
+                    }
+                };
+
+                if (policy.bind_threads) {
+#pragma omp parallel num_threads(nthreads) proc_bind(close)
+                    body();
+                } else {
+#pragma omp parallel num_threads(nthreads)
+                    body();
+                }
+                return;
+            }
+#endif
+
+            thread_pool & pool = thread_pool::global();
+            if (policy.bind_threads) {
+                pool.bind_threads();
+            }
+
+            pool.parallel_for(nblocks, 1, func, size_t(nthreads));
+        }
+
+        /**
+         * @brief Threads and blocks of a parallel loop.
+         */
+        struct parallel_partition {
+            long nthreads;
+            block_partition part;
+        };
+
+        /**
+         * @brief Split of the flattened range of the outer dimensions in blocks of whole grains (see
+         *  chunk_grain and make_block_partition), T0 being the type of the output operand.
+         */
+        template <typename T0, size_t nops, long ndims>
+        parallel_partition
+        make_parallel_partition(parallel_policy const & policy, loop_geometry<nops, ndims> const & geom) {
+            const long row_len = geom.shape[ndims-1];
+            const long total = loop_size(geom);
+            const long n_rows = (row_len == 0)? 0 : total/row_len;
+            const long line_elts = std::max(1l, CACHE_LINE_SIZE/long(sizeof(T0)));
+
+            const long nthreads = parallel_num_threads(policy);
+            const long grain = chunk_grain(n_rows, row_len, geom.strides[ndims-1][0], line_elts, nthreads);
+            return parallel_partition {nthreads, make_block_partition(policy, total, grain, nthreads)};
+        }
+
+        /**
+         * Parallel loops on the flattened range of the outer dimensions, distributed according to the
+         * policy.
+         */
+        template <typename RowT, typename FuncT, typename ... Ts, size_t nops, long ndims>
+        void
+        run_partitioned(
+                parallel_policy const & policy,
+                std::tuple<Ts*...> const & tup_ndata_ptrs,
+                FuncT & func,
+                loop_geometry<nops, ndims> const & geom,
+                parallel_partition const & partition
+                )
+        {
+            const block_partition & part = partition.part;
+
+            parallel_blocks(
+                        policy,
+                        partition.nthreads,
+                        part.nblocks,
+                        [&] (long iblock_begin, long iblock_end) {
+                            run_range<RowT>(
+                                        tup_ndata_ptrs,
+                                        func,
+                                        geom,
+                                        part.begin(iblock_begin),
+                                        part.begin(iblock_end)
+                                        );
+                        });
+        }
+
+        template <typename RowT, typename FuncT, typename T0, typename ... Ts, size_t nops, long ndims>
+        void
+        run_parallel(
+                parallel_policy const & policy,
+                std::tuple<T0*, Ts*...> const & tup_ndata_ptrs,
+                FuncT & func,
+                loop_geometry<nops, ndims> const & geom
+                )
+        {
+            run_partitioned<RowT>(policy, tup_ndata_ptrs, func, geom, make_parallel_partition<T0>(policy, geom));
+        }
+
+        /**
+         * Serial loops, or parallel loops over the flattened outer dimensions.
+         */
+        template <long ndims>
+        struct dim_loop_outer {
+
+            template <typename RowT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it(
+                    serial_policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    RowT row_kernel
+                    )
+            {
+                dim_loop_recur<0, ndims>::do_it(tup_ndata_ptrs, func, geom, row_kernel);
+            }
+
+            template <typename RowT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it(
+                    parallel_policy const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    RowT row_kernel
+                    )
+            {
+                if (loop_size(geom) < policy.min_work) {
+                    dim_loop_recur<0, ndims>::do_it(tup_ndata_ptrs, func, geom, row_kernel);
+                } else {
+                    run_parallel<RowT>(policy, tup_ndata_ptrs, func, geom);
+                }
+            }
+        };
+
+        //0D case, nothing to parallelize
+        template <>
+        struct dim_loop_outer<0> {
+
+            template <typename PolicyT, typename RowT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it(
+                    PolicyT const &,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, 0> const & geom,
+                    RowT row_kernel
+                    )
+            {
+                dim_loop_recur<0, 0>::do_it(tup_ndata_ptrs, func, geom, row_kernel);
+            }
+        };
+
+        /**
+         * Side, in elements, of the square tiles of the traversals of operands with conflicting strides.
+         */
+        constexpr long LOOP_TILE_SIZE = 64;
+
+        /**
+         * @brief Dimension to traverse in tiles together with the innermost one, or -1.
+         *
+         * The loop planner can't satisfy operands which are contiguous along different dimensions, like
+         * the two sides of a transposition: one of them then jumps to a new cache line at each step of the
+         * innermost loop, and by the time the next row comes back to these lines they have been evicted.
+         * That is detected here as an operand moving by at least a cache line along the innermost
+         * dimension while another dimension has it move within a cache line.
+         */
+        template <typename ... Ts, size_t nops, long ndims>
+        long
+        tiling_dim(loop_geometry<nops, ndims> const & geom) {
+            const long inner = ndims-1;
+            if (inner < 1 or geom.shape[inner] < LOOP_TILE_SIZE) {
+                return -1;
+            }
+
+            const std::array<long, nops> elt_sizes = {{long(sizeof(Ts))...}};
+            for (size_t iop = 0; iop < nops; ++iop) {
+                if (std::abs(geom.strides[inner][iop])*elt_sizes[iop] < CACHE_LINE_SIZE) {
+                    continue;
+                }
+
+                long best = -1;
+                for (long idim = 0; idim < inner; ++idim) {
+                    long stride = std::abs(geom.strides[idim][iop]);
+                    if (stride != 0 and stride*elt_sizes[iop] < CACHE_LINE_SIZE
+                            and geom.shape[idim] >= LOOP_TILE_SIZE
+                            and (best < 0 or stride < std::abs(geom.strides[best][iop]))) {
+                        best = idim;
+                    }
+                }
+                if (best >= 0) {
+                    return best;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Selects the row kernel from the innermost strides, then runs the loops. Operands with
+         * conflicting strides (see tiling_dim) are traversed in tiles. cache_bcast: see row_operand.
+         */
+        template <long ndims, bool cache_bcast = false>
+        struct loop_runner {
+
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom
+                    )
+            {
+                do_it_maybe_tiled(policy, tup_ndata_ptrs, func, geom, std::integral_constant<bool, (ndims >= 2)>());
+            }
+
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            run_untiled(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom
+                    )
+            {
+                auto cont = [&] (auto row_kernel) {
+                    dim_loop_outer<ndims>::do_it(policy, tup_ndata_ptrs, func, geom, row_kernel);
+                };
+
+                select_row_kernel<0, nops, cache_bcast>::do_it(geom.strides[ndims-1], cont);
+            }
+
+        private:
+
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it_maybe_tiled(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    std::false_type
+                    )
+            {
+                run_untiled(policy, tup_ndata_ptrs, func, geom);
+            }
+
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it_maybe_tiled(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    std::true_type
+                    )
+            {
+                const long idim_tile = tiling_dim<Ts...>(geom);
+                if (idim_tile < 0) {
+                    run_untiled(policy, tup_ndata_ptrs, func, geom);
+                } else {
+                    run_tiled(policy, tup_ndata_ptrs, func, geom, idim_tile);
+                }
+            }
+
+            /**
+             * The whole tiles are run as a geometry with two more dimensions: the other dimensions, then
+             * the tile indices along idim_tile and the innermost dimension, then the positions in the tile.
+             * The remaining partial tiles along both dimensions are run as two strips afterwards.
+             *
+             * Along every dimension the elements are still visited in increasing order.
+             */
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            run_tiled(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, ndims> const & geom,
+                    long idim_tile
+                    )
+            {
+                const long inner = ndims-1;
+                const long n_tile = geom.shape[idim_tile], n_inner = geom.shape[inner];
+                const long n_tile_main = n_tile/LOOP_TILE_SIZE*LOOP_TILE_SIZE;
+                const long n_inner_main = n_inner/LOOP_TILE_SIZE*LOOP_TILE_SIZE;
+
+                loop_geometry<nops, ndims+2> tiled;
+                long itiled = 0;
+                for (long idim = 0; idim < inner; ++idim) {
+                    if (idim != idim_tile) {
+                        tiled.shape[itiled] = geom.shape[idim];
+                        tiled.strides[itiled] = geom.strides[idim];
+                        ++itiled;
+                    }
+                }
+                for (long k = 0; k < 2; ++k) {
+                    long idim = (k == 0)? idim_tile : inner;
+                    tiled.shape[ndims-2+k] = geom.shape[idim]/LOOP_TILE_SIZE;
+                    tiled.shape[ndims+k] = LOOP_TILE_SIZE;
+                    tiled.strides[ndims+k] = geom.strides[idim];
+                    for (size_t iop = 0; iop < nops; ++iop) {
+                        tiled.strides[ndims-2+k][iop] = LOOP_TILE_SIZE*geom.strides[idim][iop];
+                    }
+                }
+                loop_runner<ndims+2, cache_bcast>::run_untiled(policy, tup_ndata_ptrs, func, tiled);
+
+                //partial tiles at the end of the rows, then the last rows along idim_tile
+                if (n_inner_main < n_inner) {
+                    loop_geometry<nops, ndims> strip = geom;
+                    strip.shape[idim_tile] = n_tile_main;
+                    strip.shape[inner] = n_inner-n_inner_main;
+                    run_untiled(policy, offset_ptrs(tup_ndata_ptrs, geom.strides[inner].data(), n_inner_main), func, strip);
+                }
+                if (n_tile_main < n_tile) {
+                    loop_geometry<nops, ndims> strip = geom;
+                    strip.shape[idim_tile] = n_tile-n_tile_main;
+                    run_untiled(policy, offset_ptrs(tup_ndata_ptrs, geom.strides[idim_tile].data(), n_tile_main), func, strip);
+                }
+            }
+        };
+
+        //0D case, no row
+        template <bool cache_bcast>
+        struct loop_runner<0, cache_bcast> {
+
+            template <typename PolicyT, typename FuncT, typename ... Ts, size_t nops>
+            static
+            void
+            do_it(
+                    PolicyT const & policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    FuncT & func,
+                    loop_geometry<nops, 0> const & geom
+                    )
+            {
+                dim_loop_outer<0>::do_it(policy, tup_ndata_ptrs, func, geom, strided_row());
+            }
+        };
+
+        /**
+         * Blocks per thread of a parallel reduction when the policy doesn't set a chunk size, enough
+         * for the thread pool to balance the load while keeping few accumulators.
+         */
+        constexpr long REDUCE_BLOCKS_PER_THREAD = 8;
+
+        //one accumulator per block, wrapped so that std::vector<bool> never gets involved
+        template <typename Tacc>
+        struct reduce_slot {
+            Tacc val;
+        };
+
+        /**
+         * @brief Combines the accumulators pairwise, adjacent ones first (tree reduction).
+         */
+        template <typename Tacc, typename CombineT>
+        Tacc
+        tree_combine(std::vector<reduce_slot<Tacc>> & partials, CombineT & combine) {
+            const size_t n = partials.size();
+            for (size_t step = 1; step < n; step *= 2) {
+                for (size_t i = 0; i+step < n; i += 2*step) {
+                    partials[i].val = combine(partials[i].val, partials[i+step].val);
+                }
+            }
+            return partials[0].val;
+        }
+
+        /**
+         * Runs the loops folding the elements into accumulators. In parallel, each block of the
+         * flattened iteration space (see make_block_partition) is folded into its own accumulator, so
+         * the accumulators are private to a thread. They are then combined pairwise in block order,
+         * which makes the result independent of the thread timings for a given policy and thread count.
+         */
+        template <long ndims>
+        struct reduce_runner {
+
+            template <typename Tacc, typename AccFuncT, typename CombineT, typename ... Ts, size_t nops>
+            static
+            Tacc
+            do_it(
+                    serial_policy,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    loop_geometry<nops, ndims> const & geom,
+                    Tacc const & identity,
+                    AccFuncT & acc_func,
+                    CombineT &
+                    )
+            {
+                Tacc acc = identity;
+                auto func = [&acc, &acc_func] (auto & ... vals) {
+                    acc_func(acc, vals...);
+                };
+                loop_runner<ndims>::do_it(serial_policy(), tup_ndata_ptrs, func, geom);
+                return acc;
+            }
+
+            template <typename Tacc, typename AccFuncT, typename CombineT, typename T0, typename ... Ts, size_t nops>
+            static
+            Tacc
+            do_it(
+                    parallel_policy const & policy,
+                    std::tuple<T0*, Ts*...> tup_ndata_ptrs,
+                    loop_geometry<nops, ndims> const & geom,
+                    Tacc const & identity,
+                    AccFuncT & acc_func,
+                    CombineT & combine
+                    )
+            {
+                const long total = loop_size(geom);
+                if (total < policy.min_work) {
+                    return do_it(serial_policy(), tup_ndata_ptrs, geom, identity, acc_func, combine);
+                }
+
+                const long row_len = geom.shape[ndims-1];
+                const long n_rows = (row_len == 0)? 0 : total/row_len;
+                const long line_elts = std::max(1l, CACHE_LINE_SIZE/long(sizeof(T0)));
+
+                const long nthreads = parallel_num_threads(policy);
+                const long grain = chunk_grain(n_rows, row_len, geom.strides[ndims-1][0], line_elts, nthreads);
+                const block_partition part = make_block_partition(
+                            policy,
+                            total,
+                            grain,
+                            nthreads,
+                            nthreads*REDUCE_BLOCKS_PER_THREAD
+                            );
+
+                std::vector<reduce_slot<Tacc>> partials (part.nblocks, reduce_slot<Tacc> {identity});
+
+                auto cont = [&] (auto row_kernel) {
+                    using RowT = decltype(row_kernel);
+
+                    parallel_blocks(
+                                policy,
+                                nthreads,
+                                part.nblocks,
+                                [&] (long iblock_begin, long iblock_end) {
+                                    for (long iblock = iblock_begin; iblock < iblock_end; ++iblock) {
+                                        Tacc acc = identity;
+                                        auto func = [&acc, &acc_func] (auto & ... vals) {
+                                            acc_func(acc, vals...);
+                                        };
+                                        run_range<RowT>(
+                                                    tup_ndata_ptrs,
+                                                    func,
+                                                    geom,
+                                                    part.begin(iblock),
+                                                    part.begin(iblock+1)
+                                                    );
+                                        partials[iblock].val = acc;
+                                    }
+                                });
+                };
+
+                select_row_kernel<0, nops, false>::do_it(geom.strides[ndims-1], cont);
+
+                return tree_combine(partials, combine);
+            }
+        };
+
+        //0D case, a single element
+        template <>
+        struct reduce_runner<0> {
+
+            template <typename PolicyT, typename Tacc, typename AccFuncT, typename CombineT, typename ... Ts, size_t nops>
+            static
+            Tacc
             do_it(
-                    std::tuple<Ts*...> tup_ndata_ptrs, //pointers to data
-                    FuncT  func,
-                    vecarray<long, ndims-idim>  shape, //only "remaining" dimensions
-                    std::tuple<
-                        VecarrayLong...
-                        > arr_strides
+                    PolicyT const &,
+                    std::tuple<Ts*...> tup_ndata_ptrs,
+                    loop_geometry<nops, 0> const & geom,
+                    Tacc const & identity,
+                    AccFuncT & acc_func,
+                    CombineT &
                     )
             {
-                static_assert(std::tuple_size<decltype(tup_ndata_ptrs)>() == std::tuple_size<decltype(arr_strides)>(), "");
-                static_assert(idim<ndims, "");
-                static_assert(ndims!=DYNAMICALLY_SIZED, "not implemented");
+                Tacc acc = identity;
+                auto func = [&acc, &acc_func] (auto & ... vals) {
+                    acc_func(acc, vals...);
+                };
+                loop_runner<0>::do_it(serial_policy(), tup_ndata_ptrs, func, geom);
+                return acc;
+            }
+        };
 
-                std::function<void(size_t)> loop_inner_block (
-                            [&] (size_t i) {
-                                auto tup_current_stride = tuple_utilities::tuple_transform(
-                                            [] (vecarray<long, ndims-idim> strides) {return strides[0];},
-                                            arr_strides
-                                        );
+        /**
+         * @brief Execution policy equivalent to a loop type.
+         */
+        inline
+        serial_policy
+        loop_type_policy(std::integral_constant<int, SERIAL>) {
+            return serial_policy();
+        }
 
-                                auto tup_strides_tail = tuple_utilities::tuple_transform(
-                                            [] (vecarray<long, ndims-idim> strides) {return strides.drop_front();},
-                                            arr_strides
-                                        );
+        inline
+        parallel_policy
+        loop_type_policy(std::integral_constant<int, PARALLEL>) {
+            return parallel_policy();
+        }
 
-                                auto tup_tup_ndata_ptr_stride = tuple_utilities::zip(
-                                            tup_ndata_ptrs,
-                                            tup_current_stride
-                                        );
+        inline
+        parallel_policy
+        loop_type_policy(std::integral_constant<int, THREAD_POOL>) {
+            return parallel_policy().with_backend(parallel_backend::THREAD_POOL);
+        }
 
-                                //add current index and stride to the data pointers
-                                std::tuple<Ts*...> new_ndata_ptrs = tuple_utilities::tuple_transform(
-                                            [i] (auto tup_ndata_ptr_stride) {
-                                    auto ndata_ptr = std::get<0>(tup_ndata_ptr_stride);
-                                    long strd = std::get<1>(tup_ndata_ptr_stride);
-                                    return ndata_ptr+i*strd; },
-                                tup_tup_ndata_ptr_stride
-                                );
-
-                                //run loop on next dimensions
-                                dim_loop_recur<SERIAL, idim+1, ndims>::do_it(
-                                            new_ndata_ptrs,
-                                            func,
-                                            shape.drop_front(),
-                                            tup_strides_tail
-                                            );
-                            }
-                );
+        template <int loop_type>
+        auto
+        loop_type_policy() {
+            return loop_type_policy(std::integral_constant<int, loop_type>());
+        }
 
-                if (loop_type == SERIAL) {
-                    for (size_t i = 0; i < size_t(shape[0]); ++i) {
-                        loop_inner_block(i);
-                    }
-                } else {
-#pragma omp parallel for schedule(static)
-                    for (size_t i = 0; i < size_t(shape[0]); ++i) {
-                        loop_inner_block(i);
-                    }
-                }
-            }
-        };
+        //also true for the classes deriving from ndatacontainer, like nvector
+        template <typename ContainerT, typename T, long ndims>
+        std::true_type
+        is_ndatacontainer_impl(ndatacontainer<ContainerT, T, ndims> const *);
 
-        //recursion termination idim == ndims
-        template <
-            int loop_type,
-            long ndims
-        >
-        struct dim_loop_recur<loop_type, ndims, ndims> {
+        std::false_type
+        is_ndatacontainer_impl(...);
 
+        template <typename T>
+        struct is_ndatacontainer: decltype(is_ndatacontainer_impl(std::declval<typename std::decay<T>::type *>())) { };
 
-            template <
-                    typename FuncT,
-                    typename ... Ts,
-                    typename ... VecarrayLong
-                    >
-            static
+        template <typename T>
+        struct is_tuple: std::false_type { };
+
+        template <typename ... Ts>
+        struct is_tuple<std::tuple<Ts...>>: std::true_type { };
+
+        /**
+         * @brief Calls func with the elements offset to offset+sizeof...(Is) of args.
+         */
+        template <size_t offset, typename FuncT, typename TupT, size_t ... Is>
+        inline
+        auto
+        call_with_args_slice(FuncT const & func, TupT const & args, std::index_sequence<Is...>) {
+            return func(std::get<offset+Is>(args)...);
+        }
+
+        template <typename OutTupT, typename ResultTupT, size_t ... Is>
+        inline
+        void
+        assign_outputs(OutTupT & outs, ResultTupT && results, std::index_sequence<Is...>) {
+            (void) std::initializer_list<int> {(std::get<Is>(outs) = std::get<Is>(results), 0)...};
+        }
+
+        /**
+         * Loop body of the transforms with several outputs: the first nout elements are the outputs,
+         * func takes the others and returns a tuple of the output values.
+         */
+        template <size_t nout, typename FuncT>
+        struct multi_output_func {
+            FuncT func;
+
+            template <typename ... Vals>
             void
-            do_it(
-                    std::tuple<Ts*...> tup_ndata_ptrs, //pointers to data
-                    FuncT func,
-                    vecarray<long, 0> , //shape, no remaining dimensions (last reached)
-                    std::tuple<
-                    VecarrayLong... //no remaining dimensions (last reached)
-                    >
-                    //arr_strides
-                    )
-            {
-                //static_assert(idim==ndims, "");
-                //apply the function to the scalars pointed by tup_ndata_ptrs
-                tuple_utilities::apply(func, tup_ndata_ptrs);
-            };
+            operator()(Vals & ... vals) const {
+                auto args = std::forward_as_tuple(vals...);
+                assign_outputs(
+                            args,
+                            call_with_args_slice<nout>(func, args, std::make_index_sequence<sizeof...(Vals)-nout>()),
+                            std::make_index_sequence<nout>()
+                            );
+            }
         };
 
+        /**
+         * @brief Throws if an output has been broadcasted by the inputs, its elements would be
+         *  written several times.
+         */
+        template <long ndims_out, long ndims_bc>
+        void
+        check_output_shape(vecarray<long, ndims_out> out_shape, vecarray<long, ndims_bc> bc_shape) {
+            bool same_shape = out_shape.size() == bc_shape.size();
+            for (size_t i = 0; same_shape and i < out_shape.size(); ++i) {
+                same_shape = out_shape[i] == bc_shape[i];
+            }
+            if (not same_shape) {
+                throw(std::domain_error("The inputs don't broadcast to the shape of the output"));
+            }
+        }
+
+        template <typename ... OutViewTs, typename ... BcViewTs, size_t ... Is>
+        void
+        check_outputs_shape(
+                std::tuple<OutViewTs...> out_views,
+                std::tuple<BcViewTs...> views_bc,
+                std::index_sequence<Is...>
+                )
+        {
+            (void) std::initializer_list<int> {
+                (check_output_shape(std::get<Is>(out_views).get_shape(), std::get<Is>(views_bc).get_shape()), 0)...
+            };
+        }
+
+        /**
+         * @brief Runs func_outputs(outs..., ins...) on the outputs broadcasted together with the inputs,
+         *  which must not change the shape of the outputs.
+         */
+        template <typename PolicyT, typename ... OutViewTs, typename ... InViewTs, typename FuncT>
+        void
+        transform_into(
+                PolicyT const & policy,
+                std::tuple<OutViewTs...> out_views,
+                std::tuple<InViewTs...> in_views,
+                FuncT func_outputs
+                )
+        {
+            auto views_bc = broadcast(std::tuple_cat(out_views, in_views));
+            check_outputs_shape(out_views, views_bc, std::index_sequence_for<OutViewTs...>());
+            nforeach_base(policy, views_bc, func_outputs);
+        }
 
+        /**
+         * @brief Loops of nforeach_base on broadcasted views. With cache_bcast, the functor gets the
+         *  broadcasted operands of trivially copyable types as a local copy for the length of a row,
+         *  written back at the end of the row (see row_operand): only for the internal loops which
+         *  accumulate into them and don't take their address.
+         */
+        template <bool cache_bcast, typename PolicyT, long ... ndims, typename ... Ts, typename FuncT>
+        void
+        run_views(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views, FuncT & func)  {
+
+            //get pointers to first element of data
+            std::tuple<Ts*...> tup_ndata_ptrs = tuple_utilities::tuple_transform(
+                        [] (auto ndv) {return ndv.data_+ndv.get_start_index();},
+                        ndata_views
+                    );
+
+            //all containers have been broadcasted and have the same shape at this point
+            constexpr long ndims_bc = decltype(std::get<0>(ndata_views).get_shape())::STATIC_SIZE_OR_DYNAMIC;
+
+            auto geom = make_loop_geometry<ndims_bc>(ndata_views);
+            optimize_loop_geometry(geom);
+
+            loop_runner<ndims_bc, cache_bcast>::do_it(
+                        policy,
+                        tup_ndata_ptrs,
+                        func,
+                        geom
+                        );
+        }
+
+        /**
+         * @brief nforeach for the internal reductions into broadcasted accumulators, see run_views.
+         */
+        template <typename PolicyT, typename FuncT, typename... Ts, long ndims>
+        void
+        nforeach_accumulate(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views, FuncT func)  {
+            run_views<true>(policy, broadcast(ndata_views), func);
+        }
 
     }
 
 
+    /**
+     * @brief nforeach on views which have already been broadcasted together. The functor gets references
+     *  to the elements themselves, broadcasted operands included.
+     */
+    template <
+            typename PolicyT,
+            long ... ndims,
+            typename ... Ts,
+            typename FuncT
+            >
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    nforeach_base(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_views, FuncT func)  {
+        helpers::run_views<false>(policy, ndata_views, func);
+    }
+
     template <
             int loop_type = SERIAL,
             long ... ndims,
@@ -143,46 +1445,37 @@ namespace ndata {
             >
     void
     nforeach_base(std::tuple<ndataview<Ts, ndims>...> ndata_views, FuncT func)  {
+        nforeach_base(helpers::loop_type_policy<loop_type>(), ndata_views, func);
+    }
 
-        //get pointers to first element of data
-        std::tuple<Ts*...> tup_ndata_ptrs = tuple_utilities::tuple_transform(
-                    [] (auto ndv) {return ndv.data_+ndv.get_start_index();},
-                    ndata_views
-                );
-
-        //all containers have been broadcasted and have the same shape at this point
-        auto shape = std::get<0>(ndata_views).get_shape();
-
-        //std::tuple<
-        //        vecarray<long, ndims>
-        //    >
-        auto
-        strides = tuple_utilities::tuple_transform(
-                    [] (auto ndv) {return ndv.get_strides();},
-                    ndata_views
-                );
-
-        helpers::dim_loop_recur<loop_type, 0, shape.STATIC_SIZE_OR_DYNAMIC>::do_it(
-                    tup_ndata_ptrs,
-                    func,
-                    shape,
-                    strides
-                    );
+    /**
+     * @brief Calls func on the elements of the broadcasted containers, with the given execution policy
+     *  (serial_policy or parallel_policy).
+     */
+    template <typename PolicyT, typename FuncT, typename... Ndatacontainer>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    nforeach(PolicyT const & policy, std::tuple<Ndatacontainer&...> ndata_tup_refs, FuncT func)  {
+        auto ndata_views = helpers::broadcast_views(ndata_tup_refs);
+        nforeach_base(policy, ndata_views, func);
+    }
 
+    template <typename PolicyT, typename FuncT, typename... Ts, long ndims>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    nforeach(PolicyT const & policy, std::tuple<ndataview<Ts, ndims>...> ndata_tup_refs, FuncT func)  {
+        auto ndata_views = helpers::broadcast(ndata_tup_refs);
+        nforeach_base(policy, ndata_views, func);
     }
 
     template <int loop_type = SERIAL , typename FuncT, typename... Ndatacontainer>
     void
     nforeach(std::tuple<Ndatacontainer&...> ndata_tup_refs, FuncT func)  {
-        auto ndata_views = helpers::broadcast_views(ndata_tup_refs);
-        nforeach_base<loop_type>(ndata_views, func);
+        nforeach(helpers::loop_type_policy<loop_type>(), ndata_tup_refs, func);
     }
 
     template <int loop_type = SERIAL , typename FuncT, typename... Ts, long ndims>
     void
     nforeach(std::tuple<ndataview<Ts, ndims>...> ndata_tup_refs, FuncT func)  {
-        auto ndata_views = helpers::broadcast(ndata_tup_refs);
-        nforeach_base<loop_type>(ndata_views, func);
+        nforeach(helpers::loop_type_policy<loop_type>(), ndata_tup_refs, func);
     }
 
 
@@ -200,21 +1493,31 @@ namespace ndata {
         nforeach_base<PARALLEL>(ndata_views, func);
     }
 
-    //TODO make this able to infer Tret
-    template <typename Tret, int loop_type = SERIAL, typename FuncT, typename... Ndatacontainer>
+    /**
+     * @brief Returns a new nvector with the results of func on the elements of the broadcasted containers.
+     *
+     * The result is allocated with the UNINITIALIZED constructor, which doesn't save anything yet:
+     * std::vector value-initializes it, a write pass before the loop. To avoid it, write into an
+     * existing container with ntransform(policy, tup, out, func).
+     */
+    template <typename Tret, typename PolicyT, typename FuncT, typename... Ndatacontainer>
     auto //nvector<Tret, ndims_broadcasted>
-    ntransform(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+    ntransform(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+
+        static_assert(is_execution_policy<PolicyT>::value, "");
 
         auto ndata_tuple_bcviews = helpers::broadcast_views(ndata_tup);
 
         //broadcast arguments against each others
         //auto ndata_tuple_bc = helpers::broadcast(ndata_tuple_views);
 
-        //init return nvector with correct shape
+        //return nvector with correct shape, every element is written by the loop (after std::vector
+        //value-initialized them, see above)
         auto retshape = std::get<0>(ndata_tuple_bcviews).get_shape();
-        nvector<Tret, retshape.STATIC_SIZE_OR_DYNAMIC> ret (std::get<0>(ndata_tuple_bcviews), 0);
+        nvector<Tret, retshape.STATIC_SIZE_OR_DYNAMIC> ret (std::get<0>(ndata_tuple_bcviews), UNINITIALIZED);
 
-        nforeach_base<loop_type>(
+        nforeach_base(
+                    policy,
                     std::tuple_cat(
                         std::make_tuple(ret.as_view()),
                         ndata_tuple_bcviews
@@ -228,16 +1531,712 @@ namespace ndata {
         return ret;
     }
 
+    template <typename Tret, int loop_type = SERIAL, typename FuncT, typename... Ndatacontainer>
+    auto //nvector<Tret, ndims_broadcasted>
+    ntransform(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+        return ntransform<Tret>(helpers::loop_type_policy<loop_type>(), ndata_tup, func);
+    }
+
+
+    namespace helpers {
+
+        /**
+         * Allocation of the result of ntransform from the type returned by the functor: an nvector, or a
+         * tuple of nvectors filled in the same loop when the functor returns a tuple.
+         */
+        template <typename Tret>
+        struct transform_alloc {
+
+            template <typename PolicyT, typename FuncT, typename ... Ndatacontainer>
+            static
+            auto
+            do_it(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, FuncT func) {
+                return ntransform<Tret>(policy, ndata_tup, func);
+            }
+        };
+
+        template <typename ... Trets>
+        struct transform_alloc<std::tuple<Trets...>> {
+
+            template <typename PolicyT, typename FuncT, typename ... Ndatacontainer>
+            static
+            auto
+            do_it(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, FuncT func) {
+                auto in_views_bc = broadcast_views(ndata_tup);
+                auto shape = std::get<0>(in_views_bc).get_shape();
+                indexer<shape.STATIC_SIZE_OR_DYNAMIC> idxr (shape);
+
+                auto rets = std::make_tuple(nvector<Trets, shape.STATIC_SIZE_OR_DYNAMIC>(idxr, UNINITIALIZED)...);
+                auto ret_views = tuple_utilities::tuple_transform([] (auto & r) {return r.as_view();}, rets);
+
+                nforeach_base(
+                            policy,
+                            std::tuple_cat(ret_views, in_views_bc),
+                            multi_output_func<sizeof...(Trets), FuncT> {func}
+                            );
+                return rets;
+            }
+        };
+
+    }
+
+    /**
+     * @brief Same as ntransform<Tret>, the type of the result being the one returned by func. If func returns
+     *  a std::tuple, the result is a tuple of nvectors (one per element of the tuple), filled in a single loop:
+     *
+     * nvector<float, 2> speed, direction;
+     * std::tie(speed, direction) = ntransform(parallel_policy(), std::tie(u, v), [] (float vu, float vv) {
+     *     return std::make_tuple(std::hypot(vu, vv), std::atan2(vv, vu));
+     * });
+     */
+    template <
+            typename PolicyT,
+            typename FuncT,
+            typename... Ndatacontainer,
+            typename = typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+            >
+    auto
+    ntransform(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+        typedef typename std::decay<
+                decltype(func(std::declval<typename std::decay<Ndatacontainer>::type::type_T &>()...))
+            >::type Tret;
+
+        return helpers::transform_alloc<Tret>::do_it(policy, ndata_tup, func);
+    }
+
+    template <int loop_type = SERIAL, typename FuncT, typename... Ndatacontainer>
+    auto
+    ntransform(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+        return ntransform(helpers::loop_type_policy<loop_type>(), ndata_tup, func);
+    }
+
+    /**
+     * @brief Writes the results of func on the elements of the broadcasted input containers into out,
+     *  which must have their broadcasted shape.
+     */
+    template <
+            typename PolicyT,
+            typename FuncT,
+            typename... Ndatacontainer,
+            typename OutT,
+            typename = typename std::enable_if<
+                is_execution_policy<PolicyT>::value and helpers::is_ndatacontainer<OutT>::value
+                >::type
+            >
+    void
+    ntransform(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, OutT && out, FuncT func)  {
+        typedef typename std::decay<OutT>::type::type_T Tout;
+
+        helpers::transform_into(
+                    policy,
+                    std::make_tuple(out.as_view()),
+                    helpers::broadcast_views(ndata_tup),
+                    [func] (Tout & out_val, auto ... param_vals) {
+                        out_val = func(param_vals...);
+                    });
+    }
+
+    /**
+     * @brief Several outputs filled in one loop: func returns a tuple with one value per output.
+     *
+     * ntransform(serial_policy(), std::tie(u, v), std::tie(speed, direction), [] (float vu, float vv) {
+     *     return std::make_tuple(std::hypot(vu, vv), std::atan2(vv, vu));
+     * });
+     */
+    template <
+            typename PolicyT,
+            typename FuncT,
+            typename... Ndatacontainer,
+            typename... OutputNdatacontainer,
+            typename = typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+            >
+    void
+    ntransform(
+            PolicyT const & policy,
+            std::tuple<Ndatacontainer...> ndata_tup,
+            std::tuple<OutputNdatacontainer&...> outputs,
+            FuncT func
+            )
+    {
+        helpers::transform_into(
+                    policy,
+                    tuple_utilities::tuple_transform([] (auto & out) {return out.as_view();}, outputs),
+                    helpers::broadcast_views(ndata_tup),
+                    helpers::multi_output_func<sizeof...(OutputNdatacontainer), FuncT> {func}
+                    );
+    }
 
     template <typename Tret, typename FuncT, typename... Ndatacontainer>
     auto //nvector<Tret, ndims_broadcasted>
     ntransform_parallel(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
-        ntransform<Tret, PARALLEL>(ndata_tup, func);
+        return ntransform<Tret, PARALLEL>(ndata_tup, func);
+    }
+
+
+
+    /**
+     * @brief Reduces the elements of the broadcasted containers to a single value.
+     *
+     * acc_func(acc, vals...) folds a set of matching elements into an accumulator of type Tacc, taken by
+     * reference. combine(acc1, acc2) returns the merge of two accumulators. identity must be neutral for
+     * combine, and combine associative. In parallel each thread folds its elements into private
+     * accumulators initialized with identity, which are merged with a tree of combine calls.
+     *
+     * A dot product:
+     *
+     * double dot = nreduce(
+     *         parallel_policy(),
+     *         std::tie(u, v),
+     *         0.,
+     *         [] (double & acc, float a, float b) {acc += a*b;},
+     *         [] (double a, double b) {return a+b;}
+     *         );
+     */
+    template <typename PolicyT, typename Tacc, typename AccFuncT, typename CombineT, typename... Ndatacontainer>
+    typename std::enable_if<is_execution_policy<PolicyT>::value, Tacc>::type
+    nreduce(
+            PolicyT const & policy,
+            std::tuple<Ndatacontainer...> ndata_tup,
+            Tacc identity,
+            AccFuncT acc_func,
+            CombineT combine
+            )
+    {
+        auto ndata_views = helpers::broadcast_views(ndata_tup);
+
+        auto tup_ndata_ptrs = tuple_utilities::tuple_transform(
+                    [] (auto ndv) {return ndv.data_+ndv.get_start_index();},
+                    ndata_views
+                );
+
+        constexpr long ndims_bc = decltype(std::get<0>(ndata_views).get_shape())::STATIC_SIZE_OR_DYNAMIC;
+
+        auto geom = helpers::make_loop_geometry<ndims_bc>(ndata_views);
+        helpers::optimize_loop_geometry(geom);
+
+        return helpers::reduce_runner<ndims_bc>::do_it(policy, tup_ndata_ptrs, geom, identity, acc_func, combine);
+    }
+
+    /**
+     * @brief nreduce for accumulations where merging two accumulators is the same as folding one into
+     *  the other, like sums, products, min or max of the elements of a single container:
+     *  combine(a, b) is acc_func(a, b) then a. The accumulator is then folded in as an element, so it
+     *  must have the element type, pass an explicit combine otherwise.
+     */
+    template <typename PolicyT, typename Tacc, typename AccFuncT, typename... Ndatacontainer>
+    typename std::enable_if<is_execution_policy<PolicyT>::value, Tacc>::type
+    nreduce(
+            PolicyT const & policy,
+            std::tuple<Ndatacontainer...> ndata_tup,
+            Tacc identity,
+            AccFuncT acc_func
+            )
+    {
+        static_assert(
+                    sizeof...(Ndatacontainer) == 1,
+                    "nreduce without combine reduces a single container, pass a combine function"
+                    );
+        static_assert(
+                    std::is_same<
+                        Tacc,
+                        typename std::decay_t<std::tuple_element_t<0, std::tuple<Ndatacontainer...>>>::type_T
+                    >::value,
+                    "nreduce without combine needs an accumulator of the element type, pass a combine function"
+                    );
+
+        return nreduce(
+                    policy,
+                    ndata_tup,
+                    identity,
+                    acc_func,
+                    [acc_func] (Tacc a, Tacc b) {
+                        acc_func(a, b);
+                        return a;
+                    });
+    }
+
+    template <int loop_type = SERIAL, typename Tacc, typename AccFuncT, typename CombineT, typename... Ndatacontainer>
+    Tacc
+    nreduce(std::tuple<Ndatacontainer...> ndata_tup, Tacc identity, AccFuncT acc_func, CombineT combine) {
+        return nreduce(helpers::loop_type_policy<loop_type>(), ndata_tup, identity, acc_func, combine);
+    }
+
+    template <int loop_type = SERIAL, typename Tacc, typename AccFuncT, typename... Ndatacontainer>
+    Tacc
+    nreduce(std::tuple<Ndatacontainer...> ndata_tup, Tacc identity, AccFuncT acc_func) {
+        return nreduce(helpers::loop_type_policy<loop_type>(), ndata_tup, identity, acc_func);
+    }
+
+    namespace helpers {
+
+        /**
+         * @brief Copy of a view of S into a view of T of the same shape, as runs along the innermost
+         *  dimensions. The innermost dimensions contiguous in both views make a single run, copied with
+         *  memcpy (or stream_copy) for a trivially copyable T = S and with convert_run otherwise. Without
+         *  such dimensions there are no runs (contiguous is false), the views are left to nforeach, whose
+         *  loop planner reorders and tiles strided dimensions.
+         */
+        template <typename T, long ndims, typename S = T>
+        struct run_copy {
+
+            T * dst;
+            S const * src;
+
+            //the runs are the elements of the nouter first dimensions
+            long nouter;
+            std::array<long, size_t(ndims)> shape;
+            std::array<long, size_t(ndims)> dst_strides;
+            std::array<long, size_t(ndims)> src_strides;
+
+            long nruns;
+            long run_length;
+            //false if the innermost dimension isn't contiguous in both views, copy must not be called
+            bool contiguous;
+            //non-temporal stores for the contiguous runs, see NDATA_STREAMING_STORE_BYTES
+            bool streaming;
+
+            long
+            size() const {
+                return nruns*run_length;
+            }
+
+            /**
+             * @brief Copies the elements [l_begin, l_end) of the runs [run_begin, run_end).
+             */
+            void
+            copy(long run_begin, long run_end, long l_begin, long l_end) const {
+                if (run_begin >= run_end or l_begin >= l_end) {
+                    return;
+                }
+
+                std::array<long, size_t(ndims)> ndindex {};
+                long dst_offset = 0;
+                long src_offset = 0;
+                long rem = run_begin;
+                for (long i = nouter; i-- > 0; ) {
+                    ndindex[size_t(i)] = rem%shape[size_t(i)];
+                    rem /= shape[size_t(i)];
+                    dst_offset += ndindex[size_t(i)]*dst_strides[size_t(i)];
+                    src_offset += ndindex[size_t(i)]*src_strides[size_t(i)];
+                }
+
+                for (long r = run_begin; r < run_end; ++r) {
+                    copy_run(dst+dst_offset, src+src_offset, l_begin, l_end);
+
+                    for (long i = nouter; i-- > 0; ) {
+                        ++ndindex[size_t(i)];
+                        dst_offset += dst_strides[size_t(i)];
+                        src_offset += src_strides[size_t(i)];
+                        if (ndindex[size_t(i)] < shape[size_t(i)]) {
+                            break;
+                        }
+                        dst_offset -= ndindex[size_t(i)]*dst_strides[size_t(i)];
+                        src_offset -= ndindex[size_t(i)]*src_strides[size_t(i)];
+                        ndindex[size_t(i)] = 0;
+                    }
+                }
+            }
+
+        private:
+
+            void
+            copy_run(T * d, S const * s, long l_begin, long l_end) const {
+                assert(contiguous);
+                copy_contiguous(d+l_begin, s+l_begin, l_end-l_begin);
+            }
+
+            template <typename U = T>
+            typename std::enable_if<std::is_same<U, std::remove_const_t<S>>::value and std::is_trivially_copyable<U>::value>::type
+            copy_contiguous(T * d, S const * s, long n) const {
+                if (streaming) {
+                    stream_copy(d, s, size_t(n)*sizeof(T));
+                } else {
+                    std::memcpy(d, s, size_t(n)*sizeof(T));
+                }
+            }
+
+            template <typename U = T>
+            typename std::enable_if<std::is_same<U, std::remove_const_t<S>>::value and not std::is_trivially_copyable<U>::value>::type
+            copy_contiguous(T * d, S const * s, long n) const {
+                std::copy(s, s+n, d);
+            }
+
+            template <typename U = T>
+            typename std::enable_if<not std::is_same<U, std::remove_const_t<S>>::value>::type
+            copy_contiguous(T * d, S const * s, long n) const {
+                convert_run(d, static_cast<std::remove_const_t<S> const *>(s), n);
+            }
+        };
+
+        template <typename T, long ndims, typename S>
+        run_copy<T, ndims, S>
+        make_run_copy(ndataview<T, ndims> dst, ndataview<S, ndims> src) {
+            static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+
+            run_copy<T, ndims, S> ret;
+            ret.dst = dst.data_+dst.get_start_index();
+            ret.src = src.data_+src.get_start_index();
+            auto shape = src.get_shape();
+            auto dst_strides = dst.get_strides();
+            auto src_strides = src.get_strides();
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                ret.shape[i] = shape[i];
+                ret.dst_strides[i] = dst_strides[i];
+                ret.src_strides[i] = src_strides[i];
+            }
+
+            //innermost dimensions contiguous in both, whatever the strides of those of size 1
+            long k = ndims;
+            long contiguous_size = 1;
+            while (k > 0
+                   and (shape[size_t(k-1)] == 1 or (dst_strides[size_t(k-1)] == contiguous_size and src_strides[size_t(k-1)] == contiguous_size))) {
+                contiguous_size *= shape[size_t(k-1)];
+                --k;
+            }
+
+            //runs of a single element would only add overhead to the strided loop of nforeach
+            ret.contiguous = contiguous_size > 1;
+            ret.streaming = false;
+            ret.nouter = k;
+            ret.run_length = contiguous_size;
+            ret.nruns = 1;
+            for (long i = 0; i < ret.nouter; ++i) {
+                ret.nruns *= shape[size_t(i)];
+            }
+            return ret;
+        }
+
+        template <typename T, long ndims, typename S>
+        void
+        run_copies(serial_policy const &, std::vector<run_copy<T, ndims, S>> const & copies) {
+            for (auto const & c: copies) {
+                c.copy(0, c.nruns, 0, c.run_length);
+            }
+        }
+
+        /**
+         * In parallel, each copy is cut in a number of tasks proportional to its size: groups of runs, or
+         * parts of a single run when it has fewer runs than tasks.
+         */
+        template <typename T, long ndims, typename S>
+        void
+        run_copies(parallel_policy const & policy, std::vector<run_copy<T, ndims, S>> const & copies) {
+            long total = 0;
+            for (auto const & c: copies) {
+                total += c.size();
+            }
+
+            const long nthreads = parallel_num_threads(policy);
+            if (total == 0 or total < policy.min_work or nthreads <= 1) {
+                run_copies(serial_policy(), copies);
+                return;
+            }
+
+            struct copy_task {
+                size_t icopy;
+                long run_begin, run_end, l_begin, l_end;
+            };
+
+            const long ntarget = std::max(1l, (policy.chunk_size > 0)? total/policy.chunk_size : nthreads*REDUCE_BLOCKS_PER_THREAD);
+            std::vector<copy_task> tasks;
+            for (size_t ic = 0; ic < copies.size(); ++ic) {
+                run_copy<T, ndims, S> const & c = copies[ic];
+                if (c.size() == 0) {
+                    continue;
+                }
+                const long ntasks = std::max(1l, ntarget*c.size()/total);
+                if (c.nruns >= ntasks) {
+                    for (long it = 0; it < ntasks; ++it) {
+                        tasks.push_back(copy_task{ic, c.nruns*it/ntasks, c.nruns*(it+1)/ntasks, 0, c.run_length});
+                    }
+                } else {
+                    const long nparts = std::min(c.run_length, (ntasks+c.nruns-1)/c.nruns);
+                    for (long r = 0; r < c.nruns; ++r) {
+                        for (long ip = 0; ip < nparts; ++ip) {
+                            tasks.push_back(copy_task{ic, r, r+1, c.run_length*ip/nparts, c.run_length*(ip+1)/nparts});
+                        }
+                    }
+                }
+            }
+
+            parallel_blocks(policy, nthreads, long(tasks.size()), [&] (long itask_begin, long itask_end) {
+                for (long it = itask_begin; it < itask_end; ++it) {
+                    copy_task const & t = tasks[size_t(it)];
+                    copies[t.icopy].copy(t.run_begin, t.run_end, t.l_begin, t.l_end);
+                }
+            });
+        }
+
+        template <typename PolicyT, typename T, long ndims>
+        void
+        concatenate_views(PolicyT const & policy, std::vector<ndataview<T, ndims>> pieces, size_t axis, ndataview<T, ndims> out) {
+            static_assert(ndims > 0 and ndims != DYNAMICALLY_SIZED, "only for a number of dimensions known at compile time");
+            assert(axis < size_t(ndims));
+
+            auto out_shape = out.get_shape();
+            auto out_strides = out.get_strides();
+            std::vector<run_copy<T, ndims>> copies;
+            std::vector<std::pair<ndataview<T, ndims>, ndataview<T, ndims>>> strided;
+            long offset = 0;
+            for (auto & piece: pieces) {
+                auto shape = piece.get_shape();
+                for (size_t i = 0; i < size_t(ndims); ++i) {
+                    if (i != axis and shape[i] != out_shape[i]) {
+                        throw std::domain_error("concatenate: the shapes must match except along the axis");
+                    }
+                }
+                if (offset+shape[axis] > out_shape[axis]) {
+                    throw std::domain_error("concatenate: the output is too short along the axis");
+                }
+
+                ndataview<T, ndims> region (
+                            indexer<ndims>(out.get_start_index()+size_t(offset*out_strides[axis]), shape, out_strides),
+                            out.data_
+                            );
+                auto c = make_run_copy(region, piece);
+                if (c.contiguous) {
+                    copies.push_back(c);
+                } else {
+                    strided.push_back(std::make_pair(region, piece));
+                }
+                offset += shape[axis];
+            }
+            if (offset != out_shape[axis]) {
+                throw std::domain_error("concatenate: the output is too long along the axis");
+            }
+
+            const bool streaming = out.size()*sizeof(T) >= NDATA_STREAMING_STORE_BYTES;
+            for (auto & c: copies) {
+                c.streaming = streaming;
+            }
+            run_copies(policy, copies);
+            for (auto & regions: strided) {
+                nforeach(policy, std::make_tuple(regions.first, regions.second), [] (T & dst_val, T const & src_val) {
+                    dst_val = src_val;
+                });
+            }
+        }
+
+        /**
+         * @brief true if assign copies S into T as runs (see run_copy): same types, or conversions between
+         *  arithmetic types. bool is left out, nvector<bool, n> sits on std::vector<bool>.
+         */
+        template <typename T, typename S>
+        struct is_run_copyable {
+            static constexpr bool value =
+                    not std::is_same<std::remove_const_t<S>, bool>::value
+                    and not std::is_same<T, bool>::value
+                    and (std::is_same<T, std::remove_const_t<S>>::value
+                         or (std::is_arithmetic<T>::value and std::is_arithmetic<S>::value));
+        };
+
+        template <typename PolicyT, typename ContainerT, typename T, long ndims, typename ContainerT_rhs, typename T_rhs, long ndims_rhs>
+        void
+        assign_elements(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & dst, ndatacontainer<ContainerT_rhs, T_rhs, ndims_rhs> & src, std::false_type) {
+            nforeach(
+                        policy,
+                        std::tie(dst, src),
+                        [] (T& dst_val, T_rhs src_val) {
+                            dst_val = src_val;
+                        }
+                );
+        }
+
+        template <typename PolicyT, typename ContainerT, typename T, long ndims, typename ContainerT_rhs, typename T_rhs>
+        void
+        assign_elements(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims> & dst, ndatacontainer<ContainerT_rhs, T_rhs, ndims> & src, std::true_type) {
+            //the runs are cut from the shape of src, anything but the same shape goes through nforeach
+            auto dst_shape = dst.get_shape();
+            auto src_shape = src.get_shape();
+            for (size_t i = 0; i < size_t(ndims); ++i) {
+                if (dst_shape[i] != src_shape[i]) {
+                    assign_elements(policy, dst, src, std::false_type());
+                    return;
+                }
+            }
+            if (dst.size() == 0) {
+                return;
+            }
+            auto c = make_run_copy(dst.as_view(), src.as_view());
+            if (not c.contiguous) {
+                assign_elements(policy, dst, src, std::false_type());
+                return;
+            }
+            c.streaming = dst.size()*sizeof(T) >= NDATA_STREAMING_STORE_BYTES;
+            run_copies(policy, std::vector<decltype(c)>(1, c));
+        }
+
+        //views of the containers of a tuple, which must have the same element type and dimensions
+        template <typename ... Ndatacontainer, size_t ... Is>
+        auto
+        piece_views(std::tuple<Ndatacontainer&...> pieces, std::index_sequence<Is...>) {
+            typedef decltype(std::get<0>(pieces).as_view()) view_type;
+            return std::vector<view_type>{std::get<Is>(pieces).as_view()...};
+        }
+
+        template <typename ... Ndatacontainer>
+        auto
+        piece_views(std::tuple<Ndatacontainer&...> pieces) {
+            return piece_views(pieces, std::index_sequence_for<Ndatacontainer...>());
+        }
+
+        template <typename T, long ndims>
+        vecarray<long, ndims>
+        concatenated_shape(std::vector<ndataview<T, ndims>> & pieces, size_t axis) {
+            if (pieces.empty()) {
+                throw std::domain_error("concatenate: nothing to concatenate");
+            }
+            auto shape = pieces[0].get_shape();
+            shape[axis] = 0;
+            for (auto & piece: pieces) {
+                shape[axis] += piece.get_shape()[axis];
+            }
+            return shape;
+        }
+
+        //views of the pieces with a new axis of size 1
+        template <typename T, long ndims>
+        std::vector<ndataview<T, ndims+1>>
+        expand_pieces(std::vector<ndataview<T, ndims>> pieces, size_t new_axis) {
+            std::vector<ndataview<T, ndims+1>> ret;
+            for (auto & piece: pieces) {
+                ret.push_back(piece.expand_dims(new_axis));
+            }
+            return ret;
+        }
+
+    }
+
+    /**
+     * @brief Copies the pieces one after the other along axis into out, whose shape along axis must be
+     *  the sum of theirs. The other dimensions must match.
+     *
+     * nvector<float, 2> field (make_indexer(ny, nx_total));
+     * concatenate(parallel_policy(), tiles, 1, field); //tiles: std::vector<ndataview<float, 2>>
+     *
+     * The shapes are checked and the indexers of the regions of out computed once. Each piece is then
+     * copied as runs along the innermost dimensions contiguous in it and in out, with memcpy for a
+     * trivially copyable type. In parallel the runs of all the pieces are split between the threads. The
+     * pieces without such dimensions (transposed, or strided along the innermost one) go through nforeach.
+     * out must not overlap the pieces.
+     */
+    template <typename PolicyT, typename T, long ndims, typename ContainerT_out>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    concatenate(PolicyT const & policy, std::vector<ndataview<T, ndims>> pieces, size_t axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        helpers::concatenate_views(policy, pieces, axis, out.as_view());
+    }
+
+    /**
+     * @brief New nvector with the pieces one after the other along axis, see concatenate(policy, pieces,
+     *  axis, out).
+     */
+    template <typename PolicyT, typename T, long ndims>
+    typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, ndims>>::type
+    concatenate(PolicyT const & policy, std::vector<ndataview<T, ndims>> pieces, size_t axis) {
+        nvector<T, ndims> ret (indexer<ndims>(helpers::concatenated_shape(pieces, axis)), UNINITIALIZED);
+        helpers::concatenate_views(policy, pieces, axis, ret.as_view());
+        return ret;
+    }
+
+    /**
+     * @brief Same as concatenate with the containers of a tuple, like std::tie(a, b, c).
+     */
+    template <typename PolicyT, typename T, long ndims, typename ContainerT_out, typename ... Ndatacontainer>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    concatenate(PolicyT const & policy, std::tuple<Ndatacontainer&...> pieces, size_t axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        concatenate(policy, helpers::piece_views(pieces), axis, out);
+    }
+
+    template <typename PolicyT, typename ... Ndatacontainer>
+    auto
+    concatenate(PolicyT const & policy, std::tuple<Ndatacontainer&...> pieces, size_t axis) {
+        static_assert(is_execution_policy<PolicyT>::value, "");
+        return concatenate(policy, helpers::piece_views(pieces), axis);
+    }
+
+    template <typename ... Ndatacontainer>
+    auto
+    concatenate(std::tuple<Ndatacontainer&...> pieces, size_t axis) {
+        return concatenate(serial_policy(), pieces, axis);
+    }
+
+    template <typename T, long ndims>
+    nvector<T, ndims>
+    concatenate(std::vector<ndataview<T, ndims>> pieces, size_t axis) {
+        return concatenate(serial_policy(), pieces, axis);
+    }
+
+    template <typename T, long ndims, typename ContainerT_out>
+    void
+    concatenate(std::vector<ndataview<T, ndims>> pieces, size_t axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        concatenate(serial_policy(), pieces, axis, out);
+    }
+
+    template <typename T, long ndims, typename ContainerT_out, typename ... Ndatacontainer>
+    void
+    concatenate(std::tuple<Ndatacontainer&...> pieces, size_t axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        concatenate(serial_policy(), pieces, axis, out);
     }
 
+    /**
+     * @brief Copies the pieces, which must all have the same shape, along a new axis of out inserted at
+     *  new_axis (out(i, ...) = piece i for new_axis 0), see concatenate.
+     */
+    template <typename PolicyT, typename T, long ndims, typename ContainerT_out>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    stack(PolicyT const & policy, std::vector<ndataview<T, ndims>> pieces, size_t new_axis, ndatacontainer<ContainerT_out, T, ndims+1> & out) {
+        helpers::concatenate_views(policy, helpers::expand_pieces(pieces, new_axis), new_axis, out.as_view());
+    }
+
+    /**
+     * @brief New nvector with the pieces, which must all have the same shape, along a new axis inserted at
+     *  new_axis.
+     */
+    template <typename PolicyT, typename T, long ndims>
+    typename std::enable_if<is_execution_policy<PolicyT>::value, nvector<T, ndims+1>>::type
+    stack(PolicyT const & policy, std::vector<ndataview<T, ndims>> pieces, size_t new_axis) {
+        auto expanded = helpers::expand_pieces(pieces, new_axis);
+        nvector<T, ndims+1> ret (indexer<ndims+1>(helpers::concatenated_shape(expanded, new_axis)), UNINITIALIZED);
+        helpers::concatenate_views(policy, expanded, new_axis, ret.as_view());
+        return ret;
+    }
+
+    template <typename PolicyT, typename T, long ndims, typename ContainerT_out, typename ... Ndatacontainer>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    stack(PolicyT const & policy, std::tuple<Ndatacontainer&...> pieces, size_t new_axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        stack(policy, helpers::piece_views(pieces), new_axis, out);
+    }
+
+    template <typename PolicyT, typename ... Ndatacontainer>
+    auto
+    stack(PolicyT const & policy, std::tuple<Ndatacontainer&...> pieces, size_t new_axis) {
+        static_assert(is_execution_policy<PolicyT>::value, "");
+        return stack(policy, helpers::piece_views(pieces), new_axis);
+    }
 
+    template <typename ... Ndatacontainer>
+    auto
+    stack(std::tuple<Ndatacontainer&...> pieces, size_t new_axis) {
+        return stack(serial_policy(), pieces, new_axis);
+    }
+
+    template <typename T, long ndims>
+    nvector<T, ndims+1>
+    stack(std::vector<ndataview<T, ndims>> pieces, size_t new_axis) {
+        return stack(serial_policy(), pieces, new_axis);
+    }
+
+    template <typename T, long ndims, typename ContainerT_out>
+    void
+    stack(std::vector<ndataview<T, ndims>> pieces, size_t new_axis, ndatacontainer<ContainerT_out, T, ndims+1> & out) {
+        stack(serial_policy(), pieces, new_axis, out);
+    }
 
-    //TODO concatenate
+    template <typename T, long ndims, typename ContainerT_out, typename ... Ndatacontainer>
+    void
+    stack(std::tuple<Ndatacontainer&...> pieces, size_t new_axis, ndatacontainer<ContainerT_out, T, ndims> & out) {
+        stack(serial_policy(), pieces, new_axis, out);
+    }
 
 }
 
@@ -3,6 +3,7 @@
 #define NDVIEW_HPP_1LWJBSCE
 
 #include <functional>
+#include <vector>
 
 #include "vecarray.hpp"
 #include "ndata.hpp"
@@ -83,6 +84,54 @@ struct ndatacontainer: indexer<ndims> {
         );
     }
 
+    /**
+     * @brief Returns a view with the axes reordered, axis i of the view being axis axes[i] of the
+     *  container. No data is copied.
+     * @copydoc indexer::permute_axes_indexer(vecarray<size_t, ndims>)
+     */
+    ndataview<T, ndims>
+    permute_axes(vecarray<size_t, ndims> axes) {
+        return ndataview<T, ndims>(this->permute_axes_indexer(axes), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view with the axes in reverse order, without copying the data.
+     */
+    ndataview<T, ndims>
+    transpose() {
+        return ndataview<T, ndims>(this->transpose_indexer(), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view with the axes axis1 and axis2 exchanged, without copying the data.
+     */
+    ndataview<T, ndims>
+    swapaxes(size_t axis1, size_t axis2) {
+        return ndataview<T, ndims>(this->swapaxes_indexer(axis1, axis2), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view on all the windows of shape window_shape over the axes axes, without copying.
+     *  The window dimensions are appended after the existing ones, so that for a 2D u and a window
+     *  over both axes, w = u.sliding_window_view(...) gives w(i, j, k, l) == u(i+k, j+l).
+     *
+     * Windows overlap, the view is meant to be read from (e.g. as an input of nforeach).
+     * @copydoc indexer::sliding_window_indexer(vecarray<long, nwin>, vecarray<size_t, nwin>)
+     */
+    template <long nwin>
+    ndataview<T, ndims+nwin>
+    sliding_window_view(vecarray<long, nwin> window_shape, vecarray<size_t, nwin> axes) {
+        return ndataview<T, ndims+nwin>(this->sliding_window_indexer(window_shape, axes), &data_[0]);
+    }
+
+    /**
+     * @brief Same as sliding_window_view(window_shape, axes) with a window along every axis.
+     */
+    ndataview<T, 2*ndims>
+    sliding_window_view(vecarray<long, ndims> window_shape) {
+        return ndataview<T, 2*ndims>(this->sliding_window_indexer(window_shape), &data_[0]);
+    }
+
     /**
      * @brief Gives a view on a slice of the ndata. Alternative version, with vecarrays instead of variadic arguments.
      * @return ndataview
@@ -125,36 +174,68 @@ struct ndatacontainer: indexer<ndims> {
     /**
      * @brief elementwise copy of the values of rhs to the internal data. Doesn't perform broadcasting,
      * use assign_transform if you want to benefit from broadcasting
+     *
+     * The innermost dimensions contiguous in both containers are copied as runs: memcpy for the same type
+     * (with non-temporal stores for destinations of at least NDATA_STREAMING_STORE_BYTES) and SIMD
+     * conversions between arithmetic types, see helpers::run_copy. Without such dimensions (e.g. from a
+     * transposed view) the copy runs in an nforeach loop, reordered and tiled by the loop planner.
+     * So does a rhs of a different shape, which is broadcasted or throws std::domain_error like nforeach.
      */
+    template <typename PolicyT, typename ContainerT_rhs, typename T_rhs, long ndims_rhs>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    assign(PolicyT const & policy, ndatacontainer<ContainerT_rhs, T_rhs, ndims_rhs> const & rhs) {
+        static_assert(ndims_rhs == ndims or ndims_rhs == DYNAMICALLY_SIZED, "");
+
+        //rhs is only read from
+        ndataview<T_rhs const, ndims_rhs> rhs_view (rhs, &rhs.data_[0]);
+
+        helpers::assign_elements(
+                    policy,
+                    *this,
+                    rhs_view,
+                    std::integral_constant<bool, (ndims_rhs == ndims and ndims > 0 and helpers::is_run_copyable<T, T_rhs>::value)>()
+                    );
+    }
+
     template <int loop_type = SERIAL, typename ContainerT_rhs, typename T_rhs, long ndims_rhs>
     void
-    assign(ndatacontainer<ContainerT_rhs, T_rhs, ndims_rhs> rhs) {
-        static_assert(ndims_rhs == ndims or ndims_rhs == DYNAMICALLY_SIZED, "");
+    assign(ndatacontainer<ContainerT_rhs, T_rhs, ndims_rhs> const & rhs) {
+        assign(helpers::loop_type_policy<loop_type>(), rhs);
+    }
 
-        for (size_t i = 0; i < this->get_shape().size(); ++i) {
-            assert(rhs.get_shape()[i] == this->get_shape()[i]);
-        }
+    /**
+     * @brief Computes the lazy expression expr (see nexpr) into the internal data, in a single loop.
+     *  expr is broadcasted to the shape of this container.
+     */
+    template <typename PolicyT, typename FuncT, typename LeavesT>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    assign(PolicyT const & policy, nexpr<FuncT, LeavesT> const & expr) {
+        expr.assign_to(policy, *this);
+    }
 
-        nforeach<loop_type>(
-                    std::tie(*this, rhs),
-                    [] (T& this_val, T_rhs rhs_val) {
-                        this_val = rhs_val;
-                    }
-            );
+    /**
+     * @brief Same as assign(serial_policy(), expr)
+     */
+    template <typename FuncT, typename LeavesT>
+    ndatacontainer &
+    operator=(nexpr<FuncT, LeavesT> const & expr) {
+        expr.assign_to(serial_policy(), *this);
+        return *this;
     }
 
     /**
      * @brief equivalent to calling .assign(ntransform(...)) but skips the extra temporary
      */
-    template <int loop_type = SERIAL, typename... Ndatacontainer, typename FuncT>
-    void
-    assign_transform(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+    template <typename PolicyT, typename... Ndatacontainer, typename FuncT>
+    typename std::enable_if<is_execution_policy<PolicyT>::value>::type
+    assign_transform(PolicyT const & policy, std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
 
         //static_assert(ndims_rhs == ndims or ndims_rhs == DYNAMICALLY_SIZED, "");
 
         auto ndata_tuple_bcviews = helpers::broadcast_views(ndata_tup);
 
-        nforeach_base<loop_type>(
+        nforeach_base(
+                    policy,
                     std::tuple_cat(
                         std::make_tuple(this->as_view()),
                         ndata_tuple_bcviews
@@ -165,6 +246,12 @@ struct ndatacontainer: indexer<ndims> {
             );
     }
 
+    template <int loop_type = SERIAL, typename... Ndatacontainer, typename FuncT>
+    void
+    assign_transform(std::tuple<Ndatacontainer...> ndata_tup, FuncT func)  {
+        assign_transform(helpers::loop_type_policy<loop_type>(), ndata_tup, func);
+    }
+
     /**
      * @brief Same as assign_transform but defaults to parallel execution. Provided for convenience.
      */
@@ -181,6 +268,13 @@ struct ndatacontainer: indexer<ndims> {
         return ndataview<T, ndims>(*this, &data_[0]);
     }
 
+    /**
+     * @brief Read-only view, for the functions which only read from their input
+     */
+    auto as_view() const {
+        return ndataview<T const, ndims>(*this, &data_[0]);
+    }
+
     /**
      * @brief Mostly useful to explicitly pass an indexer to a function taking either an indexer
      *  or an ndatacontainer.
@@ -191,7 +285,69 @@ struct ndatacontainer: indexer<ndims> {
         return *this;
     }
 
-    //TODO reshape overload like numpy
+    /**
+     * @brief Returns a view of shape new_shape on the same elements, taken in C order like numpy.reshape,
+     *  without copying the data. One axis of new_shape may be -1 and is then inferred.
+     *
+     * Throws std::domain_error if the strides don't allow it without a copy (e.g. merging the two axes of
+     * a transposed view), use the overload with a copy buffer to fall back on a copy.
+     * @copydoc indexer::reshape_indexer(vecarray<long, new_ndims>)
+     */
+    template<long new_ndims>
+    ndataview<T, new_ndims>
+    reshape(vecarray<long, new_ndims> new_shape) {
+        return ndataview<T, new_ndims>(this->reshape_indexer(new_shape), &data_[0]);
+    }
+
+    /**
+     * @brief Same as reshape(new_shape) when the strides allow a view. Otherwise the elements are copied
+     *  in C order into copy_buffer (resized as needed) and the returned view is on copy_buffer, which must
+     *  outlive it.
+     */
+    template<long new_ndims>
+    ndataview<T, new_ndims>
+    reshape(vecarray<long, new_ndims> new_shape, std::vector<T> & copy_buffer) {
+        if (this->can_reshape_view(new_shape)) {
+            return reshape(new_shape);
+        }
+
+        copy_buffer.resize(this->size());
+        ndataview<T, ndims> contiguous (indexer<ndims>(this->shape_), copy_buffer.data());
+        contiguous.assign(*this);
+        return contiguous.reshape(new_shape);
+    }
+
+    /**
+     * @brief Returns a view without the axis axis, which must have a size of 1.
+     */
+    ndataview<T, ndims-1>
+    squeeze(size_t axis) {
+        return ndataview<T, ndims-1>(this->squeeze_indexer(axis), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view with a new axis of size 1 inserted before axis axis.
+     */
+    ndataview<T, ndims+1>
+    expand_dims(size_t axis) {
+        return ndataview<T, ndims+1>(this->expand_dims_indexer(axis), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view with the elements in reverse order along axis, without copying the data.
+     */
+    ndataview<T, ndims>
+    flip(size_t axis) {
+        return ndataview<T, ndims>(this->flip_indexer(axis), &data_[0]);
+    }
+
+    /**
+     * @brief Returns a view with the elements in reverse order along every axis.
+     */
+    ndataview<T, ndims>
+    flip() {
+        return ndataview<T, ndims>(this->flip_indexer(), &data_[0]);
+    }
 
     /**
      * Reshape with new shape and new strides (mostly used for broadcasting)
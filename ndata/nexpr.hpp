@@ -0,0 +1,293 @@
+/*! \file Contains lazy elementwise arithmetic expressions on ndatacontainers */
+#ifndef NEXPR_HPP_QD3VX8KA
+#define NEXPR_HPP_QD3VX8KA
+
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ndata.hpp"
+
+namespace ndata {
+
+/**
+ * @brief A lazy elementwise expression: func_ applied to the matching elements of the leaves after
+ *  broadcasting.
+ *
+ * Expressions are built by the arithmetic operators on ndatacontainers, scalars and other expressions.
+ * Nothing is computed until the expression is assigned to a container or evaluated with eval(), which
+ * runs a single loop over all the leaves without any temporary array:
+ *
+ * nvector<float, 2> w = a*b + 2.f*c; //one pass over a, b, c and w
+ * w = w - a/b;                       //in place, one pass
+ * auto v = (a*b + c).eval(parallel_policy());
+ *
+ * The leaves are views: like the views returned by slice, an expression must not outlive the containers
+ * it refers to, so don't keep expressions on temporaries in auto variables. As with numpy in place
+ * operations, assigning to a container that is also read through a shifted or broadcasted view of
+ * itself gives unspecified results.
+ */
+template <typename FuncT, typename LeavesT>
+struct nexpr;
+
+template <typename FuncT, typename ... Ts, long ... ndims>
+struct nexpr<FuncT, std::tuple<ndataview<Ts, ndims>...>> {
+
+    //function of the values of all the leaves
+    FuncT func_;
+
+    std::tuple<ndataview<Ts, ndims>...> leaves_;
+
+    //type of the elements of the expression
+    typedef typename std::decay<decltype(std::declval<FuncT const &>()(std::declval<Ts const &>()...))>::type type_T;
+
+    static constexpr size_t NLEAVES = sizeof...(Ts);
+
+    /**
+     * @brief Indexer with the broadcasted shape of the expression.
+     */
+    auto
+    shape_indexer() const {
+        static_assert(sizeof...(Ts) > 0, "");
+        auto leaves_bc = helpers::broadcast(leaves_);
+        auto shape = std::get<0>(leaves_bc).get_shape();
+        return indexer<shape.STATIC_SIZE_OR_DYNAMIC>(shape);
+    }
+
+    /**
+     * @brief Computes the expression into a new nvector.
+     */
+    template <typename PolicyT = serial_policy>
+    auto
+    eval(PolicyT const & policy = PolicyT()) const {
+        auto idxr = shape_indexer();
+        nvector<type_T, decltype(idxr.get_shape())::STATIC_SIZE_OR_DYNAMIC> ret (idxr, UNINITIALIZED);
+        assign_to(policy, ret);
+        return ret;
+    }
+
+    /**
+     * @brief Computes the expression into out, which must have the broadcasted shape of the expression
+     *  (the expression is broadcasted on out, not the other way around).
+     */
+    template <typename PolicyT, typename ContainerT, typename T, long ndims_out>
+    void
+    assign_to(PolicyT const & policy, ndatacontainer<ContainerT, T, ndims_out> & out) const {
+        static_assert(is_execution_policy<PolicyT>::value, "");
+
+        auto views_bc = helpers::broadcast(std::tuple_cat(std::make_tuple(out.as_view()), leaves_));
+
+        helpers::check_output_shape(out.get_shape(), std::get<0>(views_bc).get_shape());
+
+        auto func = func_;
+        nforeach_base(
+                    policy,
+                    views_bc,
+                    [func] (T & out_val, auto const & ... leaf_vals) {
+                        out_val = func(leaf_vals...);
+                    });
+    }
+};
+
+namespace helpers {
+
+    template <typename T>
+    struct is_nexpr: std::false_type { };
+
+    template <typename FuncT, typename LeavesT>
+    struct is_nexpr<nexpr<FuncT, LeavesT>>: std::true_type { };
+
+    /**
+     * @brief true if the arithmetic operators build an expression from these operands: containers,
+     *  expressions or arithmetic scalars, at least one of them not being a scalar.
+     */
+    template <typename ... OperandTs>
+    struct is_nexpr_operands {
+        static constexpr bool value = false;
+    };
+
+    template <typename T>
+    struct is_nexpr_operands<T> {
+        static constexpr bool value = is_ndatacontainer<T>::value or is_nexpr<typename std::decay<T>::type>::value;
+    };
+
+    template <typename L, typename R>
+    struct is_nexpr_operands<L, R> {
+        static constexpr bool value =
+                (is_nexpr_operands<L>::value and (is_nexpr_operands<R>::value or std::is_arithmetic<R>::value))
+                or (std::is_arithmetic<L>::value and is_nexpr_operands<R>::value);
+    };
+
+    struct nexpr_leaf {
+        template <typename T>
+        T
+        operator()(T const & val) const {
+            return val;
+        }
+    };
+
+    template <typename S>
+    struct nexpr_scalar {
+        S val;
+
+        S
+        operator()() const {
+            return val;
+        }
+    };
+
+    template <typename OpT, typename FuncT>
+    struct nexpr_unary {
+        OpT op;
+        FuncT func;
+
+        template <typename ... Vals>
+        auto
+        operator()(Vals const & ... vals) const {
+            return op(func(vals...));
+        }
+    };
+
+    /**
+     * Applies op to the values of the left and right subexpressions, the values of the leaves of the
+     * left one come first.
+     */
+    template <typename OpT, typename FuncLT, typename FuncRT, size_t nleft, size_t nright>
+    struct nexpr_binary {
+        OpT op;
+        FuncLT left;
+        FuncRT right;
+
+        template <typename ... Vals>
+        auto
+        operator()(Vals const & ... vals) const {
+            auto args = std::forward_as_tuple(vals...);
+            return op(
+                        call_with_args_slice<0>(left, args, std::make_index_sequence<nleft>()),
+                        call_with_args_slice<nleft>(right, args, std::make_index_sequence<nright>())
+                        );
+        }
+    };
+
+    struct nexpr_plus {
+        template <typename A, typename B>
+        auto operator()(A const & a, B const & b) const {return a+b;}
+    };
+
+    struct nexpr_minus {
+        template <typename A, typename B>
+        auto operator()(A const & a, B const & b) const {return a-b;}
+    };
+
+    struct nexpr_multiplies {
+        template <typename A, typename B>
+        auto operator()(A const & a, B const & b) const {return a*b;}
+    };
+
+    struct nexpr_divides {
+        template <typename A, typename B>
+        auto operator()(A const & a, B const & b) const {return a/b;}
+    };
+
+    struct nexpr_negate {
+        template <typename A>
+        auto operator()(A const & a) const {return -a;}
+    };
+
+    /**
+     * @brief Leaf reading the elements of a container. Expressions only read their leaves, hence the const_cast
+     *  to build the view.
+     */
+    template <typename ContainerT, typename T, long ndims>
+    nexpr<nexpr_leaf, std::tuple<ndataview<T, ndims>>>
+    to_nexpr(ndatacontainer<ContainerT, T, ndims> const & container) {
+        indexer<ndims> idxr = container;
+        return {nexpr_leaf(), std::make_tuple(ndataview<T, ndims>(idxr, const_cast<T*>(&container.data_[0])))};
+    }
+
+    template <typename FuncT, typename LeavesT>
+    nexpr<FuncT, LeavesT>
+    to_nexpr(nexpr<FuncT, LeavesT> const & expr) {
+        return expr;
+    }
+
+    //scalars are stored in the expression, not as broadcasted leaves
+    template <typename S, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type>
+    nexpr<nexpr_scalar<S>, std::tuple<>>
+    to_nexpr(S val) {
+        return {nexpr_scalar<S> {val}, std::tuple<>()};
+    }
+
+    template <typename OpT, typename FuncT, typename ... Ls>
+    nexpr<nexpr_unary<OpT, FuncT>, std::tuple<Ls...>>
+    make_unary_nexpr(OpT op, nexpr<FuncT, std::tuple<Ls...>> const & expr) {
+        return {nexpr_unary<OpT, FuncT> {op, expr.func_}, expr.leaves_};
+    }
+
+    template <typename OpT, typename FuncLT, typename ... Ls, typename FuncRT, typename ... Rs>
+    nexpr<nexpr_binary<OpT, FuncLT, FuncRT, sizeof...(Ls), sizeof...(Rs)>, std::tuple<Ls..., Rs...>>
+    make_binary_nexpr(
+            OpT op,
+            nexpr<FuncLT, std::tuple<Ls...>> const & left,
+            nexpr<FuncRT, std::tuple<Rs...>> const & right
+            )
+    {
+        return {
+            nexpr_binary<OpT, FuncLT, FuncRT, sizeof...(Ls), sizeof...(Rs)> {op, left.func_, right.func_},
+            std::tuple_cat(left.leaves_, right.leaves_)
+        };
+    }
+
+} //end namespace helpers
+
+template <typename L, typename R, typename = typename std::enable_if<helpers::is_nexpr_operands<L, R>::value>::type>
+auto
+operator+(L const & l, R const & r) {
+    return helpers::make_binary_nexpr(helpers::nexpr_plus(), helpers::to_nexpr(l), helpers::to_nexpr(r));
+}
+
+template <typename L, typename R, typename = typename std::enable_if<helpers::is_nexpr_operands<L, R>::value>::type>
+auto
+operator-(L const & l, R const & r) {
+    return helpers::make_binary_nexpr(helpers::nexpr_minus(), helpers::to_nexpr(l), helpers::to_nexpr(r));
+}
+
+template <typename L, typename R, typename = typename std::enable_if<helpers::is_nexpr_operands<L, R>::value>::type>
+auto
+operator*(L const & l, R const & r) {
+    return helpers::make_binary_nexpr(helpers::nexpr_multiplies(), helpers::to_nexpr(l), helpers::to_nexpr(r));
+}
+
+template <typename L, typename R, typename = typename std::enable_if<helpers::is_nexpr_operands<L, R>::value>::type>
+auto
+operator/(L const & l, R const & r) {
+    return helpers::make_binary_nexpr(helpers::nexpr_divides(), helpers::to_nexpr(l), helpers::to_nexpr(r));
+}
+
+template <typename U, typename = typename std::enable_if<helpers::is_nexpr_operands<U>::value>::type>
+auto
+operator-(U const & u) {
+    return helpers::make_unary_nexpr(helpers::nexpr_negate(), helpers::to_nexpr(u));
+}
+
+/**
+ * @brief Applies func elementwise to the operands (containers, expressions or scalars), lazily.
+ *
+ * nvector<float, 1> r = nmap([] (float x, float y) {return std::max(x, y);}, u, 0.5f*v);
+ */
+template <typename FuncT, typename U>
+auto
+nmap(FuncT func, U const & u) {
+    return helpers::make_unary_nexpr(func, helpers::to_nexpr(u));
+}
+
+template <typename FuncT, typename L, typename R>
+auto
+nmap(FuncT func, L const & l, R const & r) {
+    return helpers::make_binary_nexpr(func, helpers::to_nexpr(l), helpers::to_nexpr(r));
+}
+
+} //end namespace ndata
+
+#endif /* end of include guard: NEXPR_HPP_QD3VX8KA */
@@ -7,9 +7,6 @@
 
 namespace ndata {
 
-struct UNINITIALIZED_T { };
-constexpr UNINITIALIZED_T UNINITIALIZED = UNINITIALIZED_T();
-
 //constexpr enum ValueInitialization UNINITIALIZED = ValueInitialization::UNINITIALIZED;
 
 //forward declaration
@@ -40,9 +37,27 @@ struct nvector: ndatacontainer<std::vector<T>, T, ndims>  {
         ndatacontainer<std::vector<T>, T, ndims>(idxr.get_shape(), std::vector<T>(idxr.size(), initial_value))
     { }
 
+    /**
+     * @brief construct with the shape of idxr and the data laid out in fortran (column major) order,
+     *  for instance to hand it over to a fortran routine.
+     * @param idxr
+     * @param FORTRAN_ORDER The only valid value for this parameter is the ndata::FORTRAN_ORDER constant
+     * @param initial_value
+     */
+    nvector(
+            indexer<ndims> idxr,
+            FORTRAN_ORDER_T,
+            T initial_value = T()
+            ):
+        ndatacontainer<std::vector<T>, T, ndims>(
+            indexer<ndims>(idxr.get_shape(), FORTRAN_ORDER),
+            std::vector<T>(idxr.size(), initial_value)
+            )
+    { }
+
     /**
      * @brief construct from an indexer and leave data uninitialized (note: for now the internal std::vector will
-     *  default initialize the internal data anyway). The extra UNINITIALIZED_T parameter is here mostly to disambiguate
+     *  value initialize the internal data anyway, which costs the same write pass as nvector(idxr)). The extra UNINITIALIZED_T parameter is here mostly to disambiguate
      *  from the other constructor taking an ndatacontainer (which is implicitly convertible to an indexer due to inheritance).
      * @param idxr An indexer instance
      * @param UNINITIALIZED The only valid value for this parameter is the ndata::UNINITIALIZED constant
@@ -97,9 +112,23 @@ struct nvector: ndatacontainer<std::vector<T>, T, ndims>  {
             )
     { }
 
+    /**
+     * @brief construct from a lazy expression (see nexpr), with its broadcasted shape
+     */
+    template <typename FuncT, typename LeavesT>
+    nvector(
+            nexpr<FuncT, LeavesT> const & expr
+            ):
+        nvector(expr.shape_indexer(), UNINITIALIZED)
+    {
+        expr.assign_to(serial_policy(), *this);
+    }
+
     //empty constructor for later assignment
     nvector(){};
 
+    using ndatacontainer<std::vector<T>, T, ndims>::operator=;
+
 };
 
 
@@ -0,0 +1,377 @@
+/*! \file Contains a work stealing thread pool used as a parallel loop backend when OpenMP is unavailable */
+#ifndef THREAD_POOL_HPP_R8XK2PQM
+#define THREAD_POOL_HPP_R8XK2PQM
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#if defined(__linux__)
+   #include <pthread.h>
+   #include <sched.h>
+#endif
+
+namespace ndata {
+
+/**
+ * @brief A pool of persistent worker threads running parallel loops with work stealing.
+ *
+ * parallel_for(n, grain, func) calls func(begin, end) on subranges of [0, n) and blocks until all
+ * of them have been processed. The range is first split evenly between the participants (the workers
+ * and the calling thread). Each participant then recursively halves its ranges down to the grain size,
+ * processes the lower halves and leaves the upper halves in its queue, where idle participants can
+ * steal them. Stealing takes the oldest, hence biggest, ranges.
+ *
+ * Calling parallel_for from inside a loop body running on the pool (nested parallelism) runs
+ * the nested loop serially on the current thread instead of deadlocking. Concurrent calls from
+ * unrelated threads are serialized.
+ *
+ * A loop can be restricted to the first max_threads participants, the other workers keep sleeping.
+ */
+class thread_pool {
+
+public:
+
+    /**
+     * @param nthreads Total number of threads taking part in the loops, including the calling thread.
+     *  0 means std::thread::hardware_concurrency().
+     * @param default_grain Default minimum number of iterations run by a task.
+     */
+    explicit
+    thread_pool(size_t nthreads = 0, long default_grain = 1):
+        queues_(std::max<size_t>(1, (nthreads == 0)? std::thread::hardware_concurrency() : nthreads)),
+        default_grain_(std::max(1l, default_grain))
+    {
+        for (size_t i = 1; i < queues_.size(); ++i) {
+            workers_.push_back(std::thread([this, i] () { worker_loop(i); }));
+        }
+    }
+
+    thread_pool(thread_pool const &) = delete;
+    thread_pool & operator=(thread_pool const &) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock (state_mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (auto & w: workers_) {
+            w.join();
+        }
+    }
+
+    /**
+     * @brief Number of threads taking part in the loops, including the calling thread.
+     */
+    size_t size() const {
+        return queues_.size();
+    }
+
+    long default_grain() const {
+        return default_grain_;
+    }
+
+    void set_default_grain(long grain) {
+        default_grain_ = std::max(1l, grain);
+    }
+
+    /**
+     * @brief true when called from a thread currently running a loop body of this pool.
+     */
+    bool in_pool() const {
+        return current_pool() == this;
+    }
+
+    /**
+     * @brief Pins each worker thread to one of the cores the process is allowed to run on
+     *  (round robin). Only the first call has an effect. Does nothing on platforms other than linux.
+     *  The calling threads of parallel_for are never pinned.
+     */
+    void
+    bind_threads() {
+        std::call_once(bind_flag_, [this] () {
+#if defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+                return;
+            }
+
+            std::vector<int> cpus;
+            for (int icpu = 0; icpu < CPU_SETSIZE; ++icpu) {
+                if (CPU_ISSET(icpu, &allowed)) {
+                    cpus.push_back(icpu);
+                }
+            }
+            if (cpus.empty()) {
+                return;
+            }
+
+            //the calling thread is participant 0, the workers take the next cores
+            for (size_t iw = 0; iw < workers_.size(); ++iw) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[(iw+1)%cpus.size()], &set);
+                //best effort, a failure leaves the thread unpinned
+                (void) pthread_setaffinity_np(workers_[iw].native_handle(), sizeof(set), &set);
+            }
+#endif
+        });
+    }
+
+    /**
+     * @brief Calls func(begin, end) on subranges of [0, n) of at least grain iterations
+     *  (except when n itself is smaller) and blocks until completion. Exceptions thrown by func are
+     *  rethrown (the first one) once all the participants are done.
+     *
+     * @param max_threads maximum number of participants including the calling thread, 0 means size()
+     */
+    template <typename FuncT>
+    void
+    parallel_for(long n, long grain, FuncT func, size_t max_threads = 0) {
+        if (n <= 0) {
+            return;
+        }
+        grain = std::max(1l, grain);
+
+        size_t nparts = (max_threads == 0)? size() : std::min(max_threads, size());
+
+        if (in_pool() or nparts == 1 or n <= grain) {
+            func(0l, n);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit_lock (submit_mutex_);
+
+        job j;
+        j.body = &invoke<FuncT>;
+        j.ctx = &func;
+        j.grain = grain;
+        j.nparts = nparts;
+        j.remaining.store(n);
+
+        //initial even split, one contiguous range per participant
+        for (size_t i = 0; i < nparts; ++i) {
+            long b = n*long(i)/long(nparts);
+            long e = n*long(i+1)/long(nparts);
+            if (b < e) {
+                std::lock_guard<std::mutex> lock (queues_[i].mutex);
+                queues_[i].ranges.push_back(task_range {b, e});
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock (state_mutex_);
+            current_job_ = &j;
+            ++generation_;
+        }
+        wake_cv_.notify_all();
+
+        participate(j, 0);
+
+        //wait for the workers to leave the job before it goes out of scope
+        {
+            std::unique_lock<std::mutex> lock (state_mutex_);
+            current_job_ = nullptr;
+            done_cv_.wait(lock, [&j] () {return j.active == 0;});
+        }
+
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+    /**
+     * @brief Same as parallel_for(n, default_grain(), func)
+     */
+    template <typename FuncT>
+    void
+    parallel_for(long n, FuncT func) {
+        parallel_for(n, default_grain(), func);
+    }
+
+    /**
+     * @brief Pool shared by the parallel loops of ndata. Its size is taken from the NDATA_NUM_THREADS
+     *  environment variable if set, otherwise from std::thread::hardware_concurrency().
+     *  The default grain is the minimum number of elements processed by a task of a parallel nforeach.
+     */
+    static
+    thread_pool &
+    global() {
+        static thread_pool pool (default_num_threads(), GLOBAL_DEFAULT_GRAIN);
+        return pool;
+    }
+
+    static constexpr long GLOBAL_DEFAULT_GRAIN = 4096;
+
+    static
+    size_t
+    default_num_threads() {
+        const char * env = std::getenv("NDATA_NUM_THREADS");
+        if (env != nullptr) {
+            long n = std::atol(env);
+            if (n > 0) {
+                return size_t(n);
+            }
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+private:
+
+    struct task_range {
+        long begin;
+        long end;
+    };
+
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task_range> ranges;
+    };
+
+    struct job {
+        void (*body) (void *, long, long);
+        void * ctx;
+        long grain;
+        size_t nparts;
+        std::atomic<long> remaining;
+        //protected by state_mutex_
+        long active = 0;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    template <typename FuncT>
+    static
+    void
+    invoke(void * ctx, long begin, long end) {
+        (*static_cast<FuncT*>(ctx))(begin, end);
+    }
+
+    static
+    thread_pool * &
+    current_pool() {
+        static thread_local thread_pool * pool = nullptr;
+        return pool;
+    }
+
+    bool
+    pop_local(size_t iq, task_range & r) {
+        std::lock_guard<std::mutex> lock (queues_[iq].mutex);
+        if (queues_[iq].ranges.empty()) {
+            return false;
+        }
+        r = queues_[iq].ranges.back();
+        queues_[iq].ranges.pop_back();
+        return true;
+    }
+
+    bool
+    steal(job const & j, size_t iq, task_range & r) {
+        for (size_t k = 1; k < j.nparts; ++k) {
+            size_t victim = (iq+k)%j.nparts;
+            std::lock_guard<std::mutex> lock (queues_[victim].mutex);
+            if (not queues_[victim].ranges.empty()) {
+                r = queues_[victim].ranges.front();
+                queues_[victim].ranges.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void
+    process(job & j, size_t iq, task_range r) {
+        //keep the upper halves for later (or for thieves)
+        while (r.end-r.begin > j.grain) {
+            long mid = r.begin+(r.end-r.begin)/2;
+            {
+                std::lock_guard<std::mutex> lock (queues_[iq].mutex);
+                queues_[iq].ranges.push_back(task_range {mid, r.end});
+            }
+            r.end = mid;
+        }
+
+        try {
+            j.body(j.ctx, r.begin, r.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock (j.error_mutex);
+            if (not j.error) {
+                j.error = std::current_exception();
+            }
+        }
+
+        j.remaining.fetch_sub(r.end-r.begin);
+    }
+
+    void
+    participate(job & j, size_t iq) {
+        thread_pool * previous = current_pool();
+        current_pool() = this;
+
+        task_range r;
+        while (j.remaining.load() > 0) {
+            if (pop_local(iq, r) or steal(j, iq, r)) {
+                process(j, iq, r);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        current_pool() = previous;
+    }
+
+    void
+    worker_loop(size_t iq) {
+        unsigned long seen_generation = 0;
+        for (;;) {
+            job * j = nullptr;
+            {
+                std::unique_lock<std::mutex> lock (state_mutex_);
+                wake_cv_.wait(lock, [&] () {return stop_ or generation_ != seen_generation;});
+                if (stop_) {
+                    return;
+                }
+                seen_generation = generation_;
+                j = current_job_;
+                if (j == nullptr or iq >= j->nparts) {
+                    continue;
+                }
+                ++j->active;
+            }
+
+            participate(*j, iq);
+
+            {
+                std::lock_guard<std::mutex> lock (state_mutex_);
+                --j->active;
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    std::vector<worker_queue> queues_;
+    std::vector<std::thread> workers_;
+    long default_grain_;
+    std::once_flag bind_flag_;
+
+    std::mutex submit_mutex_;
+
+    std::mutex state_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    job * current_job_ = nullptr;
+    unsigned long generation_ = 0;
+    bool stop_ = false;
+};
+
+} //end namespace ndata
+
+#endif /* end of include guard: THREAD_POOL_HPP_R8XK2PQM */
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <initializer_list>
 #include <exception>
+#include <stdexcept>
 
 #include <type_traits>
 
@@ -102,7 +103,7 @@ struct vecarray<T, static_size, typename std::enable_if<(static_size >= 0)>::typ
     //empty dataializer for later assignment
     vecarray() {};
 
-    size_t size() {
+    size_t size() const {
         return static_size;
     }
 
@@ -116,6 +117,11 @@ struct vecarray<T, static_size, typename std::enable_if<(static_size >= 0)>::typ
         return stack_storage[index];
     }
 
+    T const & operator[](size_t index) const {
+        assert(index<size());
+        return stack_storage[index];
+    }
+
     void fill(T val) {
         for (size_t i = 0; i < size(); ++i) {
             this->operator[](i) = val;
@@ -260,7 +266,7 @@ struct vecarray<T, static_size, typename std::enable_if<(static_size == DYNAMICA
     //empty initializer for later assignment
     vecarray() {};
 
-    size_t size() {
+    size_t size() const {
         return heap_storage.size();
     }
 
@@ -271,6 +277,11 @@ struct vecarray<T, static_size, typename std::enable_if<(static_size == DYNAMICA
         return heap_storage[index];
     }
 
+    T const & operator[](size_t index) const {
+        assert(index<size());
+        return heap_storage[index];
+    }
+
     void fill(T val) {
         for (size_t i = 0; i < size(); ++i) {
             this[i] = val;
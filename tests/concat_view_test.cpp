@@ -0,0 +1,160 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/concat_view.hpp"
+
+#include "tests/test_helpers.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+using namespace ndata::test_helpers;
+
+struct TestSuite {
+
+    static
+    test_result
+    element_access() {
+        DECLARE_TEST(success, msg);
+
+        auto a = make_cycling_input(3, 10, 0.);
+        auto b = make_cycling_input(5, 10, 100.);
+        auto c = make_cycling_input(2, 10, 200.);
+        auto flipped = b.flip();
+
+        auto cv = make_concat_view(std::tie(a, flipped, c), 0);
+        auto ref = concatenate(std::tie(a, flipped, c), 0);
+        bool ok = cv.get_shape()[0] == 10 and cv.get_shape()[1] == 10 and cv.size() == 100 and cv.nparts() == 3;
+        for (long i = 0; i < 10; ++i) {
+            for (long j = 0; j < 10; ++j) {
+                ok = ok and cv(i, j) == ref(i, j);
+            }
+        }
+        cv(4, 2) = -1.;
+        ok = ok and b(3, 7) == -1.;
+        cv(4, 2) = ref(4, 2);
+        msg.append(MakeString() << "element access: " << ok << "\n");
+        success = success and ok;
+
+        //a window across the three parts, and one inside a part
+        auto w = cv.window(2, 9);
+        ok = w.get_shape()[0] == 7 and w.nparts() == 3 and w.part(0).get_shape()[0] == 1 and w.part(2).get_shape()[0] == 1;
+        for (long i = 0; i < 7; ++i) {
+            for (long j = 0; j < 10; ++j) {
+                ok = ok and w(i, j) == ref(i+2, j);
+            }
+        }
+        auto inner = cv.window(4, 6);
+        ok = ok and inner.nparts() == 1 and inner(1, 3) == ref(5, 3);
+        msg.append(MakeString() << "window: " << ok << "\n");
+        success = success and ok;
+
+        nvector<double, 2> out (make_indexer(10, 10), 0.);
+        cv.copy_to(out);
+        ok = out.data_ == ref.data_;
+        for (auto & policy: small_chunk_policies()) {
+            nvector<double, 2> o (make_indexer(7, 10), 0.);
+            w.copy_to(policy, o);
+            for (long i = 0; i < 7; ++i) {
+                for (long j = 0; j < 10; ++j) {
+                    ok = ok and o(i, j) == ref(i+2, j);
+                }
+            }
+        }
+        msg.append(MakeString() << "copy_to: " << ok << "\n");
+        success = success and ok;
+
+        auto d = make_cycling_input(3, 9, 0.);
+        try {
+            make_concat_view(std::tie(a, d), 0);
+            ok = false;
+        } catch (std::domain_error &) {
+            ok = true;
+        }
+        msg.append(MakeString() << "shape mismatch throws: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    loops() {
+        DECLARE_TEST(success, msg);
+
+        //two concat_views along axis 1 with different parts, a broadcasted column and an output
+        auto a = make_cycling_input(6, 4, 0.);
+        auto b = make_cycling_input(6, 7, 50.);
+        auto c = make_cycling_input(6, 5, 0.);
+        auto d = make_cycling_input(6, 6, 10.);
+        vector<ndataview<double, 2>> parts_x {a.as_view(), b.as_view()};
+        vector<ndataview<double, 2>> parts_y {c.as_view(), d.as_view()};
+        auto x = make_concat_view(parts_x, 1);
+        auto y = make_concat_view(parts_y, 1);
+        auto ref_x = concatenate(parts_x, 1);
+        auto ref_y = concatenate(parts_y, 1);
+
+        nvector<double, 2> col (make_indexer(6, 1), 0.);
+        for (long i = 0; i < 6; ++i) {
+            col(i, 0) = 1000.*double(i);
+        }
+
+        nvector<double, 2> ref (make_indexer(6, 11), 0.);
+        for (long i = 0; i < 6; ++i) {
+            for (long j = 0; j < 11; ++j) {
+                ref(i, j) = ref_x(i, j)*ref_y(i, j)+col(i, 0);
+            }
+        }
+
+        nvector<double, 2> out (make_indexer(6, 11), 0.);
+        nforeach_concat(std::tie(x, y, col, out), [] (double u, double v, double k, double & o) {o = u*v+k;});
+        bool ok = out.data_ == ref.data_;
+        for (auto & policy: small_chunk_policies()) {
+            nvector<double, 2> o (make_indexer(6, 11), 0.);
+            nforeach_concat(policy, std::tie(o, x, y, col), [] (double & o, double u, double v, double k) {o = u*v+k;});
+            ok = ok and o.data_ == ref.data_;
+        }
+
+        //writing through a concat_view
+        nforeach_concat(parallel_policy().with_chunk_size(4), std::tie(x, col), [] (double & u, double k) {u = -k;});
+        ok = ok and a(3, 2) == -3000. and b(5, 6) == -5000.;
+        msg.append(MakeString() << "nforeach_concat: " << ok << "\n");
+        success = success and ok;
+
+        auto z = make_concat_view(std::tie(a, b, a), 1);
+        try {
+            nforeach_concat(std::tie(x, z), [] (double, double) {});
+            ok = false;
+        } catch (std::domain_error &) {
+            ok = true;
+        }
+        msg.append(MakeString() << "different shapes throw: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(element_access(), success_bool, msg);
+        RUN_TEST(loops(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
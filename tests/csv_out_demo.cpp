@@ -70,14 +70,9 @@ int main(int /*argc*/, char** /*argv */)
                 return index_frac_s-x_start;
             });
 
-    //concatenation of x and y
-    nvector<float, 2> xy (make_indexer(2, x_interp.get_shape()[0]));
-    xy.slice(0, range()).assign(x);
-    xy.slice(1, range()).assign(y);
-
-    nvector<float, 2> xy_interp (make_indexer(2, x_interp.get_shape()[0]));
-    xy_interp.slice(0, range()).assign(x_interp);
-    xy_interp.slice(1, range()).assign(y_interp);
+    //x and y as the rows of a single array
+    nvector<float, 2> xy = stack(std::tie(x, y), 0);
+    nvector<float, 2> xy_interp = stack(std::tie(x_interp, y_interp), 0);
 
     string str1 = nvector2csv(xy);
     string str2 = nvector2csv(xy_interp);
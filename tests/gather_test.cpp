@@ -0,0 +1,213 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/gather.hpp"
+
+#include "tests/test_helpers.hpp"
+
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+using namespace ndata::test_helpers;
+
+struct TestSuite {
+
+    static
+    nvector<double, 2>
+    make_field(long n0, long n1) {
+        //with fractional parts, not only whole numbers
+        auto u = make_cycling_input(n0, n1, 0.);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] += 0.25*double(i%4);
+        }
+        return u;
+    }
+
+    //pseudo random indices in [0, n)
+    static
+    nvector<long, 1>
+    make_indices(long npoints, long n, long seed) {
+        nvector<long, 1> ret (make_indexer(npoints), 0l);
+        unsigned long state = (unsigned long)(seed);
+        for (long p = 0; p < npoints; ++p) {
+            state = state*6364136223846793005ul+1442695040888963407ul;
+            ret[size_t(p)] = long((state >> 33)%(unsigned long)(n));
+        }
+        return ret;
+    }
+
+    static
+    test_result
+    gathers() {
+        DECLARE_TEST(success, msg);
+
+        auto field = make_field(50, 40);
+        auto ix = make_indices(1000, 50, 1);
+        auto iy = make_indices(1000, 40, 2);
+
+        auto values = take(field, std::tie(ix, iy));
+        bool ok = values.get_shape()[0] == 1000;
+        for (long p = 0; p < 1000; ++p) {
+            ok = ok and values(p) == field(ix(p), iy(p));
+        }
+        for (auto & policy: small_chunk_policies()) {
+            ok = ok and take(policy, field, std::tie(ix, iy)).data_ == values.data_;
+        }
+
+        //broadcasted index arrays, on a strided source
+        auto odd = field.slice(range(1, 50, 2), range());
+        nvector<long, 2> rows (make_indexer(5, 1), 0l);
+        nvector<long, 2> cols (make_indexer(1, 4), 0l);
+        for (long i = 0; i < 5; ++i) {
+            rows(i, 0) = 23-5*i;
+        }
+        for (long j = 0; j < 4; ++j) {
+            cols(0, j) = 3*j+1;
+        }
+        auto grid = take(parallel_policy().with_chunk_size(2), odd, std::tie(rows, cols));
+        ok = ok and grid.get_shape()[0] == 5 and grid.get_shape()[1] == 4;
+        for (long i = 0; i < 5; ++i) {
+            for (long j = 0; j < 4; ++j) {
+                ok = ok and grid(i, j) == field(2*(23-5*i)+1, 3*j+1);
+            }
+        }
+        msg.append(MakeString() << "take on points: " << ok << "\n");
+        success = success and ok;
+
+        nvector<long, 2> picks (make_indexer(3, 2), 0l);
+        for (size_t i = 0; i < picks.size(); ++i) {
+            picks[i] = long(i*13%40);
+        }
+        auto t = take(field, picks, 1);
+        ok = t.get_shape()[0] == 50 and t.get_shape()[1] == 3 and t.get_shape()[2] == 2;
+        for (long i = 0; i < 50; ++i) {
+            for (long j = 0; j < 3; ++j) {
+                for (long k = 0; k < 2; ++k) {
+                    ok = ok and t(i, j, k) == field(i, picks(j, k));
+                }
+            }
+        }
+        auto t0 = take(parallel_policy().with_chunk_size(7), field, ix, 0);
+        ok = ok and t0.get_shape()[0] == 1000 and t0.get_shape()[1] == 40;
+        for (long p = 0; p < 1000; ++p) {
+            ok = ok and t0(p, 5) == field(ix(p), 5);
+        }
+        msg.append(MakeString() << "take along an axis: " << ok << "\n");
+        success = success and ok;
+
+        //the position of the minimum of each row
+        nvector<long, 2> argmin (make_indexer(50, 1), 0l);
+        for (long i = 0; i < 50; ++i) {
+            for (long j = 1; j < 40; ++j) {
+                if (field(i, j) < field(i, argmin(i, 0))) {
+                    argmin(i, 0) = j;
+                }
+            }
+        }
+        auto minima = take_along_axis(field, argmin, 1);
+        ok = minima.get_shape()[0] == 50 and minima.get_shape()[1] == 1;
+        for (long i = 0; i < 50; ++i) {
+            for (long j = 0; j < 40; ++j) {
+                ok = ok and minima(i, 0) <= field(i, j);
+            }
+        }
+        //the same columns for all rows
+        auto same_cols = take_along_axis(parallel_policy().with_chunk_size(3), field, cols, 1);
+        ok = ok and same_cols.get_shape()[0] == 50 and same_cols.get_shape()[1] == 4;
+        for (long i = 0; i < 50; ++i) {
+            for (long j = 0; j < 4; ++j) {
+                ok = ok and same_cols(i, j) == field(i, cols(0, j));
+            }
+        }
+        msg.append(MakeString() << "take_along_axis: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    scatters() {
+        DECLARE_TEST(success, msg);
+
+        //many points per element
+        auto ix = make_indices(5000, 20, 3);
+        auto iy = make_indices(5000, 10, 4);
+        nvector<double, 1> vals (make_indexer(5000), 0.);
+        for (long p = 0; p < 5000; ++p) {
+            vals(p) = 0.1*double(p%17);
+        }
+
+        nvector<double, 2> ref_last (make_indexer(20, 10), -1.);
+        nvector<double, 2> ref_sum (make_indexer(20, 10), 0.);
+        nvector<long, 2> ref_counts (make_indexer(20, 10), 0l);
+        for (long p = 0; p < 5000; ++p) {
+            ref_last(ix(p), iy(p)) = vals(p);
+            ref_sum(ix(p), iy(p)) += vals(p);
+            ref_counts(ix(p), iy(p)) += 1;
+        }
+
+        nvector<double, 2> last (make_indexer(20, 10), -1.);
+        put(last, std::tie(ix, iy), vals);
+        bool ok = last.data_ == ref_last.data_;
+        for (auto & policy: small_chunk_policies()) {
+            nvector<double, 2> l (make_indexer(20, 10), -1.);
+            put(policy, l, std::tie(ix, iy), vals);
+            ok = ok and l.data_ == ref_last.data_;
+        }
+        msg.append(MakeString() << "put: " << ok << "\n");
+        success = success and ok;
+
+        //the additions are in the same order whatever the policy, the sums are exactly the same
+        nvector<double, 2> sum (make_indexer(20, 10), 0.);
+        scatter_add(sum, std::tie(ix, iy), vals);
+        ok = sum.data_ == ref_sum.data_;
+        auto one = make_nvector(1l);
+        for (auto & policy: small_chunk_policies()) {
+            nvector<double, 2> s (make_indexer(20, 10), 0.);
+            scatter_add(policy, s, std::tie(ix, iy), vals);
+            ok = ok and s.data_ == ref_sum.data_;
+
+            nvector<long, 2> counts (make_indexer(20, 10), 0l);
+            scatter_add(policy, counts, std::tie(ix, iy), one);
+            ok = ok and counts.data_ == ref_counts.data_;
+        }
+
+        //into a flipped view
+        nvector<long, 2> counts (make_indexer(20, 10), 0l);
+        auto flipped = counts.flip();
+        scatter_add(parallel_policy().with_chunk_size(11), flipped, std::tie(ix, iy), one);
+        for (long i = 0; i < 20; ++i) {
+            for (long j = 0; j < 10; ++j) {
+                ok = ok and counts(19-i, 9-j) == ref_counts(i, j);
+            }
+        }
+        msg.append(MakeString() << "scatter_add: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(gathers(), success_bool, msg);
+        RUN_TEST(scatters(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
@@ -1,7 +1,11 @@
 #include "ndata/debug_helpers.hpp"
 
+//small enough for the copies of the tests to go through the streaming stores
+#define NDATA_STREAMING_STORE_BYTES 2048
+
 #include "ndata.hpp"
 #include <memory>
+#include <limits>
 
 //TODO test dynamic ndarrays
 //TODO test array with dimension 0 (slice, etc)
@@ -481,6 +485,849 @@ struct TestSuite {
         RETURN_TESTRESULT(sb, msg)
     }
 
+    static
+    test_result row_kernels_test () {
+        DECLARE_TEST(sb, msg);
+
+        size_t Nx = 4, Ny = 7;
+        auto u = make_nvector<long>(make_indexer(Nx, Ny));
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = i;
+        }
+
+        //contiguous rows
+        auto u2 = make_nvector<long>(make_indexer(Nx, Ny));
+        nforeach(std::tie(u2, u), [] (long & v2, long v) {
+            v2 = 2*v;
+        });
+
+        //rows with a broadcasted accumulator (stride 0 along the innermost dimension)
+        auto row_sums = make_nvector<long>(make_indexer(Nx, 1), 0l);
+        nforeach(std::tie(row_sums, u), [] (long & acc, long v) {
+            acc += v;
+        });
+
+        //broadcasted read only operand and strided operand
+        auto offset = make_nvector<long>(make_indexer(1), 10l);
+        auto u_strided = u.slice(range(), range(0, Ny, 2));
+        auto u3 = ntransform<long>(std::make_tuple(u_strided, offset), [] (long v, long o) {
+            return v+o;
+        });
+
+        for (size_t ix = 0; ix < Nx; ++ix) {
+            long ref_sum = 0;
+            for (size_t iy = 0; iy < Ny; ++iy) {
+                ref_sum += u(ix, iy);
+                sb = sb and u2(ix, iy) == 2*u(ix, iy);
+            }
+            for (long iy = 0; iy < u3.get_shape()[1]; ++iy) {
+                sb = sb and u3(ix, iy) == u(ix, 2*iy)+10;
+            }
+            sb = sb and row_sums(ix, 0) == ref_sum;
+            msg.append(MakeString() << row_sums(ix, 0) << " ==? " << ref_sum << "\n");
+        }
+
+        sb = sb and offset(0) == 10;
+
+        //the functor gets the broadcasted elements themselves, not copies of them
+        bool same_address = true;
+        nforeach(std::tie(row_sums, u), [&] (long & acc, long v) {
+            same_address = same_address and &acc == &row_sums(v/long(Ny), 0);
+        });
+        sb = sb and same_address;
+        msg.append(MakeString() << "broadcasted references: " << same_address << "\n");
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result loop_planner_test () {
+        DECLARE_TEST(sb, msg);
+
+        //C contiguous operands and a broadcasted one are merged into a single dimension
+        helpers::loop_geometry<2, 3> geom;
+        geom.shape = {{4, 3, 2}};
+        geom.strides = {{ {{6, 0}}, {{2, 0}}, {{1, 0}} }};
+        helpers::optimize_loop_geometry(geom);
+
+        sb = sb and geom.shape[0] == 1 and geom.shape[1] == 1 and geom.shape[2] == 24;
+        sb = sb and geom.strides[2][0] == 1 and geom.strides[2][1] == 0;
+        msg.append(MakeString() << "coalesced shape: " << geom.shape[0] << ", " << geom.shape[1] << ", " << geom.shape[2] << "\n");
+
+        //fortran ordered strides are traversed in memory order
+        helpers::loop_geometry<1, 2> geom_f;
+        geom_f.shape = {{3, 5}};
+        geom_f.strides = {{ {{1}}, {{3}} }};
+        helpers::optimize_loop_geometry(geom_f);
+
+        sb = sb and geom_f.shape[1] == 15 and geom_f.strides[1][0] == 1;
+
+        //non mergeable dimensions are reordered
+        helpers::loop_geometry<1, 3> geom_s;
+        geom_s.shape = {{3, 5, 7}};
+        geom_s.strides = {{ {{2}}, {{100}}, {{6}} }};
+        helpers::optimize_loop_geometry(geom_s);
+
+        sb = sb and geom_s.shape[0] == 1 and geom_s.shape[1] == 5 and geom_s.shape[2] == 21;
+        sb = sb and geom_s.strides[2][0] == 2 and geom_s.strides[1][0] == 100;
+        msg.append(MakeString() << "reordered shape: " << geom_s.shape[0] << ", " << geom_s.shape[1] << ", " << geom_s.shape[2] << "\n");
+
+        //a dimension of size one in the middle doesn't prevent the reordering: transposed (5, 1, 7)
+        helpers::loop_geometry<1, 3> geom_t;
+        geom_t.shape = {{5, 1, 7}};
+        geom_t.strides = {{ {{1}}, {{5}}, {{5}} }};
+        helpers::optimize_loop_geometry(geom_t);
+
+        sb = sb and geom_t.shape[0] == 1 and geom_t.shape[1] == 1 and geom_t.shape[2] == 35 and geom_t.strides[2][0] == 1;
+        msg.append(MakeString() << "transposed with a size one dimension: " << geom_t.shape[2] << ", " << geom_t.strides[2][0] << "\n");
+
+        //small innermost extents
+        auto u = make_nvector<long>(make_indexer(6, 4, 3, 2));
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = i;
+        }
+
+        auto usli = u.slice(range(0, 6, 2), range(), range(1, 3), range());
+        auto res = ntransform<long>(std::make_tuple(usli), [] (long v) {return v;});
+        auto res_par = ntransform<long, PARALLEL>(std::make_tuple(usli), [] (long v) {return v;});
+
+        for (long i0 = 0; i0 < 3; ++i0) {
+            for (long i1 = 0; i1 < 4; ++i1) {
+                for (long i2 = 0; i2 < 2; ++i2) {
+                    for (long i3 = 0; i3 < 2; ++i3) {
+                        long ref = u(2*i0, i1, i2+1, i3);
+                        sb = sb and res(i0, i1, i2, i3) == ref and res_par(i0, i1, i2, i3) == ref;
+                    }
+                }
+            }
+        }
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result parallel_partition_test () {
+        DECLARE_TEST(sb, msg);
+
+        //few long rows on many threads, rows get split at cache line boundaries
+        long nthreads = 64, n_rows = 2, row_len = 4096*4096, line_elts = 16;
+        long grain = helpers::chunk_grain(n_rows, row_len, 1, line_elts, nthreads);
+        sb = sb and grain == line_elts;
+
+        long total = n_rows*row_len;
+        long prev = 0;
+        for (long ithread = 0; ithread <= nthreads; ++ithread) {
+            long b = helpers::chunk_boundary(total, grain, nthreads, ithread);
+            sb = sb and b >= prev and (b%grain == 0 or b == total);
+            prev = b;
+        }
+        sb = sb and prev == total;
+        msg.append(MakeString() << "grain for 2 rows, 64 threads: " << grain << "\n");
+
+        //many short rows are grouped to cover whole cache lines
+        grain = helpers::chunk_grain(4096, 6, 1, line_elts, 8);
+        sb = sb and grain%line_elts == 0 and grain%6 == 0;
+        msg.append(MakeString() << "grain for rows of 6 elements: " << grain << "\n");
+
+        //parallel loops give the same results as the serial ones
+        auto u = make_nvector<long>(make_indexer(3, 50, 7));
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = i;
+        }
+        auto usli = u.slice(range(), range(1, 50, 3), range());
+
+        auto res = ntransform<long>(std::make_tuple(usli), [] (long v) {return 3*v;});
+        auto res_par = ntransform<long, PARALLEL>(std::make_tuple(usli), [] (long v) {return 3*v;});
+
+        for (size_t i = 0; i < res.size(); ++i) {
+            sb = sb and res[i] == res_par[i];
+        }
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result nreduce_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(7, 300, 11));
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i*7919%1001)-500;
+        }
+        auto usli = u.slice(range(), range(1, 300, 2), range());
+        auto two = make_nvector<long>(2l); //0D, broadcasted
+
+        auto sh = usli.get_shape();
+        long sum_ref = 0, dot_ref = 0, max_ref = usli(0, 0, 0);
+        for (long i0 = 0; i0 < sh[0]; ++i0) {
+            for (long i1 = 0; i1 < sh[1]; ++i1) {
+                for (long i2 = 0; i2 < sh[2]; ++i2) {
+                    long v = usli(i0, i1, i2);
+                    sum_ref += v;
+                    dot_ref += 2*v;
+                    max_ref = std::max(max_ref, v);
+                }
+            }
+        }
+
+        auto plus = [] (long & acc, long v) {acc += v;};
+        auto max = [] (long & acc, long v) {acc = std::max(acc, v);};
+        auto dot = [] (long & acc, long a, long b) {acc += a*b;};
+        auto combine_plus = [] (long a, long b) {return a+b;};
+
+        std::vector<parallel_policy> policies {
+            parallel_policy(),
+            parallel_policy().with_schedule(schedule_kind::DYNAMIC).with_chunk_size(100),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_chunk_size(37),
+        };
+
+        sb = sb and nreduce(std::tie(usli), 0l, plus) == sum_ref;
+        sb = sb and nreduce<PARALLEL>(std::tie(usli), 0l, plus) == sum_ref;
+        sb = sb and nreduce(serial_policy(), std::tie(usli, two), 0l, dot, combine_plus) == dot_ref;
+
+        for (auto & pol: policies) {
+            sb = sb and nreduce(pol, std::tie(usli), 0l, plus) == sum_ref;
+            sb = sb and nreduce(pol, std::tie(usli), std::numeric_limits<long>::min(), max) == max_ref;
+            sb = sb and nreduce(pol, std::tie(usli, two), 0l, dot, combine_plus) == dot_ref;
+        }
+
+        //accumulator of a different type, counting the positive elements
+        long npos_ref = 0;
+        nforeach(std::tie(usli), [&npos_ref] (long v) {npos_ref += (v > 0);});
+        auto npos = nreduce(
+                    parallel_policy(),
+                    std::tie(usli),
+                    size_t(0),
+                    [] (size_t & acc, long v) {acc += (v > 0);},
+                    [] (size_t a, size_t b) {return a+b;}
+                    );
+        sb = sb and long(npos) == npos_ref;
+
+        //0D
+        sb = sb and nreduce(parallel_policy(), std::tie(two), 1l, plus) == 3;
+
+        msg.append(MakeString() << "sum: " << sum_ref << ", dot: " << dot_ref << ", max: " << max_ref << "\n");
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result expression_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto a = make_nvector<double>(make_indexer(5, 40, 3));
+        auto b = make_nvector<double>(make_indexer(5, 40, 3));
+        auto c = make_nvector<long>(make_indexer(3));
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = double(i%17)+1.;
+            b[i] = double(i%5)-2.;
+        }
+        for (size_t i = 0; i < c.size(); ++i) {
+            c[i] = long(i)*10;
+        }
+
+        //one loop, broadcasting c along the first axes, scalars on both sides
+        nvector<double, 3> r = 2.*a*b - c/4. + 1.;
+        auto r_ref = ntransform<double>(std::tie(a, b, c), [] (double va, double vb, long vc) {
+            return 2.*va*vb - vc/4. + 1.;
+        });
+        sb = sb and r.data_ == r_ref.data_;
+
+        //in place, with a unary minus and a strided view as leaf
+        auto asli = a.slice(range(), range(0, 38, 2), range());
+        auto bsli = b.slice(range(), range(1, 39, 2), range());
+        nvector<double, 3> s (asli);
+        s = -(s*bsli) + s;
+        bool same_sli = true;
+        auto sh = asli.get_shape();
+        for (long i0 = 0; i0 < sh[0]; ++i0) {
+            for (long i1 = 0; i1 < sh[1]; ++i1) {
+                for (long i2 = 0; i2 < sh[2]; ++i2) {
+                    same_sli = same_sli and s(i0, i1, i2) == -(asli(i0, i1, i2)*bsli(i0, i1, i2)) + asli(i0, i1, i2);
+                }
+            }
+        }
+        sb = sb and same_sli;
+
+        //evaluation and assignment with a policy, into a view
+        auto e = (a + b*b) / 2.;
+        auto r_par = e.eval(parallel_policy().with_chunk_size(64));
+        auto r_ser = e.eval();
+        sb = sb and r_par.data_ == r_ser.data_;
+        asli.assign(parallel_policy(), bsli*3. - 1.);
+        sb = sb and a(2, 4, 1) == b(2, 5, 1)*3. - 1.;
+
+        //the expression doesn't broadcast the assigned container
+        bool thrown = false;
+        try {
+            nvector<double, 1> small (make_indexer(3));
+            small = a + c;
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        //elementwise function
+        nvector<double, 3> m = nmap([] (double x, double y) {return std::max(x, y);}, a, b + 10.);
+        sb = sb and m(0, 0, 0) == std::max(a(0, 0, 0), b(0, 0, 0) + 10.);
+
+        msg.append(MakeString() << "r(1, 2, 2): " << r(1, 2, 2) << "\n");
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result ntransform_outputs_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(6, 50));
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i%13)-6;
+        }
+        auto offset = make_nvector<double>(make_indexer(50));
+        for (size_t i = 0; i < offset.size(); ++i) {
+            offset[i] = 0.5*double(i);
+        }
+
+        //result type from the functor
+        auto r = ntransform(parallel_policy(), std::tie(u, offset), [] (long v, double o) {return v+o;});
+        static_assert(std::is_same<decltype(r), nvector<double, 2>>::value, "");
+        auto r_ref = ntransform<double>(std::tie(u, offset), [] (long v, double o) {return v+o;});
+        sb = sb and r.data_ == r_ref.data_;
+
+        auto r_par = ntransform_parallel<double>(std::tie(u, offset), [] (long v, double o) {return v+o;});
+        sb = sb and r_par.data_ == r_ref.data_;
+
+        //several results in one loop
+        nvector<long, 2> sq, neg;
+        std::tie(sq, neg) = ntransform(serial_policy(), std::tie(u), [] (long v) {
+            return std::make_tuple(v*v, -v);
+        });
+        bool multi_ok = sq.get_shape()[1] == 50;
+        for (size_t i = 0; i < u.size(); ++i) {
+            multi_ok = multi_ok and sq[i] == u[i]*u[i] and neg[i] == -u[i];
+        }
+        sb = sb and multi_ok;
+
+        //into existing containers, a view and a tuple of outputs
+        auto out = make_nvector<double>(make_indexer(6, 100), -1.);
+        auto out_sli = out.slice(range(), range(0, 100, 2));
+        ntransform(parallel_policy().with_chunk_size(16), std::tie(u, offset), out_sli, [] (long v, double o) {return v*o;});
+        sb = sb and out(3, 20) == u(3, 10)*offset(10) and out(3, 21) == -1.;
+
+        auto sum = make_nvector<double>(make_indexer(6, 50));
+        auto prod = make_nvector<double>(make_indexer(6, 50));
+        ntransform(parallel_policy(), std::tie(u, offset), std::tie(sum, prod), [] (long v, double o) {
+            return std::make_tuple(v+o, v*o);
+        });
+        sb = sb and sum.data_ == r_ref.data_ and prod(5, 7) == u(5, 7)*offset(7);
+
+        //an output smaller than the inputs would be written several times
+        bool thrown = false;
+        try {
+            auto small = make_nvector<double>(make_indexer(50));
+            ntransform(serial_policy(), std::tie(u), small, [] (long v) {return double(v);});
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result loop_plan_test () {
+        DECLARE_TEST(sb, msg);
+
+        //blocks of a grid, each with a strided input and a broadcasted coefficient
+        const long nblocks = 20;
+        vector<nvector<double, 3>> outs, ins;
+        for (long ib = 0; ib < nblocks; ++ib) {
+            outs.push_back(make_nvector<double>(make_indexer(8, 8, 8), 0.));
+            ins.push_back(make_nvector<double>(make_indexer(8, 8, 16), 0.));
+            for (size_t i = 0; i < ins.back().size(); ++i) {
+                ins.back()[i] = double((long(i)*7+ib)%31);
+            }
+        }
+        auto coef = make_nvector<double>(make_indexer(8), 0.);
+        for (long i = 0; i < 8; ++i) {
+            coef(i) = 0.25*double(i);
+        }
+
+        auto func = [] (double & o, double v, double c) {o = v*c + 1.;};
+
+        for (int parallel = 0; parallel < 2; ++parallel) {
+            auto in0 = ins[0].slice(range(), range(), range(0, 16, 2));
+            auto plan_serial = make_loop_plan(std::tie(outs[0], in0, coef));
+            auto plan_parallel = make_loop_plan(parallel_policy().with_chunk_size(64), std::tie(outs[0], in0, coef));
+
+            for (long ib = 0; ib < nblocks; ++ib) {
+                auto in_sli = ins[ib].slice(range(), range(), range(0, 16, 2));
+                if (parallel) {
+                    plan_parallel.run(std::tie(outs[ib], in_sli, coef), func);
+                } else {
+                    //rebinding directly to the data
+                    plan_serial.run(std::make_tuple(&outs[ib].data_[0], in_sli.data_, &coef.data_[0]), func);
+                }
+
+                auto ref = make_nvector<double>(make_indexer(8, 8, 8), 0.);
+                nforeach(std::tie(ref, in_sli, coef), func);
+                sb = sb and ref.data_ == outs[ib].data_;
+                nforeach(std::tie(outs[ib]), [] (double & o) {o = 0.;});
+            }
+
+            auto other = ins[0].slice(range(), range(), range(1, 16, 2));
+            auto other_shape = ins[0].slice(range(0, 4), range(), range(0, 16, 2));
+            sb = sb and plan_serial.matches(std::tie(outs[0], in0, coef))
+                    and not plan_serial.matches(std::tie(outs[0], other, coef))
+                    and not plan_serial.matches(std::tie(outs[1], other_shape, coef));
+        }
+
+        //a transposition is traversed in tiles, also by a parallel plan
+        auto src = make_nvector<long>(make_indexer(100, 70), 0l);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = long(i);
+        }
+        auto src_t = src.reshape(make_vecarray(70l, 100l), make_vecarray(1l, 70l));
+        auto dst = make_nvector<long>(make_indexer(70, 100), -1l);
+        auto plan_t = make_loop_plan(parallel_policy().with_chunk_size(64), std::tie(dst, src_t));
+        plan_t.run(std::tie(dst, src_t), [] (long & d, long v) {d = v;});
+        bool transposed = plan_t.tiled_;
+        for (long i = 0; i < 70; ++i) {
+            for (long j = 0; j < 100; ++j) {
+                transposed = transposed and dst(i, j) == src(j, i);
+            }
+        }
+        msg.append(MakeString() << "tiled plan: " << transposed << "\n");
+        sb = sb and transposed;
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result tiled_traversal_test () {
+        DECLARE_TEST(sb, msg);
+
+        //transposed copies, with partial tiles on both sides
+        const long n0 = 100, n1 = 70;
+        auto u = make_nvector<long>(make_indexer(n0, n1), 0l);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i);
+        }
+        auto ut = u.reshape(make_vecarray(n1, n0), make_vecarray(1l, n1));
+
+        for (int ipolicy = 0; ipolicy < 3; ++ipolicy) {
+            auto v = make_nvector<long>(make_indexer(n1, n0), -1l);
+            if (ipolicy == 0) {
+                v.assign(ut);
+            } else if (ipolicy == 1) {
+                v.assign(parallel_policy(), ut);
+            } else {
+                v.assign(parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_chunk_size(100), ut);
+            }
+            bool ok = true;
+            for (long i = 0; i < n1; ++i) {
+                for (long j = 0; j < n0; ++j) {
+                    ok = ok and v(i, j) == u(j, i);
+                }
+            }
+            sb = sb and ok;
+        }
+
+        //the planner picks the tiles for the transposition, not for a plain copy
+        auto out = make_nvector<long>(make_indexer(n1, n0), 0l);
+        auto views_t = std::make_tuple(out.as_view(), ut);
+        auto geom_t = helpers::make_loop_geometry<2>(views_t);
+        helpers::optimize_loop_geometry(geom_t);
+        auto views_c = std::make_tuple(u.as_view(), u.as_view());
+        auto geom_c = helpers::make_loop_geometry<2>(views_c);
+        helpers::optimize_loop_geometry(geom_c);
+        sb = sb and helpers::tiling_dim<long, long>(geom_t) == 0 and helpers::tiling_dim<long, long>(geom_c) == -1;
+
+        //3D, the elements of each line along an axis are still visited in increasing order
+        auto w = make_nvector<long>(make_indexer(3, 70, 80), 0l);
+        auto wt = w.reshape(make_vecarray(3l, 80l, 70l), make_vecarray(5600l, 1l, 80l));
+        auto last = make_nvector<long>(make_indexer(3, 80), -1l);
+        auto last_bc = last.reshape(make_vecarray(3l, 80l, 70l), make_vecarray(80l, 1l, 0l));
+        auto count = make_nvector<long>(make_indexer(3, 80, 70), 0l);
+        bool ordered = true;
+        nforeach(std::make_tuple(count.as_view(), wt, last_bc), [&ordered] (long & c, long & val, long & l) {
+            val += 1;
+            ordered = ordered and c == 0;
+            c = ++l;
+        });
+        for (long i = 0; i < 3; ++i) {
+            for (long j = 0; j < 80; ++j) {
+                for (long k = 0; k < 70; ++k) {
+                    ordered = ordered and count(i, j, k) == k;
+                }
+            }
+        }
+        sb = sb and ordered;
+        for (size_t i = 0; i < w.size(); ++i) {
+            sb = sb and w[i] == 1;
+        }
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result permute_axes_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(2, 3, 4), 0l);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i);
+        }
+
+        auto p = u.permute_axes({2, 0, 1});
+        auto t = u.transpose();
+        auto s = u.swapaxes(0, 2);
+        sb = sb and p.get_shape()[0] == 4 and p.get_shape()[1] == 2 and p.get_shape()[2] == 3;
+        sb = sb and t.get_shape()[0] == 4 and t.get_shape()[2] == 2 and s.get_shape()[1] == 3;
+
+        bool same_elements = true;
+        for (long i = 0; i < 2; ++i) {
+            for (long j = 0; j < 3; ++j) {
+                for (long k = 0; k < 4; ++k) {
+                    same_elements = same_elements
+                            and p(k, i, j) == u(i, j, k)
+                            and t(k, j, i) == u(i, j, k)
+                            and s(k, j, i) == u(i, j, k);
+                }
+            }
+        }
+        sb = sb and same_elements;
+
+        //views, writes go to u
+        t(3, 2, 1) = -1;
+        sb = sb and u(1, 2, 3) == -1;
+
+        //a transposed C array is fortran ordered
+        sb = sb and u.is_c_contiguous() and not u.is_fortran_contiguous();
+        sb = sb and t.is_fortran_contiguous() and not t.is_c_contiguous();
+        sb = sb and u.slice(range(1, 2), range(), range()).is_c_contiguous()
+                and not u.slice(range(), range(0, 1), range()).is_c_contiguous();
+
+        //fortran ordered data, seen from C++ with the same indices
+        indexer<2> f (make_vecarray(3l, 5l), FORTRAN_ORDER);
+        sb = sb and f.get_strides()[0] == 1 and f.get_strides()[1] == 3 and f.is_fortran_contiguous();
+
+        vector<double> column_major (15);
+        for (size_t i = 0; i < column_major.size(); ++i) {
+            column_major[i] = double(i);
+        }
+        ndataview<double, 2> fv (f, &column_major[0]);
+        sb = sb and fv(2, 4) == double(2+3*4) and fv(1, 0) == 1.;
+
+        nvector<double, 2> fn (make_indexer(3, 5), FORTRAN_ORDER, 0.);
+        fn.assign(fv);
+        sb = sb and fn.is_fortran_contiguous() and fn.data_ == column_major;
+
+        //copies to C order
+        auto c = make_nvector<double>(make_indexer(3, 5), 0.);
+        c.assign(fn);
+        sb = sb and c(2, 4) == fv(2, 4) and c.data_[1] == fv(0, 1);
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result reshape_views_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(4, 6), 0l);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i);
+        }
+
+        //(N, M*K) seen as (N, M, K) without a copy
+        auto r = u.reshape(make_vecarray(4l, 2l, 3l));
+        sb = sb and &r.data_[0] == &u.data_[0] and r(3, 1, 2) == u(3, 5) and r.is_c_contiguous();
+        auto inferred = u.reshape(make_vecarray(-1l, 8l));
+        sb = sb and inferred.get_shape()[0] == 3 and inferred(2, 7) == 23;
+
+        //strided but compatible: every other row, the columns split in two
+        auto rows = u.slice(range(0, 4, 2), range());
+        auto rr = rows.reshape(make_vecarray(2l, 2l, 3l));
+        sb = sb and rr(1, 1, 0) == u(2, 3);
+
+        //merging the axes of a transposed view needs a copy
+        auto t = u.transpose();
+        sb = sb and not t.can_reshape_view(make_vecarray(24l));
+        bool thrown = false;
+        try {
+            t.reshape(make_vecarray(24l));
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        vector<long> buffer;
+        auto flat_t = t.reshape(make_vecarray(24l), buffer);
+        sb = sb and buffer.size() == 24 and &flat_t.data_[0] == &buffer[0];
+        sb = sb and flat_t(0) == 0 and flat_t(1) == 6 and flat_t(3) == 18 and flat_t(4) == 1;
+        auto flat_u = u.reshape(make_vecarray(24l), buffer);
+        sb = sb and &flat_u.data_[0] == &u.data_[0] and buffer.size() == 24;
+
+        thrown = false;
+        try {
+            u.reshape(make_vecarray(5l, 5l));
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        //size 1 axes
+        auto e = u.expand_dims(1);
+        sb = sb and e.get_shape()[0] == 4 and e.get_shape()[1] == 1 and e.get_shape()[2] == 6 and e(2, 0, 5) == u(2, 5);
+        auto sq = e.squeeze(1);
+        sb = sb and sq.get_shape()[0] == 4 and sq.get_shape()[1] == 6 and sq(3, 1) == u(3, 1);
+        auto row = u.slice(range(1, 2), range()).squeeze(0);
+        sb = sb and row.get_shape()[0] == 6 and row(4) == u(1, 4);
+
+        //flipped views, through negative strides
+        auto f0 = u.flip(0);
+        auto f = u.flip();
+        sb = sb and f0(0, 2) == u(3, 2) and f(0, 0) == u(3, 5) and f(3, 5) == u(0, 0) and f(1, 2) == u(2, 3);
+
+        auto copied = make_nvector<long>(make_indexer(4, 6), 0l);
+        copied.assign(f);
+        sb = sb and copied[0] == 23 and copied[23] == 0;
+
+        for (auto const & policy : {parallel_policy(), parallel_policy().with_schedule(schedule_kind::DYNAMIC)}) {
+            auto sum = make_nvector<long>(make_indexer(4, 6), 0l);
+            sum.assign_transform(policy, std::tie(u, f), [] (long a, long b) {return a+b;});
+            bool all_23 = true;
+            for (size_t i = 0; i < sum.size(); ++i) {
+                all_23 = all_23 and sum[i] == 23;
+            }
+            sb = sb and all_23;
+        }
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result sliding_window_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(5, 7), 0l);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i*i%13);
+        }
+
+        auto w = u.sliding_window_view(make_vecarray(3l, 2l));
+        sb = sb and w.get_shape()[0] == 3 and w.get_shape()[1] == 6 and w.get_shape()[2] == 3 and w.get_shape()[3] == 2;
+        bool same_elements = true;
+        for (long i = 0; i < 3; ++i) {
+            for (long j = 0; j < 6; ++j) {
+                for (long k = 0; k < 3; ++k) {
+                    for (long l = 0; l < 2; ++l) {
+                        same_elements = same_elements and w(i, j, k, l) == u(i+k, j+l);
+                    }
+                }
+            }
+        }
+        sb = sb and same_elements;
+
+        //moving sums of 3 elements along the rows, straight off u: the window axis is
+        //reduced into the output broadcasted along it
+        auto rows = u.sliding_window_view(make_vecarray(3l), make_vecarray(size_t(1)));
+        auto sums = make_nvector<long>(make_indexer(5, 5), 0l);
+        auto sums_bc = sums.expand_dims(2);
+        nforeach(std::tie(sums_bc, rows), [] (long & acc, long a) {acc += a;});
+        bool sums_ok = true;
+        for (long i = 0; i < 5; ++i) {
+            for (long j = 0; j < 5; ++j) {
+                sums_ok = sums_ok and sums(i, j) == u(i, j)+u(i, j+1)+u(i, j+2);
+            }
+        }
+        sb = sb and sums_ok;
+
+        //on a strided view
+        auto every_other = u.slice(range(), range(0, 7, 2));
+        auto ew = every_other.sliding_window_view(make_vecarray(2l), make_vecarray(size_t(1)));
+        sb = sb and ew.get_shape()[1] == 2 and ew(4, 1, 1) == u(4, 4) and ew(3, 0, 1) == u(3, 2);
+
+        bool thrown = false;
+        try {
+            u.sliding_window_view(make_vecarray(6l), make_vecarray(size_t(0)));
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result concatenate_test () {
+        DECLARE_TEST(sb, msg);
+
+        auto u = make_nvector<long>(make_indexer(5, 7), 0l);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = long(i);
+        }
+        auto a = u.slice(range(0, 3), range());
+        auto b = u.slice(range(3, 5), range());
+
+        std::vector<parallel_policy> policies = {
+            parallel_policy().with_chunk_size(2),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_threads(3).with_chunk_size(1)
+        };
+
+        //along axis 0 the pieces are single contiguous runs
+        auto c0 = concatenate(std::tie(b, a), 0);
+        bool ok = c0.get_shape()[0] == 5 and c0.get_shape()[1] == 7;
+        for (long j = 0; j < 7; ++j) {
+            ok = ok and c0(0, j) == u(3, j) and c0(1, j) == u(4, j) and c0(4, j) == u(2, j);
+        }
+        for (auto & policy: policies) {
+            ok = ok and concatenate(policy, std::tie(b, a), 0).data_ == c0.data_;
+        }
+        sb = sb and ok;
+
+        //along axis 1, with a strided and a flipped piece copied element by element
+        auto every_other = u.slice(range(), range(0, 7, 2));
+        auto flipped = u.flip();
+        auto c1 = concatenate(std::tie(u, every_other, flipped), 1);
+        ok = c1.get_shape()[0] == 5 and c1.get_shape()[1] == 7+3+7;
+        for (long i = 0; i < 5; ++i) {
+            for (long j = 0; j < 7; ++j) {
+                ok = ok and c1(i, j) == u(i, j) and c1(i, 10+j) == u(4-i, 6-j);
+            }
+            for (long j = 0; j < 3; ++j) {
+                ok = ok and c1(i, 7+j) == u(i, 2*j);
+            }
+        }
+        for (auto & policy: policies) {
+            ok = ok and concatenate(policy, std::tie(u, every_other, flipped), 1).data_ == c1.data_;
+        }
+        sb = sb and ok;
+
+        //tiles known at runtime, into a preallocated output
+        std::vector<ndataview<long, 2>> tiles;
+        for (long j = 0; j < 7; j += 2) {
+            tiles.push_back(u.slice(range(), range(j, std::min(j+2, 7l))));
+        }
+        auto assembled = make_nvector<long>(make_indexer(5, 7), 0l);
+        concatenate(policies[1], tiles, 1, assembled);
+        sb = sb and assembled.data_ == u.data_;
+
+        //stacking the rows of u back
+        auto r0 = u.slice(0, range());
+        auto r4 = u.slice(4, range());
+        auto s0 = stack(std::tie(r0, r4), 0);
+        auto s1 = stack(policies[0], std::tie(r0, r4), 1);
+        ok = s0.get_shape()[0] == 2 and s0.get_shape()[1] == 7 and s1.get_shape()[0] == 7 and s1.get_shape()[1] == 2;
+        for (long j = 0; j < 7; ++j) {
+            ok = ok and s0(0, j) == u(0, j) and s0(1, j) == u(4, j) and s1(j, 0) == u(0, j) and s1(j, 1) == u(4, j);
+        }
+        sb = sb and ok;
+
+        bool thrown = false;
+        try {
+            concatenate(std::tie(u, every_other), 0);
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        sb = sb and thrown;
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
+    static
+    test_result assign_copy_test () {
+        DECLARE_TEST(sb, msg);
+
+        std::vector<parallel_policy> policies = {
+            parallel_policy().with_chunk_size(100),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_threads(3).with_chunk_size(7)
+        };
+
+        //same type: memcpy, streamed past NDATA_STREAMING_STORE_BYTES (defined above)
+        auto u = make_nvector<double>(make_indexer(13, 37), 0.);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = 0.5*double(i)-100.;
+        }
+        auto copy = make_nvector<double>(make_indexer(13, 37), 0.);
+        copy.assign(u);
+        bool ok = copy.data_ == u.data_;
+        for (auto & policy: policies) {
+            auto c = make_nvector<double>(make_indexer(13, 37), 0.);
+            c.assign(policy, u);
+            ok = ok and c.data_ == u.data_;
+        }
+
+        //strided destination, flipped source
+        auto wide = make_nvector<double>(make_indexer(13, 74), 0.);
+        auto every_other = wide.slice(range(), range(0, 74, 2));
+        auto flipped = u.flip();
+        every_other.assign(policies[1], flipped);
+        for (long i = 0; i < 13; ++i) {
+            for (long j = 0; j < 37; ++j) {
+                ok = ok and wide(i, 2*j) == u(12-i, 36-j) and wide(i, 2*j+1) == 0.;
+            }
+        }
+        sb = sb and ok;
+
+        //conversions, on lengths that aren't multiples of the vector width
+        auto as_float = make_nvector<float>(make_indexer(13, 37), 0.f);
+        as_float.assign(u);
+        auto back = make_nvector<double>(make_indexer(13, 37), 0.);
+        back.assign(policies[0], as_float);
+        auto shorts = make_nvector<int16_t>(make_indexer(13, 37), int16_t(0));
+        for (size_t i = 0; i < shorts.size(); ++i) {
+            shorts[i] = int16_t(long(i*2654435761ul%65536)-32768);
+        }
+        nvector<float, 2> from_shorts (make_indexer(13, 37), &shorts.data_[0]);
+        for (size_t i = 0; i < u.size(); ++i) {
+            ok = ok and as_float[i] == float(u[i]) and back[i] == double(float(u[i])) and from_shorts[i] == float(shorts[i]);
+        }
+        for (auto & policy: policies) {
+            auto f = make_nvector<float>(make_indexer(13, 37), 0.f);
+            f.assign(policy, shorts);
+            ok = ok and f.data_ == from_shorts.data_;
+        }
+        sb = sb and ok;
+
+        //const source
+        auto const & u_const = u;
+        auto from_const = make_nvector<double>(make_indexer(13, 37), 0.);
+        from_const.assign(u_const);
+        ok = ok and from_const.data_ == u.data_;
+
+        //a row broadcasted to every row
+        auto row = make_nvector<double>(make_indexer(1, 37), 0.);
+        for (long j = 0; j < 37; ++j) {
+            row(0, j) = double(j)-3.;
+        }
+        for (auto & policy: policies) {
+            auto rows = make_nvector<double>(make_indexer(13, 37), 0.);
+            rows.assign(policy, row);
+            for (long i = 0; i < 13; ++i) {
+                for (long j = 0; j < 37; ++j) {
+                    ok = ok and rows(i, j) == row(0, j);
+                }
+            }
+        }
+        sb = sb and ok;
+
+        //incompatible shapes
+        auto wider = make_nvector<double>(make_indexer(13, 38), 0.);
+        bool thrown = false;
+        try {
+            copy.assign(wider);
+        } catch (std::domain_error const &) {
+            thrown = true;
+        }
+        msg.append(MakeString() << "const and broadcasted sources: " << ok << ", incompatible shapes throw: " << thrown << "\n");
+        sb = sb and thrown;
+
+        RETURN_TESTRESULT(sb, msg);
+    }
+
     static
     test_result run_all_tests () {
         DECLARE_TEST(b, s);
@@ -493,6 +1340,19 @@ struct TestSuite {
         RUN_TEST(broadcast_test(), b, s);
         RUN_TEST(extended_transform_test(), b, s);
         RUN_TEST(assign_transform_slice_alt(), b ,s)
+        RUN_TEST(row_kernels_test(), b, s);
+        RUN_TEST(loop_planner_test(), b, s);
+        RUN_TEST(parallel_partition_test(), b, s);
+        RUN_TEST(nreduce_test(), b, s);
+        RUN_TEST(expression_test(), b, s);
+        RUN_TEST(ntransform_outputs_test(), b, s);
+        RUN_TEST(loop_plan_test(), b, s);
+        RUN_TEST(tiled_traversal_test(), b, s);
+        RUN_TEST(permute_axes_test(), b, s);
+        RUN_TEST(reshape_views_test(), b, s);
+        RUN_TEST(sliding_window_test(), b, s);
+        RUN_TEST(concatenate_test(), b, s);
+        RUN_TEST(assign_copy_test(), b, s);
         RETURN_TESTRESULT(b, s);
     }
 };
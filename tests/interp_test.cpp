@@ -405,6 +405,50 @@ struct TestSuite {
     //TODO test resampling with axis option
     //also with axis numbers in decreasing order
 
+    /**
+     * Interpolation along some of the axes only, serially and in parallel
+     */
+    static
+    test_result partial_axes_parallel_3D() {
+
+        DECLARE_TEST(allCorrect, output);
+
+        nvector<float, 3> u (make_indexer(24, 10, 50), 0.f);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = float(i%97)*0.25f;
+        }
+
+        auto ovfl = std::make_tuple(overflow_behaviour::stretch(), overflow_behaviour::stretch());
+
+        //interpolate at 2.3 along axis 2, then 17.6 along axis 0
+        auto ref = interpolate<KernT>(u, make_vecarray(2.3f, 17.6f), make_vecarray(size_t(2), size_t(0)), ovfl);
+        auto res = interpolate<KernT>(
+                    u,
+                    make_vecarray(2.3f, 17.6f),
+                    make_vecarray(size_t(2), size_t(0)),
+                    ovfl,
+                    parallel_policy().with_chunk_size(8)
+                    );
+
+        allCorrect = ref.get_shape().size() == 1 and ref.get_shape()[0] == 10 and res.get_shape()[0] == 10;
+
+        for (size_t i = 0; i < ref.size(); ++i) {
+            //the kernels are exact at integer positions along the kept axis
+            float expected = interpolate<KernT, overflow_behaviour::stretch>(
+                        u,
+                        make_vecarray(17.6f, float(i), 2.3f)
+                        );
+
+            if (fabs(ref[i] - expected) > 1e-4f*(1.f+fabs(expected))
+                    or fabs(res[i] - expected) > 1e-4f*(1.f+fabs(expected))) {
+                allCorrect = false;
+            }
+            output.append(MakeString() << expected << ": " << ref[i] << " " << res[i] << ", ");
+        }
+
+        RETURN_TESTRESULT(allCorrect, output)
+    }
+
     static
     test_result run_all_tests() {
 
@@ -418,6 +462,7 @@ struct TestSuite {
         RUN_TEST(simple_equalities_1D()         , success_bool, msg);
         RUN_TEST(constant_field_3D()            , success_bool, msg);
         RUN_TEST(cyclic_equal_3D()              , success_bool, msg);
+        RUN_TEST(partial_axes_parallel_3D()     , success_bool, msg);
 
         //Macros dont like multiple template arguments (sad)
         //wrapping the call in a lambda as a workaround
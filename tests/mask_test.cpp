@@ -0,0 +1,149 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/mask.hpp"
+
+#include "tests/test_helpers.hpp"
+
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+using namespace ndata::test_helpers;
+
+struct TestSuite {
+
+    static
+    test_result
+    masks() {
+        DECLARE_TEST(success, msg);
+
+        auto u = make_cycling_input(13, 37, -10l);
+        auto positive = make_nmask(std::tie(u), [] (long x) {return x > 0;});
+
+        bool ok = positive.get_shape()[0] == 13 and positive.get_shape()[1] == 37 and positive.nwords() == 8;
+        long count = 0;
+        for (long i = 0; i < 13; ++i) {
+            for (long j = 0; j < 37; ++j) {
+                ok = ok and positive(i, j) == (u(i, j) > 0);
+                count += u(i, j) > 0;
+            }
+        }
+        ok = ok and positive.count() == count;
+        for (auto & policy: small_chunk_policies()) {
+            auto p = make_nmask(policy, std::tie(u), [] (long x) {return x > 0;});
+            ok = ok and p.words_ == positive.words_;
+        }
+        msg.append(MakeString() << "make_nmask: " << ok << "\n");
+        success = success and ok;
+
+        //the bits past the last element stay 0
+        auto negative = ~positive;
+        auto small = make_nmask(std::tie(u), [] (long x) {return x < -5;});
+        ok = negative.count() == long(u.size())-count
+                and (negative & positive).count() == 0
+                and (negative | positive).count() == long(u.size())
+                and (small & negative).count() == small.count()
+                and (small ^ negative).count() == negative.count()-small.count()
+                and nmask<2>(make_vecarray(3l, 5l), true).count() == 15;
+        negative.set(make_vecarray(2l, 36l), false);
+        ok = ok and not negative(2, 36) and negative.count() == long(u.size())-count-(u(2, 36) <= 0);
+        msg.append(MakeString() << "logical operators: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    masked_operations() {
+        DECLARE_TEST(success, msg);
+
+        auto u = make_cycling_input(40, 23, -10l);
+        auto positive = make_nmask(std::tie(u), [] (long x) {return x > 0;});
+
+        //a strided view and a broadcasted row
+        auto ev = u.slice(range(0, 40, 2), range());
+        nvector<long, 2> row (make_indexer(1, 23), 0l);
+        for (long j = 0; j < 23; ++j) {
+            row(0, j) = 100+j;
+        }
+        auto ev_mask = make_nmask(std::tie(ev), [] (long x) {return x%3 == 0;});
+
+        auto w = where(ev_mask, ev, row);
+        auto zero = make_nvector(0l);
+        auto clipped = where(positive, u, zero);
+        bool ok = true;
+        for (long i = 0; i < 40; ++i) {
+            for (long j = 0; j < 23; ++j) {
+                ok = ok and clipped(i, j) == std::max(u(i, j), 0l);
+                if (i < 20) {
+                    ok = ok and w(i, j) == ((ev(i, j)%3 == 0)? ev(i, j) : 100+j);
+                }
+            }
+        }
+        for (auto & policy: small_chunk_policies()) {
+            ok = ok and where(policy, positive, u, zero).data_ == clipped.data_;
+        }
+        msg.append(MakeString() << "where: " << ok << "\n");
+        success = success and ok;
+
+        //sparse mask: whole words are skipped
+        nmask<2> sparse (u.get_shape());
+        sparse.set(make_vecarray(0l, 0l));
+        sparse.set(make_vecarray(11l, 7l));
+        sparse.set(make_vecarray(39l, 22l));
+        long sum = 0;
+        nforeach_masked(sparse, std::tie(u), [&sum] (long x) {sum += x;});
+        ok = sum == u(0, 0)+u(11, 7)+u(39, 22);
+
+        nvector<long, 2> marked (u.get_shape(), 0l);
+        nforeach_masked(parallel_policy().with_chunk_size(5), positive, std::tie(marked, u), [] (long & m, long x) {m = x;});
+        ok = ok and marked.data_ == clipped.data_;
+        msg.append(MakeString() << "nforeach_masked: " << ok << "\n");
+        success = success and ok;
+
+        vector<long> ref;
+        for (long i = 0; i < 20; ++i) {
+            for (long j = 0; j < 23; ++j) {
+                if (ev(i, j)%3 == 0) {
+                    ref.push_back(ev(i, j));
+                }
+            }
+        }
+        auto c = compress(ev_mask, ev);
+        ok = c.data_ == ref and compress(sparse, u).data_ == vector<long>({u(0, 0), u(11, 7), u(39, 22)});
+        for (auto & policy: small_chunk_policies()) {
+            ok = ok and compress(policy, ev_mask, ev).data_ == ref;
+            ok = ok and compress(policy, positive, u).size() == size_t(positive.count());
+        }
+        nmask<2> empty (u.get_shape());
+        ok = ok and compress(parallel_policy(), empty, u).size() == 0;
+        msg.append(MakeString() << "compress: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(masks(), success_bool, msg);
+        RUN_TEST(masked_operations(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
@@ -0,0 +1,252 @@
+#include "ndata.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+
+/**
+ * Compares nforeach to hand written nested loops on contiguous float arrays of 1 to 6 dimensions,
+ * all of them containing the same number of elements. Run a release build, timings of a debug
+ * build are meaningless.
+ */
+
+const size_t NREPEAT = 10;
+
+template <typename FuncT>
+double
+time_ms(FuncT func) {
+    //warm up
+    func();
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < NREPEAT; ++i) {
+        func();
+    }
+    auto stop = chrono::steady_clock::now();
+
+    return chrono::duration<double, milli>(stop-start).count()/NREPEAT;
+}
+
+inline
+void
+kernel(float & a, float b, float c) {
+    a = b*c+a;
+}
+
+//hand written loops, one per dimensionality
+
+void
+hand_loop(vecarray<long, 1> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        kernel(a[i0], b[i0], c[i0]);
+    }
+}
+
+void
+hand_loop(vecarray<long, 2> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        for (long i1 = 0; i1 < s[1]; ++i1) {
+            long i = i0*s[1]+i1;
+            kernel(a[i], b[i], c[i]);
+        }
+    }
+}
+
+void
+hand_loop(vecarray<long, 3> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        for (long i1 = 0; i1 < s[1]; ++i1) {
+            for (long i2 = 0; i2 < s[2]; ++i2) {
+                long i = (i0*s[1]+i1)*s[2]+i2;
+                kernel(a[i], b[i], c[i]);
+            }
+        }
+    }
+}
+
+void
+hand_loop(vecarray<long, 4> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        for (long i1 = 0; i1 < s[1]; ++i1) {
+            for (long i2 = 0; i2 < s[2]; ++i2) {
+                for (long i3 = 0; i3 < s[3]; ++i3) {
+                    long i = ((i0*s[1]+i1)*s[2]+i2)*s[3]+i3;
+                    kernel(a[i], b[i], c[i]);
+                }
+            }
+        }
+    }
+}
+
+void
+hand_loop(vecarray<long, 5> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        for (long i1 = 0; i1 < s[1]; ++i1) {
+            for (long i2 = 0; i2 < s[2]; ++i2) {
+                for (long i3 = 0; i3 < s[3]; ++i3) {
+                    for (long i4 = 0; i4 < s[4]; ++i4) {
+                        long i = (((i0*s[1]+i1)*s[2]+i2)*s[3]+i3)*s[4]+i4;
+                        kernel(a[i], b[i], c[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+hand_loop(vecarray<long, 6> s, float * a, float * b, float * c) {
+    for (long i0 = 0; i0 < s[0]; ++i0) {
+        for (long i1 = 0; i1 < s[1]; ++i1) {
+            for (long i2 = 0; i2 < s[2]; ++i2) {
+                for (long i3 = 0; i3 < s[3]; ++i3) {
+                    for (long i4 = 0; i4 < s[4]; ++i4) {
+                        for (long i5 = 0; i5 < s[5]; ++i5) {
+                            long i = ((((i0*s[1]+i1)*s[2]+i2)*s[3]+i3)*s[4]+i4)*s[5]+i5;
+                            kernel(a[i], b[i], c[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <long ndims>
+void
+run_benchmark(indexer<ndims> ind) {
+    auto a = make_nvector<float>(ind, 0.f);
+    auto b = make_nvector<float>(ind, 1.f);
+    auto c = make_nvector<float>(ind, 2.f);
+
+    double t_hand = time_ms([&] () {
+        hand_loop(ind.get_shape(), &a.data_[0], &b.data_[0], &c.data_[0]);
+    });
+
+    double t_nforeach = time_ms([&] () {
+        nforeach(
+            std::tie(a, b, c),
+            [] (float & va, float vb, float vc) {
+                kernel(va, vb, vc);
+            });
+    });
+
+    cout << ndims << "D, " << ind.size() << " elements: "
+         << "hand written " << t_hand << " ms, "
+         << "nforeach " << t_nforeach << " ms, "
+         << "ratio " << t_nforeach/t_hand << endl;
+}
+
+/**
+ * Many small blocks: nforeach redoes the broadcasting and loop planning for each block, a loop_plan
+ * only once.
+ */
+void
+run_blocks_benchmark(long nblocks) {
+    vector<nvector<float, 3>> a, b, c;
+    for (long i = 0; i < nblocks; ++i) {
+        a.push_back(make_nvector<float>(make_indexer(8, 8, 8), 0.f));
+        b.push_back(make_nvector<float>(make_indexer(8, 8, 8), 1.f));
+        c.push_back(make_nvector<float>(make_indexer(8, 8, 8), 2.f));
+    }
+    auto func = [] (float & va, float vb, float vc) {
+        kernel(va, vb, vc);
+    };
+
+    double t_nforeach = time_ms([&] () {
+        for (long i = 0; i < nblocks; ++i) {
+            nforeach(std::tie(a[i], b[i], c[i]), func);
+        }
+    });
+
+    auto plan = make_loop_plan(std::tie(a[0], b[0], c[0]));
+    double t_plan = time_ms([&] () {
+        for (long i = 0; i < nblocks; ++i) {
+            plan.run(std::make_tuple(&a[i].data_[0], &b[i].data_[0], &c[i].data_[0]), func);
+        }
+    });
+
+    cout << nblocks << " blocks of 8x8x8: "
+         << "nforeach " << t_nforeach << " ms, "
+         << "loop_plan " << t_plan << " ms, "
+         << "ratio " << t_plan/t_nforeach << endl;
+}
+
+/**
+ * Transposed copy, traversed in tiles by nforeach, compared to a memcpy of the same size.
+ */
+void
+run_transpose_benchmark(long n) {
+    auto a = make_nvector<float>(make_indexer(n, n), 0.f);
+    auto b = make_nvector<float>(make_indexer(n, n), 1.f);
+    auto bt = b.reshape(make_vecarray(n, n), make_vecarray(1l, n));
+
+    double t_memcpy = time_ms([&] () {
+        std::memcpy(&a.data_[0], &b.data_[0], a.size()*sizeof(float));
+    });
+
+    double t_transpose = time_ms([&] () {
+        a.assign(bt);
+    });
+
+    cout << "transposition " << n << "x" << n << ": "
+         << "memcpy " << t_memcpy << " ms, "
+         << "assign " << t_transpose << " ms, "
+         << "ratio " << t_transpose/t_memcpy << endl;
+}
+
+/**
+ * assign between Fortran ordered views (strides (1, n)) and to a C ordered one, compared to a memcpy of the
+ * same size: F to F has no contiguous innermost dimension in C order either, both go through nforeach.
+ */
+void
+run_fortran_copy_benchmark(long n) {
+    auto a = make_nvector<float>(make_indexer(n, n), 0.f);
+    auto b = make_nvector<float>(make_indexer(n, n), 1.f);
+    auto af = a.reshape(make_vecarray(n, n), make_vecarray(1l, n));
+    auto bf = b.reshape(make_vecarray(n, n), make_vecarray(1l, n));
+
+    double t_memcpy = time_ms([&] () {
+        std::memcpy(&a.data_[0], &b.data_[0], a.size()*sizeof(float));
+    });
+
+    double t_f_to_f = time_ms([&] () {
+        af.assign(bf);
+    });
+
+    double t_f_to_c = time_ms([&] () {
+        a.assign(bf);
+    });
+
+    cout << "Fortran copies " << n << "x" << n << ": "
+         << "memcpy " << t_memcpy << " ms, "
+         << "F to F " << t_f_to_f << " ms, "
+         << "F to C " << t_f_to_c << " ms, "
+         << "ratios " << t_f_to_f/t_memcpy << " " << t_f_to_c/t_memcpy << endl;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    //2^24 elements for every dimensionality
+    run_benchmark(make_indexer(1l << 24));
+    run_benchmark(make_indexer(1l << 12, 1l << 12));
+    run_benchmark(make_indexer(1l << 8, 1l << 8, 1l << 8));
+    run_benchmark(make_indexer(1l << 6, 1l << 6, 1l << 6, 1l << 6));
+    run_benchmark(make_indexer(1l << 5, 1l << 5, 1l << 5, 1l << 5, 1l << 4));
+    run_benchmark(make_indexer(1l << 4, 1l << 4, 1l << 4, 1l << 4, 1l << 4, 1l << 4));
+
+    //tiny innermost extents
+    run_benchmark(make_indexer(1l << 10, 1l << 11, 2l, 2l, 2l));
+    run_benchmark(make_indexer(1l << 8, 1l << 8, 1l << 4, 2l, 2l, 1l << 2));
+
+    run_blocks_benchmark(4096);
+
+    run_transpose_benchmark(4096);
+    run_fortran_copy_benchmark(4096);
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/flat_walk.hpp"
+#include "ndata/algorithm/padded_view.hpp"
+#include "ndata/algorithm/stencil.hpp"
+
+#include "tests/test_helpers.hpp"
+
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+using namespace ndata::test_helpers;
+using namespace ndata::interp;
+
+struct TestSuite {
+
+    //reference index along an axis of size n, -1 for a zero
+    static
+    long
+    cyclic_index(long i, long n) {
+        return ((i%n)+n)%n;
+    }
+
+    static
+    long
+    stretch_index(long i, long n) {
+        return std::min(std::max(i, 0l), n-1);
+    }
+
+    static
+    long
+    zero_index(long i, long n) {
+        return (i >= 0 and i < n)? i : -1;
+    }
+
+    static
+    test_result
+    padded_copies() {
+        DECLARE_TEST(success, msg);
+
+        const long n0 = 5, n1 = 7;
+        auto u = make_cycling_input(n0, n1, 1l);
+
+        auto check = [&] (auto padded, long pb0, long pb1, auto index0, auto index1) {
+            auto shape = padded.get_shape();
+            nvector<long, 2> out (indexer<2>(shape), -100l);
+            padded.copy_to(out);
+            nvector<long, 2> out_par (indexer<2>(shape), -100l);
+            padded.copy_to(parallel_policy().with_min_work(1), out_par);
+
+            bool ok = out.data_ == out_par.data_;
+            for (long i = 0; i < shape[0]; ++i) {
+                for (long j = 0; j < shape[1]; ++j) {
+                    long is = index0(i-pb0, n0), js = index1(j-pb1, n1);
+                    long expected = (is < 0 or js < 0)? 0l : u(is, js);
+                    ok = ok and out(i, j) == expected and padded(i, j) == expected;
+                }
+            }
+            return ok;
+        };
+
+        auto cs = make_padded_view(u, make_vecarray(2l, 3l), make_tuple(overflow_behaviour::cyclic(), overflow_behaviour::stretch()));
+        bool ok = cs.get_shape()[0] == n0+4 and cs.get_shape()[1] == n1+6;
+        ok = ok and check(cs, 2, 3, cyclic_index, stretch_index);
+        msg.append(MakeString() << "cyclic, stretch: " << ok << "\n");
+        success = success and ok;
+
+        //padding wider than the array, different before and after
+        auto zc = make_padded_view(u, make_vecarray(1l, 9l), make_vecarray(4l, 12l), make_tuple(overflow_behaviour::zero(), overflow_behaviour::cyclic()));
+        ok = check(zc, 1, 9, zero_index, cyclic_index);
+        msg.append(MakeString() << "zero, wide cyclic: " << ok << "\n");
+        success = success and ok;
+
+        //the interior is a single block on the source, the rest are thin border blocks
+        long nblocks = 0;
+        bool interior_found = false;
+        cs.for_each_block([&] (vecarray<long, 2> begin, ndataview<long, 2> block) {
+            ++nblocks;
+            if (begin[0] == 2 and begin[1] == 3) {
+                interior_found = block.get_shape()[0] == n0 and block.get_shape()[1] == n1 and &block(0, 0) == &u(0, 0);
+            }
+        });
+        ok = nblocks == 9 and interior_found;
+        msg.append(MakeString() << "blocks: " << ok << "\n");
+        success = success and ok;
+
+        //window: a region straddling a corner
+        auto w = cs.window(make_vecarray(1l, 6l), make_vecarray(6l, 7l));
+        nvector<long, 2> wout (make_indexer(6, 7), -1l);
+        w.copy_to(wout);
+        ok = true;
+        for (long i = 0; i < 6; ++i) {
+            for (long j = 0; j < 7; ++j) {
+                ok = ok and wout(i, j) == cs(i+1, j+6) and w(i, j) == cs(i+1, j+6);
+            }
+        }
+        msg.append(MakeString() << "window: " << ok << "\n");
+        success = success and ok;
+
+        //padding of a strided view
+        auto every_other = u.slice(range(), range(0, 7, 2));
+        auto pv = make_padded_view(every_other, make_vecarray(1l, 2l), make_tuple(overflow_behaviour::stretch(), overflow_behaviour::cyclic()));
+        ok = pv(0, 0) == u(0, 2) and pv(6, 1) == u(4, 4) and pv(3, 6) == u(2, 2);
+        msg.append(MakeString() << "strided source: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    stencils() {
+        DECLARE_TEST(success, msg);
+
+        //5 points laplacian, the reference reads the padded array through padded_view
+        auto check_laplacian = [&] (long n0, long n1, auto behaviours) {
+            auto u = make_cycling_input(n0, n1, 1l);
+            auto padded = make_padded_view(u, make_vecarray(1l, 1l), behaviours);
+            auto laplacian = [] (long & o, auto const & nb) {
+                o = nb(-1, 0)+nb(1, 0)+nb(0, -1)+nb(0, 1)-4*nb(0, 0);
+            };
+
+            bool ok = true;
+            for (int ipol = 0; ipol < 3; ++ipol) {
+                nvector<long, 2> out (make_indexer(n0, n1), -1000l);
+                if (ipol == 0) {
+                    nforeach_stencil(out, u, make_vecarray(1l, 1l), behaviours, laplacian);
+                } else if (ipol == 1) {
+                    nforeach_stencil(parallel_policy().with_min_work(1), out, u, make_vecarray(1l, 1l), behaviours, laplacian);
+                } else {
+                    nforeach_stencil(parallel_policy().with_schedule(schedule_kind::DYNAMIC).with_min_work(1), out, u, make_vecarray(1l, 1l), behaviours, laplacian);
+                }
+
+                for (long i = 0; i < n0; ++i) {
+                    for (long j = 0; j < n1; ++j) {
+                        long expected = padded(i, j+1)+padded(i+2, j+1)+padded(i+1, j)+padded(i+1, j+2)-4*padded(i+1, j+1);
+                        ok = ok and out(i, j) == expected;
+                    }
+                }
+            }
+            return ok;
+        };
+
+        bool ok = check_laplacian(37, 41, make_tuple(overflow_behaviour::cyclic(), overflow_behaviour::stretch()))
+                and check_laplacian(2, 1, make_tuple(overflow_behaviour::zero(), overflow_behaviour::cyclic()));
+        msg.append(MakeString() << "laplacian: " << ok << "\n");
+        success = success and ok;
+
+        //box sums of radius (2, 1, 0) on a strided 3D view, into a differently typed output
+        nvector<long, 3> v (make_indexer(9, 12, 4), 0l);
+        for (size_t i = 0; i < v.size(); ++i) {
+            v[i] = long(i%11);
+        }
+        auto vs = v.slice(range(), range(0, 12, 2), range());
+        auto behaviours = make_tuple(overflow_behaviour::zero(), overflow_behaviour::cyclic(), overflow_behaviour::stretch());
+        auto pv = make_padded_view(vs, make_vecarray(2l, 1l, 0l), behaviours);
+        nvector<double, 3> box (indexer<3>(vs.get_shape()), 0.);
+        nforeach_stencil(parallel_policy(), box, vs, make_vecarray(2l, 1l, 0l), behaviours, [] (double & o, auto const & nb) {
+            long sum = 0;
+            for (long di = -2; di <= 2; ++di) {
+                for (long dj = -1; dj <= 1; ++dj) {
+                    sum += nb(di, dj, 0);
+                }
+            }
+            o = double(sum);
+        });
+        ok = true;
+        for (long i = 0; i < 9; ++i) {
+            for (long j = 0; j < 6; ++j) {
+                for (long k = 0; k < 4; ++k) {
+                    long sum = 0;
+                    for (long di = 0; di <= 4; ++di) {
+                        for (long dj = 0; dj <= 2; ++dj) {
+                            sum += pv(i+di, j+dj, k);
+                        }
+                    }
+                    ok = ok and box(i, j, k) == double(sum);
+                }
+            }
+        }
+        msg.append(MakeString() << "box sums: " << ok << "\n");
+        success = success and ok;
+
+        //a column broadcasted along axis 1 (zero stride), against its dense copy
+        nvector<long, 2> col (make_indexer(11, 1), 0l);
+        for (long i = 0; i < 11; ++i) {
+            col(i, 0) = i*i-3*i;
+        }
+        auto bcast = std::get<0>(helpers::broadcast_to_shape(make_indexer(11, 9), std::tie(col)));
+        nvector<long, 2> dense (make_indexer(11, 9), 0l);
+        dense.assign(bcast);
+        auto cross_behaviours = make_tuple(overflow_behaviour::cyclic(), overflow_behaviour::zero());
+        auto cross = [] (long & o, auto const & nb) {
+            o = 2*nb(-1, 0)+3*nb(1, 0)+5*nb(0, -1)+7*nb(0, 1)-nb(0, 0);
+        };
+        nvector<long, 2> from_bcast (make_indexer(11, 9), -1000l);
+        nvector<long, 2> from_dense (make_indexer(11, 9), -1000l);
+        nforeach_stencil(parallel_policy().with_min_work(1), from_bcast, bcast, make_vecarray(1l, 1l), cross_behaviours, cross);
+        nforeach_stencil(from_dense, dense, make_vecarray(1l, 1l), cross_behaviours, cross);
+        ok = from_bcast.data_ == from_dense.data_;
+        msg.append(MakeString() << "broadcasted input: " << ok << "\n");
+        success = success and ok;
+
+        //a transposed input, against its C order copy
+        auto wide = make_cycling_input(23, 17, 1l);
+        auto transposed = wide.transpose();
+        nvector<long, 2> transposed_copy (make_indexer(17, 23), 0l);
+        transposed_copy.assign(transposed);
+        nvector<long, 2> from_transposed (make_indexer(17, 23), -1000l);
+        nvector<long, 2> from_copy (make_indexer(17, 23), -1000l);
+        nforeach_stencil(parallel_policy().with_min_work(1), from_transposed, transposed, make_vecarray(1l, 1l), cross_behaviours, cross);
+        nforeach_stencil(from_copy, transposed_copy, make_vecarray(1l, 1l), cross_behaviours, cross);
+        ok = from_transposed.data_ == from_copy.data_;
+        msg.append(MakeString() << "transposed input: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(padded_copies(), success_bool, msg);
+        RUN_TEST(stencils(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
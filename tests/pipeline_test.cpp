@@ -0,0 +1,272 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/pipeline.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+
+struct TestSuite {
+
+    static
+    nvector<double, 2>
+    make_input(long n0, long n1, long seed) {
+        nvector<double, 2> u (make_indexer(n0, n1), 0.);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = double((long(i)*seed)%29)-14.;
+        }
+        return u;
+    }
+
+    static
+    vector<parallel_policy>
+    policies() {
+        return {
+            parallel_policy(),
+            parallel_policy().with_schedule(schedule_kind::DYNAMIC),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_threads(2)
+        };
+    }
+
+    static
+    test_result
+    fused_steps() {
+        DECLARE_TEST(success, msg);
+
+        const long n0 = 37, n1 = 53;
+        auto a = make_input(n0, n1, 7);
+        auto b = make_input(n0, n1, 11);
+        auto coef = make_nvector<double>(make_indexer(n1));
+        for (long j = 0; j < n1; ++j) {
+            coef(j) = 0.5*double(j%5);
+        }
+
+        //reference, one loop at a time
+        auto t1_ref = ntransform<double>(std::tie(a, b), [] (double x, double y) {return x*y;});
+        auto t2_ref = ntransform<double>(std::tie(t1_ref, coef), [] (double t, double c) {return t+c;});
+        auto out_ref = ntransform<double>(std::tie(t2_ref, a), [] (double t, double x) {return t-x;});
+        double sum_ref = nreduce(serial_policy(), std::tie(t2_ref), 0., [] (double & acc, double t) {acc += t;});
+
+        auto check = [&] (auto const & policy, long tile_size) {
+            auto out = make_nvector<double>(make_indexer(n0, n1));
+            auto neg = make_nvector<double>(make_indexer(n0, n1));
+            double sum = -1.;
+
+            npipeline<2> p (make_indexer(n0, n1), tile_size);
+            auto t1 = p.temporary<double>();
+            auto t2 = p.temporary<double>();
+            p.transform(t1, std::tie(a, b), [] (double x, double y) {return x*y;});
+            p.transform(t2, std::tie(t1, coef), [] (double t, double c) {return t+c;});
+            p.transform(std::tie(out, neg), std::tie(t2, a), [] (double t, double x) {
+                return std::make_tuple(t-x, -t);
+            });
+            p.reduce(std::tie(t2), sum, 0., [] (double & acc, double t) {acc += t;}, [] (double x, double y) {return x+y;});
+
+            bool ok = p.num_stages() == 1;
+            p.run(policy);
+            ok = ok and out.data_ == out_ref.data_ and std::fabs(sum-sum_ref) < 1e-9;
+            for (size_t i = 0; i < neg.size(); ++i) {
+                ok = ok and neg[i] == -t2_ref[i];
+            }
+
+            //can be run again
+            nforeach(std::tie(out), [] (double & v) {v = 0.;});
+            p.run(policy);
+            ok = ok and out.data_ == out_ref.data_;
+            return ok;
+        };
+
+        for (long tile_size : {1l, 100l, 8192l}) {
+            success = success and check(serial_policy(), tile_size);
+            for (auto const & policy : policies()) {
+                success = success and check(policy, tile_size);
+            }
+        }
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    stages() {
+        DECLARE_TEST(success, msg);
+
+        const long n = 1000;
+        auto u = make_nvector<long>(make_indexer(n));
+        for (long i = 0; i < n; ++i) {
+            u(i) = i%17;
+        }
+        auto v = make_nvector<long>(make_indexer(n-1));
+        auto w = make_nvector<long>(make_indexer(n-1));
+
+        auto check = [&] (auto const & policy) {
+            auto x = make_nvector<long>(make_indexer(n));
+            long total = 0;
+
+            npipeline<1> p (make_indexer(n-1), 64);
+            auto sq = p.temporary<long>();
+            auto x_head = x.slice(range(0, n-1));
+            auto x_tail = x.slice(range(1, n));
+            auto u_head = u.slice(range(0, n-1));
+            p.transform(x_head, std::tie(u_head), [] (long a) {return 2*a;});
+            p.transform(sq, std::tie(u_head), [] (long a) {return a*a;});
+            //reads x shifted by one: needs the whole of x_head first
+            p.transform(v, std::tie(x_tail, sq), [] (long a, long s) {return a+s;});
+            p.reduce(std::tie(v), total, 0l, [] (long & acc, long a) {acc += a;}, [] (long a, long b) {return a+b;});
+            p.sync();
+            p.transform(w, std::tie(v), [&total] (long a) {return total-a;});
+
+            bool ok = p.num_stages() == 3;
+            p.run(policy);
+
+            long total_ref = 0;
+            for (long i = 0; i < n-1; ++i) {
+                long v_ref = ((i+1 < n-1)? 2*u(i+1) : 0) + u(i)*u(i);
+                ok = ok and v(i) == v_ref;
+                total_ref += v_ref;
+            }
+            ok = ok and total == total_ref;
+            for (long i = 0; i < n-1; ++i) {
+                ok = ok and w(i) == total_ref-v(i);
+            }
+            return ok;
+        };
+
+        success = success and check(serial_policy());
+        for (auto const & policy : policies()) {
+            success = success and check(policy);
+        }
+
+        //outputs must have the shape of the grid
+        bool thrown = false;
+        try {
+            auto small = make_nvector<long>(make_indexer(1));
+            npipeline<1> p (make_indexer(n));
+            p.transform(small, std::tie(u), [] (long a) {return a;});
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        success = success and thrown;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    slab_tiles() {
+        DECLARE_TEST(success, msg);
+
+        //tiles within a slab of the first axis, within a row and spanning several slabs
+        const long n0 = 3, n1 = 10, n2 = 14;
+        nvector<double, 3> a (make_indexer(n0, n1, n2), 0.);
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = double((long(i)*13)%23)-11.;
+        }
+        auto b = make_nvector<double>(make_indexer(n2));
+        for (long k = 0; k < n2; ++k) {
+            b(k) = 0.25*double(k);
+        }
+        auto flipped = a.flip();
+
+        auto check = [&] (auto const & policy, long tile_size) {
+            nvector<double, 3> out (make_indexer(n0, n1, n2), 0.);
+            nvector<double, 3> out2 (make_indexer(n0, n1, n2), 0.);
+            double sum = 0.;
+
+            npipeline<3> p (make_indexer(n0, n1, n2), tile_size);
+            auto t = p.temporary<double>();
+            auto s = p.temporary<double>();
+            p.transform(t, std::tie(a, b), [] (double x, double y) {return x*y;});
+            p.transform(s, std::tie(flipped), [] (double x) {return -x;});
+            p.transform(out, std::tie(t, s), [] (double x, double y) {return x+y;});
+            p.reduce(std::tie(t), sum, 0., [] (double & acc, double x) {acc += x;}, [] (double x, double y) {return x+y;});
+            p.sync();
+            //t is used by two stages, it spans the grid
+            p.transform(out2, std::tie(t, out), [] (double x, double o) {return o-x;});
+            p.run(policy);
+
+            bool ok = p.num_stages() == 2;
+            double sum_ref = 0.;
+            for (long i = 0; i < n0; ++i) {
+                for (long j = 0; j < n1; ++j) {
+                    for (long k = 0; k < n2; ++k) {
+                        double t_ref = a(i, j, k)*b(k);
+                        sum_ref += t_ref;
+                        ok = ok and out(i, j, k) == t_ref-a(n0-1-i, n1-1-j, n2-1-k)
+                                and out2(i, j, k) == -a(n0-1-i, n1-1-j, n2-1-k);
+                    }
+                }
+            }
+            return ok and std::fabs(sum-sum_ref) < 1e-9;
+        };
+
+        for (long tile_size : {1l, 5l, 30l, 140l, 300l, 10000l}) {
+            bool ok = check(serial_policy(), tile_size);
+            for (auto const & policy : policies()) {
+                ok = ok and check(policy, tile_size);
+            }
+            msg.append(MakeString() << "tile size " << tile_size << ": " << ok << "\n");
+            success = success and ok;
+        }
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    empty_grid() {
+        DECLARE_TEST(success, msg);
+
+        //an empty inner axis, the reduction still writes its identity
+        auto a = make_input(4, 0, 7);
+        auto out = make_nvector<double>(make_indexer(4l, 0l));
+
+        auto check = [&] (auto const & policy) {
+            double sum = -1.;
+            npipeline<2> p (make_indexer(4l, 0l), 16);
+            auto t = p.temporary<double>();
+            p.transform(t, std::tie(a), [] (double x) {return 2.*x;});
+            p.transform(out, std::tie(t), [] (double x) {return x+1.;});
+            p.reduce(std::tie(t), sum, 0., [] (double & acc, double x) {acc += x;}, [] (double x, double y) {return x+y;});
+            p.run(policy);
+            return sum == 0.;
+        };
+
+        bool ok = check(serial_policy());
+        for (auto const & policy : policies()) {
+            ok = ok and check(policy);
+        }
+        msg.append(MakeString() << "empty grid: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(fused_steps(), success_bool, msg);
+        RUN_TEST(stages(), success_bool, msg);
+        RUN_TEST(slab_tiles(), success_bool, msg);
+        RUN_TEST(empty_grid(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
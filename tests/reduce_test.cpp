@@ -0,0 +1,451 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/algorithm/reduce.hpp"
+#include "ndata/algorithm/scan.hpp"
+#include "ndata/algorithm/rolling.hpp"
+
+#include "tests/test_helpers.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace ndata;
+using namespace ndata::test_helpers;
+
+struct TestSuite {
+
+    //values with plenty of ties
+    static
+    nvector<long, 3>
+    make_input(long n0, long n1, long n2) {
+        nvector<long, 3> u (make_indexer(n0, n1, n2), 0l);
+        for (long i = 0; i < n0; ++i) {
+            for (long j = 0; j < n1; ++j) {
+                for (long k = 0; k < n2; ++k) {
+                    u.data_[u.index(i, j, k)] = (i*31+j*17+k*7)%23 - 11;
+                }
+            }
+        }
+        return u;
+    }
+
+    static
+    vector<parallel_policy>
+    policies() {
+        auto ret = small_chunk_policies();
+        ret.push_back(parallel_policy().with_schedule(schedule_kind::DYNAMIC).with_chunk_size(64));
+        ret.push_back(parallel_policy().with_backend(parallel_backend::THREAD_POOL));
+        return ret;
+    }
+
+    template <long ndims>
+    static
+    bool
+    same_shape(vecarray<long, ndims> a, vecarray<long, ndims> b) {
+        bool ret = a.size() == b.size();
+        for (size_t i = 0; ret and i < a.size(); ++i) {
+            ret = a[i] == b[i];
+        }
+        return ret;
+    }
+
+    template <typename ContainerT1, typename ContainerT2, typename T, long ndims>
+    static
+    bool
+    same(ndatacontainer<ContainerT1, T, ndims> a, ndatacontainer<ContainerT2, T, ndims> b) {
+        bool ret = same_shape(a.get_shape(), b.get_shape());
+        nforeach(std::tie(a, b), [&ret] (T va, T vb) {
+            ret = ret and va == vb;
+        });
+        return ret;
+    }
+
+    static
+    test_result
+    sum_min_max() {
+        DECLARE_TEST(success, msg);
+
+        //the first shapes split a kept axis between the threads, the last one a reduced axis
+        vector<vecarray<long, 3>> shapes = {
+            make_vecarray(7l, 40l, 33l),
+            make_vecarray(2l, 1l, 301l),
+        };
+
+        for (auto shape: shapes) {
+            auto u = make_input(shape[0], shape[1], shape[2]);
+
+            //reference along the middle and last axes
+            nvector<long, 1> sum_ref (make_indexer(shape[0]), 0l);
+            nvector<long, 1> min_ref (make_indexer(shape[0]), numeric_limits<long>::max());
+            nvector<long, 2> max_ref (make_indexer(shape[1], shape[2]), numeric_limits<long>::lowest());
+            for (long i = 0; i < shape[0]; ++i) {
+                for (long j = 0; j < shape[1]; ++j) {
+                    for (long k = 0; k < shape[2]; ++k) {
+                        long v = u.data_[u.index(i, j, k)];
+                        sum_ref.data_[i] += v;
+                        min_ref.data_[i] = std::min(min_ref.data_[i], v);
+                        auto & m = max_ref.data_[max_ref.index(j, k)];
+                        m = std::max(m, v);
+                    }
+                }
+            }
+
+            bool serial_ok = same(nsum(u, make_vecarray(1ul, 2ul)), sum_ref)
+                    and same(nmin(u, make_vecarray(2ul, 1ul)), min_ref)
+                    and same(nmax(u, make_vecarray(0ul)), max_ref);
+
+            auto sum_keep = nsum(u, make_vecarray(1ul, 2ul), KEEPDIMS);
+            serial_ok = serial_ok
+                    and same_shape(sum_keep.get_shape(), make_vecarray(shape[0], 1l, 1l))
+                    and sum_keep.data_ == sum_ref.data_;
+
+            msg.append(MakeString() << "serial " << shape[0] << "x" << shape[1] << "x" << shape[2] << ": " << serial_ok << "\n");
+            success = success and serial_ok;
+
+            auto policy_list = policies();
+            for (size_t ipol = 0; ipol < policy_list.size(); ++ipol) {
+                auto policy = policy_list[ipol];
+                bool ok = same(nsum(policy, u, make_vecarray(1ul, 2ul)), sum_ref)
+                        and same(nmin(policy, u, make_vecarray(2ul, 1ul)), min_ref)
+                        and same(nmax(policy, u, make_vecarray(0ul)), max_ref)
+                        and nsum(policy, u, make_vecarray(1ul, 2ul), KEEPDIMS).data_ == sum_ref.data_;
+
+                msg.append(MakeString() << "policy " << ipol << " " << shape[0] << "x" << shape[1] << "x" << shape[2] << ": " << ok << "\n");
+                success = success and ok;
+            }
+        }
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    mean_and_views() {
+        DECLARE_TEST(success, msg);
+
+        nvector<double, 2> u (make_indexer(6l, 500l), 0.);
+        for (long i = 0; i < 6; ++i) {
+            for (long j = 0; j < 500; ++j) {
+                u.data_[u.index(i, j)] = double(i)+(j%2? 0.25 : -0.25);
+            }
+        }
+
+        //on a strided view, every other column: the offsets cancel out
+        auto even = u.slice(range(), range(0, 500, 2));
+        auto odd = u.slice(range(), range(1, 500, 2));
+
+        bool ok = true;
+        for (auto m: {nmean(even, make_vecarray(1ul)), nmean(parallel_policy(), odd, make_vecarray(1ul))}) {
+            ok = ok and same_shape(m.get_shape(), make_vecarray(6l));
+        }
+        auto m_even = nmean(parallel_policy().with_chunk_size(7), even, make_vecarray(1ul));
+        auto m_all = nmean(parallel_policy(), u, make_vecarray(0ul, 1ul));
+        for (long i = 0; i < 6; ++i) {
+            ok = ok and std::fabs(m_even.data_[i] - (double(i)-0.25)) < 1e-12;
+        }
+        ok = ok and std::fabs(m_all.data_[0] - 2.5) < 1e-12;
+
+        //temporary views and const containers
+        auto const & u_const = u;
+        auto m_rows = nmean(u.transpose(), make_vecarray(0ul));
+        auto s_flipped = nsum(u.flip(), make_vecarray(0ul, 1ul));
+        ok = ok and same(m_rows, nmean(u_const, make_vecarray(1ul)))
+                and same(s_flipped, nsum(u_const, make_vecarray(0ul, 1ul)))
+                and same(nargmax(u.slice(range(), range(0, 500, 2)), 1), nargmax(even, 1));
+
+        msg.append(MakeString() << "means: " << ok << "\n");
+        success = success and ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    argmax_argmin() {
+        DECLARE_TEST(success, msg);
+
+        auto u = make_input(5, 257, 3);
+
+        nvector<long, 2> argmax_ref (make_indexer(5l, 3l), 0l);
+        nvector<long, 2> argmin_ref (make_indexer(5l, 3l), 0l);
+        for (long i = 0; i < 5; ++i) {
+            for (long k = 0; k < 3; ++k) {
+                long imax = 0, imin = 0;
+                for (long j = 1; j < 257; ++j) {
+                    long v = u.data_[u.index(i, j, k)];
+                    if (v > u.data_[u.index(i, imax, k)]) {
+                        imax = j;
+                    }
+                    if (v < u.data_[u.index(i, imin, k)]) {
+                        imin = j;
+                    }
+                }
+                argmax_ref.data_[argmax_ref.index(i, k)] = imax;
+                argmin_ref.data_[argmin_ref.index(i, k)] = imin;
+            }
+        }
+
+        bool ok = same(nargmax(u, 1), argmax_ref) and same(nargmin(u, 1), argmin_ref);
+        ok = ok and same_shape(nargmax(u, 1, KEEPDIMS).get_shape(), make_vecarray(5l, 1l, 3l));
+        msg.append(MakeString() << "serial: " << ok << "\n");
+        success = success and ok;
+
+        auto policy_list = policies();
+        for (size_t ipol = 0; ipol < policy_list.size(); ++ipol) {
+            bool pok = same(nargmax(policy_list[ipol], u, 1), argmax_ref)
+                    and same(nargmin(policy_list[ipol], u, 1), argmin_ref);
+            msg.append(MakeString() << "policy " << ipol << ": " << pok << "\n");
+            success = success and pok;
+        }
+
+        //no element to point at along an empty axis
+        auto empty = make_input(5, 0, 3);
+        bool thrown = false;
+        try {
+            nargmax(empty, 1);
+        } catch (std::domain_error const &) {
+            thrown = true;
+        }
+        msg.append(MakeString() << "empty axis throws: " << thrown << "\n");
+        success = success and thrown;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    //associative but not commutative, to check that the blocks are combined in order
+    struct append_digits {
+        string operator()(string const & a, string const & b) const {
+            return a+b;
+        }
+        string operator()(string const & a, long digit) const {
+            return a+char('0'+(digit+11)%10);
+        }
+    };
+
+    static
+    test_result
+    scans() {
+        DECLARE_TEST(success, msg);
+
+        //the first shape splits the lines between the threads, the second one uses the two pass scan
+        vector<vecarray<long, 3>> shapes = {
+            make_vecarray(7l, 40l, 33l),
+            make_vecarray(2l, 3001l, 1l),
+        };
+
+        for (auto shape: shapes) {
+            auto u = make_input(shape[0], shape[1], shape[2]);
+
+            nvector<long, 3> inclusive_ref (make_indexer(shape[0], shape[1], shape[2]), 0l);
+            nvector<long, 3> exclusive_ref (make_indexer(shape[0], shape[1], shape[2]), 0l);
+            nvector<string, 3> digits_ref (make_indexer(shape[0], shape[1], shape[2]), string());
+            for (long i = 0; i < shape[0]; ++i) {
+                for (long k = 0; k < shape[2]; ++k) {
+                    long sum = 0;
+                    string digits;
+                    for (long j = 0; j < shape[1]; ++j) {
+                        long iu = u.index(i, j, k);
+                        exclusive_ref.data_[iu] = sum;
+                        sum += u.data_[iu];
+                        inclusive_ref.data_[iu] = sum;
+                        digits = append_digits()(digits, u.data_[iu]);
+                        digits_ref.data_[iu] = digits;
+                    }
+                }
+            }
+
+            bool serial_ok = same(ncumsum(u, 1), inclusive_ref)
+                    and same(ncumsum(u, 1, scan_mode::EXCLUSIVE), exclusive_ref)
+                    and same(nscan(u, 1, string(), append_digits()), digits_ref);
+
+            //temporary view: the transpose of the reference is scanned along its axis 1 too
+            auto transposed_sum = ncumsum(u.transpose(), 1);
+            serial_ok = serial_ok and same(transposed_sum.transpose(), inclusive_ref.as_view());
+
+            msg.append(MakeString() << "serial " << shape[0] << "x" << shape[1] << "x" << shape[2] << ": " << serial_ok << "\n");
+            success = success and serial_ok;
+
+            auto policy_list = policies();
+            for (size_t ipol = 0; ipol < policy_list.size(); ++ipol) {
+                auto policy = policy_list[ipol];
+                bool ok = same(ncumsum(policy, u, 1), inclusive_ref)
+                        and same(ncumsum(policy, u, 1, scan_mode::EXCLUSIVE), exclusive_ref)
+                        and same(nscan(policy, u, 1, string(), append_digits()), digits_ref);
+
+                msg.append(MakeString() << "policy " << ipol << " " << shape[0] << "x" << shape[1] << "x" << shape[2] << ": " << ok << "\n");
+                success = success and ok;
+            }
+        }
+
+        //along the contiguous axis of a strided view
+        nvector<double, 2> v (make_indexer(4l, 10l), 2.);
+        auto every_third = v.slice(range(), range(0, 10, 3));
+        auto prod = ncumprod(parallel_policy(), every_third, 1);
+        bool prod_ok = true;
+        for (long i = 0; i < prod.get_shape()[0]; ++i) {
+            for (long j = 0; j < prod.get_shape()[1]; ++j) {
+                prod_ok = prod_ok and prod.data_[prod.index(i, j)] == double(1l << (j+1));
+            }
+        }
+        msg.append(MakeString() << "cumprod: " << prod_ok << "\n");
+        success = success and prod_ok;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    rolling_windows() {
+        DECLARE_TEST(success, msg);
+
+        auto u = make_input(7, 40, 33);
+        nvector<double, 3> ud (make_indexer(7, 40, 33), 0.);
+        ud.assign_transform(std::tie(u), [] (long v) {return 0.1*double(v)+1e3;});
+
+        for (size_t axis : {size_t(0), size_t(1), size_t(2)}) {
+            for (long window : {1l, 5l, 7l}) {
+                auto shape = u.get_shape();
+                shape[axis] -= window-1;
+                nvector<long, 3> sum_ref (indexer<3>(shape), 0l);
+                nvector<long, 3> min_ref (indexer<3>(shape), 0l);
+                nvector<long, 3> max_ref (indexer<3>(shape), 0l);
+                nvector<double, 3> var_ref (indexer<3>(shape), 0.);
+
+                //naive O(n*window) reference
+                for (long i = 0; i < shape[0]; ++i) {
+                    for (long j = 0; j < shape[1]; ++j) {
+                        for (long k = 0; k < shape[2]; ++k) {
+                            long sum = 0, mn = numeric_limits<long>::max(), mx = numeric_limits<long>::min();
+                            double mean = 0., m2 = 0.;
+                            for (long l = 0; l < window; ++l) {
+                                vector<long> ind = {i, j, k};
+                                ind[axis] += l;
+                                long v = u(ind[0], ind[1], ind[2]);
+                                sum += v;
+                                mn = std::min(mn, v);
+                                mx = std::max(mx, v);
+                                mean += ud(ind[0], ind[1], ind[2])/double(window);
+                            }
+                            for (long l = 0; l < window; ++l) {
+                                vector<long> ind = {i, j, k};
+                                ind[axis] += l;
+                                double d = ud(ind[0], ind[1], ind[2])-mean;
+                                m2 += d*d;
+                            }
+                            sum_ref(i, j, k) = sum;
+                            min_ref(i, j, k) = mn;
+                            max_ref(i, j, k) = mx;
+                            var_ref(i, j, k) = m2/double(window);
+                        }
+                    }
+                }
+
+                auto close = [] (nvector<double, 3> a, nvector<double, 3> b) {
+                    bool ret = a.size() == b.size();
+                    for (size_t i = 0; ret and i < a.size(); ++i) {
+                        ret = std::fabs(a[i]-b[i]) < 1e-6;
+                    }
+                    return ret;
+                };
+
+                bool ok = same(nrolling_sum(u, axis, window), sum_ref)
+                        and same(nrolling_min(u, axis, window), min_ref)
+                        and same(nrolling_max(u, axis, window), max_ref)
+                        and close(nrolling_var(ud, axis, window), var_ref);
+                for (auto const & policy : policies()) {
+                    ok = ok and same(nrolling_sum(policy, u, axis, window), sum_ref)
+                            and same(nrolling_min(policy, u, axis, window), min_ref)
+                            and same(nrolling_max(policy, u, axis, window), max_ref)
+                            and close(nrolling_var(policy, ud, axis, window), var_ref);
+                }
+
+                msg.append(MakeString() << "axis " << axis << " window " << window << ": " << ok << "\n");
+                success = success and ok;
+            }
+        }
+
+        //whole axis, unbiased variance, strided input
+        nvector<double, 2> v (make_indexer(3, 8), 0.);
+        for (size_t i = 0; i < v.size(); ++i) {
+            v[i] = double(i%8);
+        }
+        auto reversed = v.flip(1);
+        auto mean = nrolling_mean(reversed, 1, 8);
+        auto var1 = nrolling_var(reversed, 1, 8, 1);
+        auto reversed_even = reversed.slice(range(), range(0, 8, 2));
+        auto mx = nrolling_max(reversed_even, 1, 2);
+        bool whole_ok = mean.get_shape()[1] == 1 and mean(2, 0) == 3.5 and std::fabs(var1(1, 0)-6.) < 1e-12
+                and mx.get_shape()[1] == 3 and mx(0, 0) == 7. and mx(0, 2) == 3.;
+        //a single line: its first element alone is a one element loop
+        auto second_row = v.slice(range(1, 2), range());
+        auto row = nrolling_min(second_row, 1, 3);
+        whole_ok = whole_ok and row.get_shape()[1] == 6 and row(0, 0) == 0. and row(0, 5) == 5.;
+        //temporary views
+        whole_ok = whole_ok and same(nrolling_mean(v.flip(1), 1, 8), mean)
+                and same(nrolling_max(v.flip(1).slice(range(), range(0, 8, 2)), 1, 2), mx)
+                and same(nrolling_min(v.transpose(), 0, 3).transpose(), nrolling_min(v, 1, 3).as_view());
+        msg.append(MakeString() << "whole axis: " << whole_ok << "\n");
+        success = success and whole_ok;
+
+        //a column broadcasted along the second axis: stride 0 along it
+        const long nb = 5, mb = 4;
+        nvector<long, 1> col (make_indexer(nb), 0l);
+        for (long i = 0; i < nb; ++i) {
+            col(i) = (i*3)%7;
+        }
+        auto bcast = col.as_view().expand_dims(1).reshape(make_vecarray(nb, mb), make_vecarray(1l, 0l));
+        auto col_max = nrolling_max(bcast, 0, nb);
+        auto line_min = nrolling_min(bcast, 1, 2);
+        bool bcast_ok = col_max.get_shape()[0] == 1 and line_min.get_shape()[1] == mb-1;
+        for (long j = 0; j < mb; ++j) {
+            bcast_ok = bcast_ok and col_max(0, j) == 6;
+        }
+        for (long i = 0; i < nb; ++i) {
+            for (long j = 0; j < mb-1; ++j) {
+                bcast_ok = bcast_ok and line_min(i, j) == col(i);
+            }
+        }
+        msg.append(MakeString() << "broadcasted input: " << bcast_ok << "\n");
+        success = success and bcast_ok;
+
+        bool thrown = false;
+        try {
+            nrolling_sum(v, 1, 9);
+        } catch (std::domain_error &) {
+            thrown = true;
+        }
+        success = success and thrown;
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(sum_min_max(), success_bool, msg);
+        RUN_TEST(mean_and_views(), success_bool, msg);
+        RUN_TEST(argmax_argmin(), success_bool, msg);
+        RUN_TEST(scans(), success_bool, msg);
+        RUN_TEST(rolling_windows(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}
@@ -0,0 +1,42 @@
+/*! \file Inputs and execution policies shared by the tests of the algorithms */
+#ifndef TEST_HELPERS_HPP_K7RW2XQD
+#define TEST_HELPERS_HPP_K7RW2XQD
+
+#include <vector>
+#include "ndata.hpp"
+
+namespace ndata {
+namespace test_helpers {
+
+    /**
+     * @brief 2D input whose elements cycle through 31 values, i*7%31 for the element i in C order, plus
+     *  offset: neighbors differ, and a few thousand elements hold every value many times.
+     */
+    template <typename T>
+    nvector<T, 2>
+    make_cycling_input(long n0, long n1, T offset) {
+        nvector<T, 2> u (make_indexer(n0, n1), offset);
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] += T(i*7%31);
+        }
+        return u;
+    }
+
+    /**
+     * @brief The default parallel policy, small static chunks, and small chunks on two threads of the
+     *  thread pool: the blocks are cut at many places even on small inputs.
+     */
+    inline
+    std::vector<parallel_policy>
+    small_chunk_policies() {
+        return {
+            parallel_policy(),
+            parallel_policy().with_chunk_size(5),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_threads(2).with_chunk_size(3)
+        };
+    }
+
+} //end namespace test_helpers
+} //end namespace ndata
+
+#endif /* end of include guard: TEST_HELPERS_HPP_K7RW2XQD */
@@ -0,0 +1,201 @@
+#include "ndata/debug_helpers.hpp"
+
+#include "ndata.hpp"
+#include "ndata/thread_pool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace ndata;
+
+struct TestSuite {
+
+    static
+    test_result
+    parallel_for_covers_range() {
+        DECLARE_TEST(success, msg);
+
+        thread_pool pool (4, 3);
+
+        long n = 1000;
+        vector<int> hits (n, 0);
+        atomic<long> min_task_size (n);
+
+        pool.parallel_for(n, [&] (long b, long e) {
+            for (long i = b; i < e; ++i) {
+                hits[i]++;
+            }
+            long cur = min_task_size.load();
+            while (e-b < cur and not min_task_size.compare_exchange_weak(cur, e-b)) { }
+        });
+
+        for (long i = 0; i < n; ++i) {
+            success = success and hits[i] == 1;
+        }
+
+        //the grain is respected, except for ranges that can't be split any further
+        success = success and min_task_size.load() >= 2;
+
+        msg.append(MakeString() << "pool size: " << pool.size() << ", smallest task: " << min_task_size.load() << "\n");
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    nested_and_exceptions() {
+        DECLARE_TEST(success, msg);
+
+        thread_pool pool (3);
+
+        //nested calls run serially on the calling thread
+        atomic<long> count (0);
+        pool.parallel_for(10, 1, [&] (long b, long e) {
+            for (long i = b; i < e; ++i) {
+                pool.parallel_for(10, 1, [&] (long b2, long e2) {
+                    count += e2-b2;
+                });
+            }
+        });
+        success = success and count.load() == 100;
+
+        bool thrown = false;
+        try {
+            pool.parallel_for(100, 1, [] (long b, long) {
+                if (b == 0) {
+                    throw std::runtime_error("expected");
+                }
+            });
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        success = success and thrown;
+
+        //still usable after an exception
+        count = 0;
+        pool.parallel_for(50, 1, [&] (long b, long e) {
+            count += e-b;
+        });
+        success = success and count.load() == 50;
+
+        msg.append(MakeString() << "nested count: " << count.load() << ", exception rethrown: " << thrown << "\n");
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    thread_pool_loops() {
+        DECLARE_TEST(success, msg);
+
+        auto u1 = make_nvector<long>(make_indexer(3, 500, 7));
+        for (size_t i = 0; i < u1.size(); ++i) {
+            u1[i] = i;
+        }
+        auto u1_sli = u1.slice(range(), range(0, 500, 2), range());
+
+        auto res_serial = ntransform<long>(make_tuple(u1_sli), [] (long v) {return v*v;});
+        auto res_pool = ntransform<long, THREAD_POOL>(make_tuple(u1_sli), [] (long v) {return v*v;});
+
+        auto res_assign = make_nvector<long>(res_serial.as_indexer());
+        res_assign.assign_transform<THREAD_POOL>(make_tuple(u1_sli), [] (long v) {return v*v;});
+
+        for (size_t i = 0; i < res_serial.size(); ++i) {
+            success = success and res_serial[i] == res_pool[i] and res_serial[i] == res_assign[i];
+        }
+
+        msg.append(MakeString() << "global pool size: " << thread_pool::global().size() << "\n");
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    execution_policies() {
+        DECLARE_TEST(success, msg);
+
+        //participants are capped by max_threads
+        thread_pool pool (4);
+        std::mutex ids_mutex;
+        std::set<std::thread::id> ids;
+        pool.parallel_for(1000, 1, [&] (long, long) {
+            std::lock_guard<std::mutex> lock (ids_mutex);
+            ids.insert(std::this_thread::get_id());
+        }, 2);
+        success = success and ids.size() <= 2;
+
+        auto u1 = make_nvector<long>(make_indexer(5, 300, 9));
+        for (size_t i = 0; i < u1.size(); ++i) {
+            u1[i] = i;
+        }
+        auto u1_sli = u1.slice(range(), range(0, 300, 3), range());
+        auto square = [] (long v) {return v*v;};
+
+        auto ref = ntransform<long>(serial_policy(), make_tuple(u1_sli), square);
+
+        std::vector<parallel_policy> policies {
+            parallel_policy(),
+            parallel_policy().with_threads(2),
+            parallel_policy().with_schedule(schedule_kind::STATIC).with_chunk_size(100),
+            parallel_policy().with_schedule(schedule_kind::DYNAMIC).with_chunk_size(37),
+            parallel_policy().with_schedule(schedule_kind::GUIDED),
+            parallel_policy().with_min_work(1l << 20),
+            parallel_policy().with_affinity(),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_chunk_size(64),
+            parallel_policy().with_backend(parallel_backend::THREAD_POOL).with_threads(2).with_affinity()
+        };
+
+        for (size_t ipol = 0; ipol < policies.size(); ++ipol) {
+            auto res = ntransform<long>(policies[ipol], make_tuple(u1_sli), square);
+
+            auto res_assign = make_nvector<long>(ref.as_indexer());
+            res_assign.assign_transform(policies[ipol], make_tuple(u1_sli), square);
+
+            auto res_copy = make_nvector<long>(ref.as_indexer());
+            res_copy.assign(policies[ipol], res);
+
+            //broadcasted input, every element visited once
+            auto counts = make_nvector<long>(ref.as_indexer(), 0l);
+            auto one = make_nvector<long>(make_indexer(1, 1, 1), 1l);
+            nforeach(policies[ipol], std::tie(counts, one), [] (long & c, long o) {c += o;});
+
+            bool same = true;
+            for (size_t i = 0; i < ref.size(); ++i) {
+                same = same and res[i] == ref[i] and res_assign[i] == ref[i] and res_copy[i] == ref[i] and counts[i] == 1;
+            }
+
+            msg.append(MakeString() << "policy " << ipol << ": " << same << "\n");
+            success = success and same;
+        }
+
+        RETURN_TESTRESULT(success, msg);
+    }
+
+    static
+    test_result
+    run_all_tests () {
+        DECLARE_TEST(success_bool, msg);
+        RUN_TEST(parallel_for_covers_range(), success_bool, msg);
+        RUN_TEST(nested_and_exceptions(), success_bool, msg);
+        RUN_TEST(thread_pool_loops(), success_bool, msg);
+        RUN_TEST(execution_policies(), success_bool, msg);
+        RETURN_TESTRESULT(success_bool, msg);
+    }
+};
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    DECLARE_TEST(success_bool, msg);
+
+    RUN_TEST(TestSuite::run_all_tests()  , success_bool, msg);
+
+    cout<<endl<<msg<<endl;
+
+    cout<<((success_bool)? "All tests succeeded" : "Some tests FAILED")<<endl;
+
+	return (success_bool)? 0 : 1;
+}